@@ -0,0 +1,304 @@
+#include "corpus.h"
+
+#include <stdexcept>
+
+namespace {
+
+// splitmix64: в отличие от распределений std:: одинаков на всех платформах
+class Random {
+ public:
+  explicit Random(uint64_t seed) : state(seed) {}
+
+  uint64_t next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+  bool percent(unsigned chance) { return below(100) < chance; }
+
+ private:
+  uint64_t state;
+};
+
+// Число параметров зависит только от номера метода: вызов methodN
+// в любом классе передаёт одинаковое число аргументов, а одноимённые
+// методы наследников имеют ту же сигнатуру, что и у предка
+size_t parameterCount(size_t method) { return method % 3; }
+
+class Generator {
+ public:
+  explicit Generator(const CorpusOptions& options)
+      : options(options), random(options.seed) {}
+
+  std::string run() {
+    out.reserve(options.targetBytes + options.targetBytes / 8);
+    mainClass();
+    // Классы ссылаются только на себя и на предыдущие, поэтому
+    // текст можно оборвать после любого класса
+    size_t count = 0;
+    do {
+      classDeclaration(count++);
+    } while (out.size() < options.targetBytes);
+    return std::move(out);
+  }
+
+ private:
+  const CorpusOptions& options;
+  Random random;
+  std::string out;
+  size_t currentClass = 0;
+  size_t currentParameters = 0;
+  size_t indent = 0;
+
+  void line(const std::string& text) {
+    out.append(indent * 2, ' ');
+    out += text;
+    out += '\n';
+  }
+
+  static std::string className(size_t index) {
+    return "Class" + std::to_string(index);
+  }
+
+  void mainClass() {
+    line("class Main {");
+    indent++;
+    line("public static void main() {");
+    indent++;
+    line("System.out.println(new " + className(0) + "().method0(" +
+         arguments(0) + "));");
+    indent--;
+    line("}");
+    indent--;
+    line("}");
+    out += '\n';
+  }
+
+  std::string arguments(size_t method) {
+    std::string text;
+    for (size_t i = 0; i < parameterCount(method); i++) {
+      if (i > 0) text += ", ";
+      text += std::to_string(random.below(100));
+    }
+    return text;
+  }
+
+  void blockComment() {
+    line("/*");
+    line(" * Метод вычисляет очередное значение по полям класса.");
+    line(" * Комментарий /* с вложенным комментарием */ и символами * / .");
+    line(" */");
+  }
+
+  void classDeclaration(size_t index) {
+    currentClass = index;
+    if (options.commentPercent > 0) blockComment();
+    std::string header = "class " + className(index);
+    if (index > 0 && random.percent(30)) {
+      header += " extends " + className(random.below(index));
+    }
+    line(header + " {");
+    indent++;
+
+    for (size_t f = 0; f < options.fieldsPerClass; f++) {
+      line("int field" + std::to_string(f) + ";");
+    }
+    line("int[] values;");
+
+    for (size_t m = 0; m < options.methodsPerClass; m++) {
+      method(m);
+    }
+
+    indent--;
+    line("}");
+    out += '\n';
+  }
+
+  void method(size_t index) {
+    currentParameters = parameterCount(index);
+    if (options.commentPercent > 0) blockComment();
+
+    std::string header = "public int method" + std::to_string(index) + "(";
+    for (size_t p = 0; p < currentParameters; p++) {
+      if (p > 0) header += ", ";
+      header += "int p" + std::to_string(p);
+    }
+    line(header + ") {");
+    indent++;
+
+    line("int a;");
+    line("int b;");
+    line("boolean flag;");
+    line("a = " + intExpression(1) + ";");
+    line("b = 1;");
+    line("flag = true;");
+    line("values = new int[16];");
+
+    for (size_t s = 0; s < options.statementsPerMethod; s++) {
+      statement(2);
+    }
+
+    line("return " + intExpression(options.expressionDepth) + ";");
+    indent--;
+    line("}");
+  }
+
+  void statement(size_t nesting) {
+    std::string comment;
+    if (random.percent(options.commentPercent)) {
+      if (random.percent(50)) {
+        line("// Строчный комментарий перед оператором: a = a + 1;");
+      } else {
+        comment = " /* значение пересчитывается */";
+      }
+    }
+
+    size_t kind = random.below(nesting > 0 ? 7 : 4);
+    switch (kind) {
+      case 0:
+      case 1:
+        line(variable() + " = " + intExpression(options.expressionDepth) +
+             ";" + comment);
+        break;
+      case 2:
+        line("System.out.println(" + intExpression(options.expressionDepth) +
+             ");" + comment);
+        break;
+      case 3:
+        line("flag = " + boolExpression(options.expressionDepth) + ";" +
+             comment);
+        break;
+      case 4:
+        line("if (" + boolExpression(options.expressionDepth) + ") {" +
+             comment);
+        nested(nesting);
+        line("} else {");
+        nested(nesting);
+        line("}");
+        break;
+      case 5:
+        line("while (" + boolExpression(options.expressionDepth) + ") {" +
+             comment);
+        nested(nesting);
+        line("}");
+        break;
+      default:
+        line("assert(" + boolExpression(options.expressionDepth) + ");" +
+             comment);
+        break;
+    }
+  }
+
+  void nested(size_t nesting) {
+    indent++;
+    size_t count = 1 + random.below(3);
+    for (size_t i = 0; i < count; i++) statement(nesting - 1);
+    indent--;
+  }
+
+  std::string variable() {
+    switch (random.below(3)) {
+      case 0: return "a";
+      case 1: return "b";
+      default:
+        return "field" + std::to_string(random.below(options.fieldsPerClass));
+    }
+  }
+
+  std::string intOperand() {
+    switch (random.below(8)) {
+      case 0:
+        return std::to_string(random.below(1000));
+      case 1:
+        return currentParameters > 0
+                   ? "p" + std::to_string(random.below(currentParameters))
+                   : "-" + std::to_string(random.below(100));
+      case 2:
+        return "values[" + std::to_string(random.below(16)) + "]";
+      case 3:
+        return "values.length";
+      case 4: {
+        size_t method = random.below(options.methodsPerClass);
+        return "this.method" + std::to_string(method) + "(" +
+               arguments(method) + ")";
+      }
+      case 5: {
+        size_t cls = random.below(currentClass + 1);
+        size_t method = random.below(options.methodsPerClass);
+        return "new " + className(cls) + "().method" + std::to_string(method) +
+               "(" + arguments(method) + ")";
+      }
+      default:
+        return variable();
+    }
+  }
+
+  std::string intExpression(size_t depth) {
+    if (depth == 0) return intOperand();
+    static const char* operators[] = {" + ", " - ", " * ", " / ", " % "};
+    // Вложенность растёт по левому операнду, правый неглубокий:
+    // размер выражения линеен по глубине
+    std::string left = intExpression(depth - 1);
+    std::string right = intExpression(random.below(depth < 2 ? depth : 2));
+    return "(" + left + operators[random.below(5)] + right + ")";
+  }
+
+  std::string boolExpression(size_t depth) {
+    static const char* comparisons[] = {" < ", " > ", " == "};
+    std::string comparison = intExpression(depth > 0 ? depth - 1 : 0) +
+                             comparisons[random.below(3)] +
+                             intOperand();
+    switch (random.below(4)) {
+      case 0:
+        return "!(" + comparison + ")";
+      case 1:
+        return "flag && (" + comparison + ")";
+      case 2:
+        return "(" + comparison + ") || flag";
+      default:
+        return comparison;
+    }
+  }
+};
+
+}  // namespace
+
+const std::vector<std::string>& corpusShapes() {
+  static const std::vector<std::string> shapes = {"classes", "deep", "long",
+                                                  "comments", "mixed"};
+  return shapes;
+}
+
+CorpusOptions corpusShape(std::string_view shape, size_t targetBytes) {
+  CorpusOptions options;
+  options.targetBytes = targetBytes;
+
+  if (shape == "classes") {
+    options.fieldsPerClass = 2;
+    options.methodsPerClass = 2;
+    options.statementsPerMethod = 3;
+    options.expressionDepth = 1;
+  } else if (shape == "deep") {
+    options.methodsPerClass = 2;
+    options.statementsPerMethod = 6;
+    options.expressionDepth = 12;
+  } else if (shape == "long") {
+    options.methodsPerClass = 2;
+    options.statementsPerMethod = 400;
+    options.expressionDepth = 2;
+  } else if (shape == "comments") {
+    options.commentPercent = 90;
+  } else if (shape == "mixed") {
+    options.commentPercent = 20;
+  } else {
+    throw std::runtime_error("Неизвестная форма корпуса: " + std::string(shape));
+  }
+  return options;
+}
+
+std::string generateCorpus(const CorpusOptions& options) {
+  return Generator(options).run();
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Генератор синтетических программ на MiniJava для бенчмарков.
+// Результат зависит только от параметров (собственный генератор случайных
+// чисел), поэтому замеры разных сборок идут на одинаковом входе.
+// Программы разбираются парсером и согласованы по типам: методы
+// принимают и возвращают int, вызываются с нужным числом аргументов
+struct CorpusOptions {
+  size_t targetBytes = 1024 * 1024;  // Классы добавляются, пока текст короче
+  size_t fieldsPerClass = 3;
+  size_t methodsPerClass = 4;
+  size_t statementsPerMethod = 12;
+  size_t expressionDepth = 3;     // Вложенность бинарных операций
+  unsigned commentPercent = 0;    // Доля операторов с комментариями, %
+  uint64_t seed = 1;
+};
+
+// Именованные формы корпуса:
+//   classes  - много маленьких классов
+//   deep     - глубоко вложенные выражения
+//   long     - длинные тела методов
+//   comments - большая часть текста в комментариях
+//   mixed    - всего понемногу
+const std::vector<std::string>& corpusShapes();
+
+// Параметры формы shape; при неизвестном имени бросает std::runtime_error
+CorpusOptions corpusShape(std::string_view shape, size_t targetBytes);
+
+std::string generateCorpus(const CorpusOptions& options);
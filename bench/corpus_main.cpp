@@ -0,0 +1,57 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "corpus.h"
+
+// Генератор корпуса как отдельная программа:
+//   minijava_corpus [--shape форма] [--size байт] [--seed n] [-o файл]
+int main(int argc, char* argv[]) {
+  std::string shape = "mixed";
+  size_t size = 1024 * 1024;
+  uint64_t seed = 1;
+  std::string output;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(argv[i], "--shape") == 0 && hasValue) {
+      shape = argv[++i];
+    } else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+      size = std::stoull(argv[++i]);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+      seed = std::stoull(argv[++i]);
+    } else if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+      output = argv[++i];
+    } else {
+      std::cerr << "Использование: " << argv[0]
+                << " [--shape форма] [--size байт] [--seed n] [-o файл]"
+                << std::endl;
+      std::cerr << "Формы:";
+      for (const std::string& name : corpusShapes()) std::cerr << " " << name;
+      std::cerr << std::endl;
+      return 1;
+    }
+  }
+
+  try {
+    CorpusOptions options = corpusShape(shape, size);
+    options.seed = seed;
+    std::string text = generateCorpus(options);
+
+    if (output.empty()) {
+      std::cout << text;
+    } else {
+      std::ofstream file(output, std::ios::binary);
+      file << text;
+      if (!file) {
+        std::cerr << "Не удалось записать файл: " << output << std::endl;
+        return 1;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
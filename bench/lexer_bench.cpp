@@ -0,0 +1,173 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "lexer.h"
+#include "scan.h"
+#include "token_stream.h"
+
+namespace {
+
+constexpr size_t kSourceSize = 4 * 1024 * 1024;
+
+// Исходник, в котором большая часть байтов - комментарии
+std::string commentHeavySource() {
+  std::string text;
+  while (text.size() < kSourceSize) {
+    text +=
+        "/* Блочный комментарий, описывающий следующий метод.\n"
+        " * Он занимает несколько строк и содержит /* вложенный */ текст,\n"
+        " * а также отдельные символы * и / посреди слов.\n"
+        " */\n"
+        "// Строчный комментарий перед оператором присваивания\n"
+        "x = y; // и комментарий в конце строки\n";
+  }
+  return text;
+}
+
+// Исходник из длинных идентификаторов и отступов
+std::string identifierHeavySource() {
+  std::string text;
+  while (text.size() < kSourceSize) {
+    text +=
+        "        accumulatedTotalValue = accumulatedTotalValue + "
+        "currentElementOfTheInputArray_index;\n"
+        "        someVeryDescriptiveLocalVariableName = "
+        "anotherDescriptiveName_withSuffix123;\n";
+  }
+  return text;
+}
+
+// Плотный код: короткие имена, числа и операторы, почти без пробелов
+std::string operatorHeavySource() {
+  std::string text;
+  while (text.size() < kSourceSize) {
+    text +=
+        "a=b*(c+-12)%d;if(x<=y&&!(z>=-3)||w!=0){q[i]=q[i-1]+q[i+1];}\n"
+        "r=this.f(a,b,-1).g(c)[k].length;s=new int[n*2+1];t=t-1;\n";
+  }
+  return text;
+}
+
+void runLexer(benchmark::State& state, const std::string& source) {
+  auto backend = static_cast<scan::Backend>(state.range(0));
+  if (!scan::setBackend(backend)) {
+    state.SkipWithError("Реализация не поддерживается процессором");
+    return;
+  }
+
+  size_t tokens = 0;
+  for (auto _ : state) {
+    Lexer lexer(source);
+    tokens = 0;
+    while (lexer.getNextToken().type != TokenType::EOF_TOKEN) tokens++;
+    benchmark::DoNotOptimize(tokens);
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+  state.SetLabel(scan::backendName(backend));
+  scan::setBackend(scan::bestBackend());
+}
+
+void BM_LexCommentHeavy(benchmark::State& state) {
+  static const std::string source = commentHeavySource();
+  runLexer(state, source);
+}
+
+void BM_LexIdentifierHeavy(benchmark::State& state) {
+  static const std::string source = identifierHeavySource();
+  runLexer(state, source);
+}
+
+// Токенов в секунду на синтетическом корпусе с операторами
+void BM_LexTokens(benchmark::State& state) {
+  static const std::string source = operatorHeavySource();
+  size_t tokens = 0;
+  for (auto _ : state) {
+    Lexer lexer(source);
+    tokens = 0;
+    while (lexer.getNextToken().type != TokenType::EOF_TOKEN) tokens++;
+    benchmark::DoNotOptimize(tokens);
+  }
+  state.counters["tokens/s"] = benchmark::Counter(
+      static_cast<double>(tokens) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_LexTokens);
+
+// Вектор Token со строками и столбцами против компактного потока
+void BM_Tokenize(benchmark::State& state) {
+  static const std::string source = identifierHeavySource();
+  for (auto _ : state) {
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    benchmark::DoNotOptimize(tokens.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+}
+
+void BM_TokenizeCompact(benchmark::State& state) {
+  static const std::string source = identifierHeavySource();
+  for (auto _ : state) {
+    Lexer lexer(source);
+    TokenStream tokens = lexer.tokenizeCompact();
+    benchmark::DoNotOptimize(tokens.size());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+}
+
+// Аргумент - число потоков; 1 - обычный tokenize()
+void BM_TokenizeParallel(benchmark::State& state) {
+  static const std::string source = commentHeavySource() + operatorHeavySource();
+  auto threads = static_cast<unsigned>(state.range(0));
+  for (auto _ : state) {
+    Lexer lexer(source);
+    std::vector<Token> tokens = threads == 1 ? lexer.tokenize()
+                                             : lexer.tokenizeParallel(threads);
+    benchmark::DoNotOptimize(tokens.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+}
+
+// Правка одного символа посередине 4 МБ текста: поочерёдно вставка
+// и удаление, чтобы поток после итерации соответствовал исходному тексту
+void BM_RelexSingleEdit(benchmark::State& state) {
+  static const std::string source = identifierHeavySource();
+  static const size_t offset = source.find("Total", source.size() / 2);
+  static const std::string edited = source.substr(0, offset) + "_" +
+                                    source.substr(offset);
+
+  Lexer lexer(source);
+  TokenStream tokens = lexer.tokenizeCompact();
+  Lexer insertLexer(edited);
+  Lexer removeLexer(source);
+  for (auto _ : state) {
+    insertLexer.relex(tokens, TextEdit{offset, 0, "_"});
+    removeLexer.relex(tokens, TextEdit{offset, 1, ""});
+    benchmark::DoNotOptimize(tokens.size());
+  }
+}
+
+BENCHMARK(BM_Tokenize);
+BENCHMARK(BM_TokenizeCompact);
+BENCHMARK(BM_RelexSingleEdit);
+BENCHMARK(BM_TokenizeParallel)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+// Аргумент - реализация ядер сканирования; Scalar соответствует
+// посимвольному проходу, бывшему до векторизации
+void scanBackends(benchmark::internal::Benchmark* benchmark) {
+  for (scan::Backend backend :
+       {scan::Backend::Scalar, scan::Backend::SSE2, scan::Backend::AVX2}) {
+    benchmark->Arg(static_cast<int>(backend));
+  }
+}
+
+BENCHMARK(BM_LexCommentHeavy)->Apply(scanBackends);
+BENCHMARK(BM_LexIdentifierHeavy)->Apply(scanBackends);
+
+}  // namespace
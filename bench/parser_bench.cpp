@@ -0,0 +1,481 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "ast_printer.h"
+#include "corpus.h"
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "static_visitor.h"
+
+namespace {
+
+constexpr size_t kCorpusSize = 4 * 1024 * 1024;
+
+// Корпус формы с номером index из corpusShapes(); строится один раз
+const std::string& corpus(size_t index) {
+  static std::vector<std::string> texts(corpusShapes().size());
+  if (texts[index].empty()) {
+    texts[index] = generateCorpus(corpusShape(corpusShapes()[index], kCorpusSize));
+  }
+  return texts[index];
+}
+
+// Обходит дерево и считает узлы
+class NodeCounter : public Visitor {
+ public:
+  size_t count = 0;
+
+  void walk(ASTNode* node) {
+    if (node) node->accept(*this);
+  }
+
+  template <typename Node>
+  void walk(const AstList<Node>& nodes) {
+    for (Node* node : nodes) walk(node);
+  }
+
+  void visit(Program& node) override {
+    count++;
+    walk(node.mainClass);
+    walk(node.classes);
+  }
+  void visit(MainClass& node) override {
+    count++;
+    walk(node.statements);
+  }
+  void visit(ClassDeclaration& node) override {
+    count++;
+    walk(node.declarations);
+  }
+
+  void visit(IntType&) override { count++; }
+  void visit(BooleanType&) override { count++; }
+  void visit(VoidType&) override { count++; }
+  void visit(IdentifierType&) override { count++; }
+  void visit(ArrayType& node) override {
+    count++;
+    walk(node.elementType);
+  }
+
+  void visit(VariableDeclaration& node) override {
+    count++;
+    walk(node.type);
+  }
+  void visit(MethodDeclaration& node) override {
+    count++;
+    walk(node.returnType);
+    walk(node.parameters);
+    walk(node.statements);
+  }
+
+  void visit(AssertStatement& node) override {
+    count++;
+    walk(node.condition);
+  }
+  void visit(LocalVarDeclStatement& node) override {
+    count++;
+    walk(node.declaration);
+  }
+  void visit(BlockStatement& node) override {
+    count++;
+    walk(node.statements);
+  }
+  void visit(IfStatement& node) override {
+    count++;
+    walk(node.condition);
+    walk(node.thenStatement);
+    walk(node.elseStatement);
+  }
+  void visit(WhileStatement& node) override {
+    count++;
+    walk(node.condition);
+    walk(node.body);
+  }
+  void visit(PrintStatement& node) override {
+    count++;
+    walk(node.expression);
+  }
+  void visit(AssignStatement& node) override {
+    count++;
+    walk(node.lvalue);
+    walk(node.expression);
+  }
+  void visit(ReturnStatement& node) override {
+    count++;
+    walk(node.expression);
+  }
+  void visit(MethodInvocationStatement& node) override {
+    count++;
+    walk(node.invocation);
+  }
+  void visit(ErrorStatement&) override { count++; }
+
+  void visit(BinaryOperation& node) override {
+    count++;
+    walk(node.left);
+    walk(node.right);
+  }
+  void visit(UnaryOperation& node) override {
+    count++;
+    walk(node.expression);
+  }
+  void visit(ArrayIndexing& node) override {
+    count++;
+    walk(node.array);
+    walk(node.index);
+  }
+  void visit(ArrayLength& node) override {
+    count++;
+    walk(node.array);
+  }
+  void visit(MethodInvocation& node) override {
+    count++;
+    walk(node.object);
+    walk(node.arguments);
+  }
+  void visit(FieldAccess& node) override {
+    count++;
+    walk(node.object);
+  }
+  void visit(NewArray& node) override {
+    count++;
+    walk(node.elementType);
+    walk(node.size);
+  }
+  void visit(NewObject&) override { count++; }
+  void visit(IntegerLiteral&) override { count++; }
+  void visit(BooleanLiteral&) override { count++; }
+  void visit(ThisExpression&) override { count++; }
+  void visit(IdentifierExpression&) override { count++; }
+  void visit(ErrorExpression&) override { count++; }
+
+  void visit(IdentifierLValue&) override { count++; }
+  void visit(ArrayAccess& node) override {
+    count++;
+    walk(node.index);
+  }
+  void visit(SimpleFieldInvocation&) override { count++; }
+  void visit(FieldArrayInvocation& node) override {
+    count++;
+    walk(node.index);
+  }
+};
+
+// Тот же подсчёт через AstWalker: switch по тегу узла вместо двух
+// виртуальных вызовов (accept и visit) на узел
+class StaticNodeCounter : public AstWalker<StaticNodeCounter> {
+ public:
+  size_t count = 0;
+
+  template <typename Node>
+  void visit(Node& node) {
+    count++;
+    walkChildren(node);
+  }
+};
+
+// Поток, который отбрасывает вывод: замер печати без записи на диск
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+// Аргумент - номер формы корпуса
+void corpusShapeArgs(benchmark::internal::Benchmark* benchmark) {
+  for (size_t i = 0; i < corpusShapes().size(); i++) {
+    benchmark->Arg(static_cast<int>(i));
+  }
+}
+
+// МБ/с и токенов в секунду для Lexer::tokenize
+void BM_TokenizeCorpus(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  const std::string& source = corpus(shape);
+  size_t tokens = 0;
+  for (auto _ : state) {
+    Lexer lexer(source);
+    std::vector<Token> result = lexer.tokenize();
+    tokens = result.size();
+    benchmark::DoNotOptimize(result.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+  state.counters["tokens/s"] = benchmark::Counter(
+      static_cast<double>(tokens) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+size_t countNodes(Program& program) {
+  NodeCounter counter;
+  program.accept(counter);
+  return counter.count;
+}
+
+// Узлов AST в секунду для Parser::parseProgram, включая освобождение
+// дерева. Токены готовятся заранее, поэтому замер не включает лексер
+void BM_ParseCorpus(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  const std::string& source = corpus(shape);
+  Lexer lexer(source);
+  std::vector<Token> tokens = lexer.tokenize();
+  size_t nodes = countNodes(*Parser(tokens).parseProgram());
+
+  for (auto _ : state) {
+    Parser parser(tokens);
+    std::unique_ptr<Program> program = parser.parseProgram();
+    benchmark::DoNotOptimize(program.get());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+  state.counters["nodes/s"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+// Узлов в секунду при обходе готового дерева посетителем
+void BM_TraverseCorpus(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  Lexer lexer(corpus(shape));
+  std::vector<Token> tokens = lexer.tokenize();
+  std::unique_ptr<Program> program = Parser(tokens).parseProgram();
+
+  size_t nodes = 0;
+  for (auto _ : state) {
+    nodes = countNodes(*program);
+    benchmark::DoNotOptimize(nodes);
+  }
+  state.counters["nodes/s"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+// То же, что BM_TraverseCorpus, со статической диспетчеризацией
+void BM_TraverseStatic(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  Lexer lexer(corpus(shape));
+  std::vector<Token> tokens = lexer.tokenize();
+  std::unique_ptr<Program> program = Parser(tokens).parseProgram();
+
+  size_t nodes = 0;
+  for (auto _ : state) {
+    StaticNodeCounter counter;
+    counter.dispatch(*program);
+    nodes = counter.count;
+    benchmark::DoNotOptimize(nodes);
+  }
+  state.counters["nodes/s"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+// МБ/с вывода ASTPrinter в пустой поток
+void BM_PrintCorpus(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  Lexer lexer(corpus(shape));
+  std::vector<Token> tokens = lexer.tokenize();
+  std::unique_ptr<Program> program = Parser(tokens).parseProgram();
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+
+  for (auto _ : state) {
+    ASTPrinter printer(out);
+    program->accept(printer);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(corpus(shape).size()));
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+// МБ/с и узлов в секунду семантического анализа готового дерева;
+// сравнивается с BM_ParseCorpus на том же корпусе
+void BM_AnalyzeCorpus(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  Lexer lexer(corpus(shape));
+  std::vector<Token> tokens = lexer.tokenize();
+  std::unique_ptr<Program> program = Parser(tokens).parseProgram();
+  size_t nodes = countNodes(*program);
+
+  SemanticAnalyzer analyzer;
+  for (auto _ : state) {
+    bool valid = analyzer.analyze(*program);
+    benchmark::DoNotOptimize(valid);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(corpus(shape).size()));
+  state.counters["nodes/s"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+// Рекурсивный обход плоского дерева: тот же порядок, что у NodeCounter
+size_t countFlatNodes(const FlatAst& ast, FlatAst::NodeId id) {
+  size_t count = 1;
+  ast.forEachChild(id, [&](FlatAst::NodeId child) {
+    count += countFlatNodes(ast, child);
+  });
+  return count;
+}
+
+size_t countFlatNodes(const FlatAst& ast) {
+  size_t count = 1 + countFlatNodes(ast, ast.mainClass);
+  for (const FlatAst::NodeId* it = ast.begin(ast.classes);
+       it != ast.end(ast.classes); ++it) {
+    count += countFlatNodes(ast, *it);
+  }
+  return count;
+}
+
+// Узлов в секунду при переводе готового дерева в FlatAst
+void BM_FlattenCorpus(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  Lexer lexer(corpus(shape));
+  std::vector<Token> tokens = lexer.tokenize();
+  std::unique_ptr<Program> program = Parser(tokens).parseProgram();
+  size_t nodes = countNodes(*program);
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    FlatAst flat = FlatAst::fromProgram(*program);
+    bytes = flat.bytesUsed();
+    benchmark::DoNotOptimize(flat.kinds.data());
+  }
+  state.counters["nodes/s"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.counters["flat_MB"] = static_cast<double>(bytes) / (1 << 20);
+  state.counters["arena_MB"] =
+      static_cast<double>(program->arena.bytesReserved()) / (1 << 20);
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+// Узлов в секунду при обходе плоского дерева; сравнивать
+// с BM_TraverseCorpus
+void BM_TraverseFlat(benchmark::State& state) {
+  auto shape = static_cast<size_t>(state.range(0));
+  Lexer lexer(corpus(shape));
+  std::vector<Token> tokens = lexer.tokenize();
+  FlatAst flat = FlatAst::fromProgram(*Parser(tokens).parseProgram());
+
+  size_t nodes = 0;
+  for (auto _ : state) {
+    nodes = countFlatNodes(flat);
+    benchmark::DoNotOptimize(nodes);
+  }
+  state.counters["nodes/s"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.SetLabel(corpusShapes()[shape]);
+}
+
+// Операторы с выражениями из 48 вложенных скобок: каждый уровень проходит
+// всю цепочку от parseExpression до parsePrimary, почти не создавая узлов
+std::string nestedExpressionSource() {
+  std::string expression = "a";
+  static const char* operators[] = {" + ", " * ", " - ", " < ", " && "};
+  for (size_t depth = 0; depth < 48; depth++) {
+    expression = "(" + expression + operators[depth % 5] + "b)";
+  }
+
+  std::string text =
+      "class Main { public static void main() { System.out.println(1); } }\n"
+      "class Nested { public int run(int b) { int a;\n";
+  while (text.size() < kCorpusSize) text += "a = " + expression + ";\n";
+  text += "return a; } }\n";
+  return text;
+}
+
+// Длинные плоские цепочки бинарных операторов всех приоритетов
+std::string operatorChainSource() {
+  static const char* operators[] = {" + ", " * ", " - ", " / ", " < ",
+                                    " && ", " % ", " == ", " || ", " > "};
+  std::string expression = "a";
+  for (size_t i = 0; i < 64; i++) {
+    expression += operators[i % 10];
+    expression += i % 3 == 0 ? "b" : i % 3 == 1 ? "17" : "c[a]";
+  }
+
+  std::string text =
+      "class Main { public static void main() { System.out.println(1); } }\n"
+      "class Chains { public int run(int b) { int a;\n";
+  while (text.size() < kCorpusSize) text += "a = " + expression + ";\n";
+  text += "return a; } }\n";
+  return text;
+}
+
+void runExpressionParser(benchmark::State& state, const std::string& source) {
+  Lexer lexer(source);
+  std::vector<Token> tokens = lexer.tokenize();
+  for (auto _ : state) {
+    Parser parser(tokens);
+    std::unique_ptr<Program> program = parser.parseProgram();
+    benchmark::DoNotOptimize(program.get());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+  state.counters["tokens/s"] = benchmark::Counter(
+      static_cast<double>(tokens.size()) *
+          static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+}
+
+void BM_ParseNestedExpressions(benchmark::State& state) {
+  static const std::string source = nestedExpressionSource();
+  runExpressionParser(state, source);
+}
+
+void BM_ParseOperatorChains(benchmark::State& state) {
+  static const std::string source = operatorChainSource();
+  runExpressionParser(state, source);
+}
+
+// Parser::parseProgramParallel на корпусе из тысяч классов;
+// аргумент - число потоков. Время - настенное, а не процессорное
+void BM_ParseParallel(benchmark::State& state) {
+  const std::vector<std::string>& shapes = corpusShapes();
+  size_t shape = static_cast<size_t>(
+      std::find(shapes.begin(), shapes.end(), "classes") - shapes.begin());
+  const std::string& source = corpus(shape);
+  Lexer lexer(source);
+  std::vector<Token> tokens = lexer.tokenize();
+  auto threads = static_cast<unsigned>(state.range(0));
+  size_t nodes = countNodes(*Parser(tokens).parseProgram());
+
+  for (auto _ : state) {
+    Parser parser(tokens);
+    std::unique_ptr<Program> program = parser.parseProgramParallel(threads);
+    benchmark::DoNotOptimize(program.get());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(source.size()));
+  state.counters["nodes/s"] = benchmark::Counter(
+      static_cast<double>(nodes) * static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_TokenizeCorpus)->Apply(corpusShapeArgs);
+BENCHMARK(BM_ParseCorpus)->Apply(corpusShapeArgs);
+BENCHMARK(BM_TraverseCorpus)->Apply(corpusShapeArgs);
+BENCHMARK(BM_TraverseStatic)->Apply(corpusShapeArgs);
+BENCHMARK(BM_PrintCorpus)->Apply(corpusShapeArgs);
+BENCHMARK(BM_AnalyzeCorpus)->Apply(corpusShapeArgs);
+BENCHMARK(BM_FlattenCorpus)->Apply(corpusShapeArgs);
+BENCHMARK(BM_TraverseFlat)->Apply(corpusShapeArgs);
+BENCHMARK(BM_ParseNestedExpressions);
+BENCHMARK(BM_ParseOperatorChains);
+BENCHMARK(BM_ParseParallel)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+}  // namespace
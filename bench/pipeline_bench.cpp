@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "corpus.h"
+
+// Путь к собранному компилятору подставляет CMake
+#ifndef MINIJAVA_COMPILER_PATH
+#define MINIJAVA_COMPILER_PATH "minijava_compiler"
+#endif
+
+extern char** environ;
+
+namespace {
+
+constexpr size_t kCorpusSize = 4 * 1024 * 1024;
+
+// Корпус во временном файле; файл удаляется при выходе из программы
+class CorpusFile {
+ public:
+  explicit CorpusFile(const std::string& shape) {
+    char name[] = "/tmp/minijava_corpus_XXXXXX";
+    int fd = mkstemp(name);
+    if (fd >= 0) {
+      close(fd);
+      path = name;
+      std::ofstream file(path, std::ios::binary);
+      file << generateCorpus(corpusShape(shape, kCorpusSize));
+      if (!file) path.clear();
+    }
+  }
+  ~CorpusFile() {
+    if (!path.empty()) std::remove(path.c_str());
+  }
+
+  std::string path;
+};
+
+// Запускает компилятор на файле; вывод отбрасывается.
+// Возвращает код завершения или -1, если процесс не запустился
+int runCompiler(const std::string& path) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+
+  char* argv[] = {const_cast<char*>(MINIJAVA_COMPILER_PATH),
+                  const_cast<char*>(path.c_str()), nullptr};
+  pid_t pid;
+  int error = posix_spawn(&pid, MINIJAVA_COMPILER_PATH, &actions, nullptr,
+                          argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (error != 0) return -1;
+
+  int status = 0;
+  if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) return -1;
+  return WEXITSTATUS(status);
+}
+
+// Полное время работы minijava_compiler: запуск процесса, чтение файла,
+// разбор и вывод дерева. Аргумент - номер формы корпуса
+void BM_CompilerEndToEnd(benchmark::State& state) {
+  auto index = static_cast<size_t>(state.range(0));
+  const std::string& shape = corpusShapes()[index];
+  static std::vector<std::unique_ptr<CorpusFile>> files(corpusShapes().size());
+  std::unique_ptr<CorpusFile>& file = files[index];
+  if (!file) file = std::make_unique<CorpusFile>(shape);
+  if (file->path.empty()) {
+    state.SkipWithError("Не удалось записать корпус во временный файл");
+    return;
+  }
+
+  for (auto _ : state) {
+    if (runCompiler(file->path) != 0) {
+      state.SkipWithError("Компилятор завершился с ошибкой");
+      break;
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(kCorpusSize));
+  state.SetLabel(shape);
+}
+
+void corpusShapeArgs(benchmark::internal::Benchmark* benchmark) {
+  for (size_t i = 0; i < corpusShapes().size(); i++) {
+    benchmark->Arg(static_cast<int>(i));
+  }
+}
+
+BENCHMARK(BM_CompilerEndToEnd)
+    ->Apply(corpusShapeArgs)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
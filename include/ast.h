@@ -2,13 +2,54 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <memory>
+#include "ast_arena.h"
+#include "ast_kind.h"
+#include "symbol.h"
+
+// Тип значения выражения. Заполняется семантическим анализом
+// (semantic.h); Unknown - тип ещё не вычислен или выражение ошибочно
+struct ValueType {
+    enum class Kind : uint8_t { Unknown, Int, Boolean, Void, Class };
+
+    Kind kind = Kind::Unknown;
+    bool array = false;  // одномерный массив элементов kind
+    Symbol className;    // для Kind::Class
+
+    static ValueType of(Kind kind, bool array = false) { return ValueType{kind, array, Symbol()}; }
+    static ValueType ofClass(Symbol name, bool array = false) {
+        return ValueType{Kind::Class, array, name};
+    }
+
+    bool known() const { return kind != Kind::Unknown; }
+    bool is(Kind other) const { return kind == other && !array; }
+    bool isObject() const { return kind == Kind::Class && !array; }
+    ValueType element() const { return ValueType{kind, false, className}; }
+
+    bool operator==(const ValueType& other) const {
+        return kind == other.kind && array == other.array && className == other.className;
+    }
+    bool operator!=(const ValueType& other) const { return !(*this == other); }
+};
+
+// Роль переменной; заполняется семантическим анализом
+enum class VariableScope : uint8_t { Unknown, Field, Parameter, Local };
 
 // Базовые классы для нетерминалов грамматики
 
-// Базовый класс для всех узлов AST
+// Базовый класс для всех узлов AST. Узлы, кроме Program, размещаются
+// в AstArena и не удаляются по отдельности
 class ASTNode {
 public:
+    // Конкретный класс узла: по нему StaticVisitor выбирает visit
+    // без виртуальных вызовов. Тег лежит сразу за указателем на таблицу
+    // виртуальных методов, и 4-байтовые поля наследников (Symbol,
+    // операторы) занимают выравнивание за ним, поэтому в узлах они
+    // объявлены первыми
+    const NodeKind kind;
+
+    explicit ASTNode(NodeKind kind) : kind(kind) {}
     virtual ~ASTNode() = default;
     virtual void accept(class Visitor& visitor) = 0;
 };
@@ -16,18 +57,23 @@ public:
 // Базовый класс для выражений
 class Expression : public ASTNode {
 public:
+    ValueType type;  // вычисляется семантическим анализом
+
+    explicit Expression(NodeKind kind) : ASTNode(kind) {}
     virtual ~Expression() = default;
 };
 
 // Базовый класс для операторов
 class Statement : public ASTNode {
 public:
+    explicit Statement(NodeKind kind) : ASTNode(kind) {}
     virtual ~Statement() = default;
 };
 
 // Базовый класс для типов
 class Type : public ASTNode {
 public:
+    explicit Type(NodeKind kind) : ASTNode(kind) {}
     virtual ~Type() = default;
     virtual bool isArray() const = 0;
 };
@@ -36,35 +82,41 @@ public:
 class Declaration : public ASTNode {
 public:
     virtual ~Declaration() = default;
-    std::string name;
+    Symbol name;
 
-    Declaration(const std::string& name) : name(name) {}
+    Declaration(NodeKind kind, Symbol name) : ASTNode(kind), name(name) {}
 };
 
 // Базовый класс для lvalue (левая часть присваивания)
 class LValue : public Expression {
 public:
+    explicit LValue(NodeKind kind) : Expression(kind) {}
     virtual ~LValue() = default;
 };
 
 // Базовый класс для простых типов
 class SimpleType : public Type {
 public:
+    explicit SimpleType(NodeKind kind) : Type(kind) {}
     virtual ~SimpleType() = default;
     bool isArray() const override { return false; }
 };
 
 // Классы для программы и основных структур
 
-// Программа состоит из главного класса и других классов
+// Программа состоит из главного класса и других классов.
+// Программа владеет ареной, в которой размещены все остальные узлы;
+// дерево освобождается вместе с ней
 class Program : public ASTNode {
 public:
-    std::unique_ptr<class MainClass> mainClass;
-    std::vector<std::unique_ptr<class ClassDeclaration>> classes;
+    AstArena arena;
+    class MainClass* mainClass;
+    AstList<class ClassDeclaration> classes;
 
-    Program(std::unique_ptr<MainClass> mainClass, 
-            std::vector<std::unique_ptr<ClassDeclaration>> classes)
-        : mainClass(std::move(mainClass)), classes(std::move(classes)) {}
+    Program(AstArena arena, MainClass* mainClass,
+            AstList<ClassDeclaration> classes)
+        : ASTNode(NodeKind::Program), arena(std::move(arena)),
+          mainClass(mainClass), classes(classes) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -72,11 +124,11 @@ public:
 // Главный класс программы
 class MainClass : public ASTNode {
 public:
-    std::string className;
-    std::vector<std::unique_ptr<Statement>> statements;
+    Symbol className;
+    AstList<Statement> statements;
 
-    MainClass(const std::string& className, std::vector<std::unique_ptr<Statement>> statements)
-        : className(className), statements(std::move(statements)) {}
+    MainClass(Symbol className, AstList<Statement> statements)
+        : ASTNode(NodeKind::MainClass), className(className), statements(statements) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -84,13 +136,15 @@ public:
 // Объявление класса
 class ClassDeclaration : public ASTNode {
 public:
-    std::string className;
-    std::string baseClassName; // Может быть пустой, если нет наследования
-    std::vector<std::unique_ptr<Declaration>> declarations;
+    Symbol className;
+    Symbol baseClassName; // Может быть пустой, если нет наследования
+    AstList<Declaration> declarations;
+    ClassDeclaration* baseClass = nullptr;  // объявление базового класса
 
-    ClassDeclaration(const std::string& className, const std::string& baseClassName,
-                    std::vector<std::unique_ptr<Declaration>> declarations)
-        : className(className), baseClassName(baseClassName), declarations(std::move(declarations)) {}
+    ClassDeclaration(Symbol className, Symbol baseClassName,
+                    AstList<Declaration> declarations)
+        : ASTNode(NodeKind::ClassDeclaration), className(className),
+          baseClassName(baseClassName), declarations(declarations) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -100,27 +154,34 @@ public:
 // Тип "int"
 class IntType : public SimpleType {
 public:
+    IntType() : SimpleType(NodeKind::IntType) {}
+
     void accept(Visitor& visitor) override;
 };
 
 // Тип "boolean"
 class BooleanType : public SimpleType {
 public:
+    BooleanType() : SimpleType(NodeKind::BooleanType) {}
+
     void accept(Visitor& visitor) override;
 };
 
 // Тип "void"
 class VoidType : public SimpleType {
 public:
+    VoidType() : SimpleType(NodeKind::VoidType) {}
+
     void accept(Visitor& visitor) override;
 };
 
 // Тип по идентификатору (пользовательский класс)
 class IdentifierType : public SimpleType {
 public:
-    std::string typeName;
+    Symbol typeName;
+    ClassDeclaration* declaration = nullptr;  // nullptr - главный или неизвестный класс
 
-    IdentifierType(const std::string& typeName) : typeName(typeName) {}
+    IdentifierType(Symbol typeName) : SimpleType(NodeKind::IdentifierType), typeName(typeName) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -128,9 +189,9 @@ public:
 // Тип массива
 class ArrayType : public Type {
 public:
-    std::unique_ptr<SimpleType> elementType;
+    SimpleType* elementType;
 
-    ArrayType(std::unique_ptr<SimpleType> elementType) : elementType(std::move(elementType)) {}
+    ArrayType(SimpleType* elementType) : Type(NodeKind::ArrayType), elementType(elementType) {}
 
     bool isArray() const override { return true; }
     void accept(Visitor& visitor) override;
@@ -141,10 +202,11 @@ public:
 // Объявление переменной
 class VariableDeclaration : public Declaration {
 public:
-    std::unique_ptr<Type> type;
+    Type* type;
+    VariableScope scope = VariableScope::Unknown;
 
-    VariableDeclaration(std::unique_ptr<Type> type, const std::string& name)
-        : Declaration(name), type(std::move(type)) {}
+    VariableDeclaration(Type* type, Symbol name)
+        : Declaration(NodeKind::VariableDeclaration, name), type(type) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -152,15 +214,15 @@ public:
 // Объявление метода
 class MethodDeclaration : public Declaration {
 public:
-    std::unique_ptr<Type> returnType;
-    std::vector<std::unique_ptr<VariableDeclaration>> parameters;
-    std::vector<std::unique_ptr<Statement>> statements;
+    Type* returnType;
+    AstList<VariableDeclaration> parameters;
+    AstList<Statement> statements;
 
-    MethodDeclaration(std::unique_ptr<Type> returnType, const std::string& name,
-                     std::vector<std::unique_ptr<VariableDeclaration>> parameters,
-                     std::vector<std::unique_ptr<Statement>> statements)
-        : Declaration(name), returnType(std::move(returnType)), 
-          parameters(std::move(parameters)), statements(std::move(statements)) {}
+    MethodDeclaration(Type* returnType, Symbol name,
+                     AstList<VariableDeclaration> parameters,
+                     AstList<Statement> statements)
+        : Declaration(NodeKind::MethodDeclaration, name), returnType(returnType), 
+          parameters(parameters), statements(statements) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -170,10 +232,10 @@ public:
 // Оператор assert
 class AssertStatement : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
+    Expression* condition;
 
-    AssertStatement(std::unique_ptr<Expression> condition)
-        : condition(std::move(condition)) {}
+    AssertStatement(Expression* condition)
+        : Statement(NodeKind::AssertStatement), condition(condition) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -181,10 +243,10 @@ public:
 // Локальное объявление переменной
 class LocalVarDeclStatement : public Statement {
 public:
-    std::unique_ptr<VariableDeclaration> declaration;
+    VariableDeclaration* declaration;
 
-    LocalVarDeclStatement(std::unique_ptr<VariableDeclaration> declaration)
-        : declaration(std::move(declaration)) {}
+    LocalVarDeclStatement(VariableDeclaration* declaration)
+        : Statement(NodeKind::LocalVarDeclStatement), declaration(declaration) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -192,10 +254,10 @@ public:
 // Блок операторов
 class BlockStatement : public Statement {
 public:
-    std::vector<std::unique_ptr<Statement>> statements;
+    AstList<Statement> statements;
 
-    BlockStatement(std::vector<std::unique_ptr<Statement>> statements)
-        : statements(std::move(statements)) {}
+    BlockStatement(AstList<Statement> statements)
+        : Statement(NodeKind::BlockStatement), statements(statements) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -203,16 +265,16 @@ public:
 // Условный оператор if
 class IfStatement : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> thenStatement;
-    std::unique_ptr<Statement> elseStatement; // Может быть nullptr
+    Expression* condition;
+    Statement* thenStatement;
+    Statement* elseStatement; // Может быть nullptr
 
-    IfStatement(std::unique_ptr<Expression> condition,
-               std::unique_ptr<Statement> thenStatement,
-               std::unique_ptr<Statement> elseStatement = nullptr)
-        : condition(std::move(condition)), 
-          thenStatement(std::move(thenStatement)), 
-          elseStatement(std::move(elseStatement)) {}
+    IfStatement(Expression* condition,
+               Statement* thenStatement,
+               Statement* elseStatement = nullptr)
+        : Statement(NodeKind::IfStatement), condition(condition), 
+          thenStatement(thenStatement), 
+          elseStatement(elseStatement) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -220,11 +282,11 @@ public:
 // Цикл while
 class WhileStatement : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> body;
+    Expression* condition;
+    Statement* body;
 
-    WhileStatement(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> body)
-        : condition(std::move(condition)), body(std::move(body)) {}
+    WhileStatement(Expression* condition, Statement* body)
+        : Statement(NodeKind::WhileStatement), condition(condition), body(body) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -232,10 +294,10 @@ public:
 // Оператор вывода
 class PrintStatement : public Statement {
 public:
-    std::unique_ptr<Expression> expression;
+    Expression* expression;
 
-    PrintStatement(std::unique_ptr<Expression> expression)
-        : expression(std::move(expression)) {}
+    PrintStatement(Expression* expression)
+        : Statement(NodeKind::PrintStatement), expression(expression) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -243,11 +305,11 @@ public:
 // Оператор присваивания
 class AssignStatement : public Statement {
 public:
-    std::unique_ptr<LValue> lvalue;
-    std::unique_ptr<Expression> expression;
+    LValue* lvalue;
+    Expression* expression;
 
-    AssignStatement(std::unique_ptr<LValue> lvalue, std::unique_ptr<Expression> expression)
-        : lvalue(std::move(lvalue)), expression(std::move(expression)) {}
+    AssignStatement(LValue* lvalue, Expression* expression)
+        : Statement(NodeKind::AssignStatement), lvalue(lvalue), expression(expression) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -255,10 +317,10 @@ public:
 // Оператор return
 class ReturnStatement : public Statement {
 public:
-    std::unique_ptr<Expression> expression;
+    Expression* expression;
 
-    ReturnStatement(std::unique_ptr<Expression> expression)
-        : expression(std::move(expression)) {}
+    ReturnStatement(Expression* expression)
+        : Statement(NodeKind::ReturnStatement), expression(expression) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -266,10 +328,19 @@ public:
 // Вызов метода как оператор (не выражение)
 class MethodInvocationStatement : public Statement {
 public:
-    std::unique_ptr<class MethodInvocation> invocation;
+    class MethodInvocation* invocation;
+
+    MethodInvocationStatement(class MethodInvocation* invocation)
+        : Statement(NodeKind::MethodInvocationStatement), invocation(invocation) {}
 
-    MethodInvocationStatement(std::unique_ptr<class MethodInvocation> invocation)
-        : invocation(std::move(invocation)) {}
+    void accept(Visitor& visitor) override;
+};
+
+// Оператор, который не удалось разобрать; появляется только при разборе
+// с восстановлением после ошибок
+class ErrorStatement : public Statement {
+public:
+    ErrorStatement() : Statement(NodeKind::ErrorStatement) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -278,18 +349,41 @@ public:
 
 // Бинарные операторы
 enum class BinaryOperator {
-    AND, OR, LESS, GREATER, EQUAL, PLUS, MINUS, MULTIPLY, DIVIDE, MODULO
-};
+    AND, OR, LESS, GREATER, EQUAL, PLUS, MINUS, MULTIPLY, DIVIDE, MODULO,
+    NOT_EQUAL, LESS_EQUAL, GREATER_EQUAL
+};
+
+constexpr size_t kBinaryOperatorCount = static_cast<size_t>(BinaryOperator::GREATER_EQUAL) + 1;
+
+// Запись оператора в исходном тексте
+inline const char* operatorText(BinaryOperator op) {
+    switch (op) {
+        case BinaryOperator::AND: return "&&";
+        case BinaryOperator::OR: return "||";
+        case BinaryOperator::LESS: return "<";
+        case BinaryOperator::GREATER: return ">";
+        case BinaryOperator::EQUAL: return "==";
+        case BinaryOperator::PLUS: return "+";
+        case BinaryOperator::MINUS: return "-";
+        case BinaryOperator::MULTIPLY: return "*";
+        case BinaryOperator::DIVIDE: return "/";
+        case BinaryOperator::MODULO: return "%";
+        case BinaryOperator::NOT_EQUAL: return "!=";
+        case BinaryOperator::LESS_EQUAL: return "<=";
+        case BinaryOperator::GREATER_EQUAL: return ">=";
+    }
+    return "?";
+}
 
 // Бинарная операция
 class BinaryOperation : public Expression {
 public:
-    std::unique_ptr<Expression> left;
     BinaryOperator op;
-    std::unique_ptr<Expression> right;
+    Expression* left;
+    Expression* right;
 
-    BinaryOperation(std::unique_ptr<Expression> left, BinaryOperator op, std::unique_ptr<Expression> right)
-        : left(std::move(left)), op(op), right(std::move(right)) {}
+    BinaryOperation(Expression* left, BinaryOperator op, Expression* right)
+        : Expression(NodeKind::BinaryOperation), op(op), left(left), right(right) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -299,14 +393,23 @@ enum class UnaryOperator {
     NOT
 };
 
+constexpr size_t kUnaryOperatorCount = static_cast<size_t>(UnaryOperator::NOT) + 1;
+
+inline const char* operatorText(UnaryOperator op) {
+    switch (op) {
+        case UnaryOperator::NOT: return "!";
+    }
+    return "?";
+}
+
 // Унарная операция
 class UnaryOperation : public Expression {
 public:
     UnaryOperator op;
-    std::unique_ptr<Expression> expression;
+    Expression* expression;
 
-    UnaryOperation(UnaryOperator op, std::unique_ptr<Expression> expression)
-        : op(op), expression(std::move(expression)) {}
+    UnaryOperation(UnaryOperator op, Expression* expression)
+        : Expression(NodeKind::UnaryOperation), op(op), expression(expression) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -314,14 +417,14 @@ public:
 // Индексация массива
 class ArrayIndexing : public Expression {
 public:
-    std::unique_ptr<Expression> array;
-    std::unique_ptr<Expression> index;
+    Expression* array;
+    Expression* index;
 
-    ArrayIndexing(std::unique_ptr<Expression> array, std::unique_ptr<Expression> index)
-        : array(std::move(array)), index(std::move(index)) {}
+    ArrayIndexing(Expression* array, Expression* index)
+        : Expression(NodeKind::ArrayIndexing), array(array), index(index) {}
 
-    ArrayIndexing(std::unique_ptr<Expression> array) // Для доступа к length
-        : array(std::move(array)), index(nullptr) {}
+    ArrayIndexing(Expression* array) // Для доступа к length
+        : Expression(NodeKind::ArrayIndexing), array(array), index(nullptr) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -329,10 +432,10 @@ public:
 // Получение длины массива
 class ArrayLength : public Expression {
 public:
-    std::unique_ptr<Expression> array;
+    Expression* array;
 
-    ArrayLength(std::unique_ptr<Expression> array)
-        : array(std::move(array)) {}
+    ArrayLength(Expression* array)
+        : Expression(NodeKind::ArrayLength), array(array) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -340,13 +443,15 @@ public:
 // Вызов метода
 class MethodInvocation : public Expression {
 public:
-    std::unique_ptr<Expression> object;
-    std::string methodName;
-    std::vector<std::unique_ptr<Expression>> arguments;
+    Symbol methodName;
+    Expression* object;
+    AstList<Expression> arguments;
+    MethodDeclaration* declaration = nullptr;
 
-    MethodInvocation(std::unique_ptr<Expression> object, const std::string& methodName,
-                    std::vector<std::unique_ptr<Expression>> arguments)
-        : object(std::move(object)), methodName(methodName), arguments(std::move(arguments)) {}
+    MethodInvocation(Expression* object, Symbol methodName,
+                    AstList<Expression> arguments)
+        : Expression(NodeKind::MethodInvocation), methodName(methodName),
+          object(object), arguments(arguments) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -354,11 +459,12 @@ public:
 // Доступ к полю
 class FieldAccess : public Expression {
 public:
-    std::unique_ptr<Expression> object;
-    std::string fieldName;
+    Symbol fieldName;
+    Expression* object;
+    VariableDeclaration* declaration = nullptr;
 
-    FieldAccess(std::unique_ptr<Expression> object, const std::string& fieldName)
-        : object(std::move(object)), fieldName(fieldName) {}
+    FieldAccess(Expression* object, Symbol fieldName)
+        : Expression(NodeKind::FieldAccess), fieldName(fieldName), object(object) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -366,11 +472,11 @@ public:
 // Создание нового массива
 class NewArray : public Expression {
 public:
-    std::unique_ptr<SimpleType> elementType;
-    std::unique_ptr<Expression> size;
+    SimpleType* elementType;
+    Expression* size;
 
-    NewArray(std::unique_ptr<SimpleType> elementType, std::unique_ptr<Expression> size)
-        : elementType(std::move(elementType)), size(std::move(size)) {}
+    NewArray(SimpleType* elementType, Expression* size)
+        : Expression(NodeKind::NewArray), elementType(elementType), size(size) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -378,9 +484,10 @@ public:
 // Создание нового объекта
 class NewObject : public Expression {
 public:
-    std::string className;
+    Symbol className;
+    ClassDeclaration* declaration = nullptr;  // nullptr - главный или неизвестный класс
 
-    NewObject(const std::string& className) : className(className) {}
+    NewObject(Symbol className) : Expression(NodeKind::NewObject), className(className) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -388,9 +495,9 @@ public:
 // Литерал целого числа
 class IntegerLiteral : public Expression {
 public:
-    int value;
+    int32_t value;  // Значение вычислено лексером
 
-    IntegerLiteral(int value) : value(value) {}
+    IntegerLiteral(int32_t value) : Expression(NodeKind::IntegerLiteral), value(value) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -400,7 +507,7 @@ class BooleanLiteral : public Expression {
 public:
     bool value;
 
-    BooleanLiteral(bool value) : value(value) {}
+    BooleanLiteral(bool value) : Expression(NodeKind::BooleanLiteral), value(value) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -408,15 +515,27 @@ public:
 // Выражение this
 class ThisExpression : public Expression {
 public:
+    ThisExpression() : Expression(NodeKind::ThisExpression) {}
+
     void accept(Visitor& visitor) override;
 };
 
 // Идентификатор как выражение
 class IdentifierExpression : public Expression {
 public:
-    std::string name;
+    Symbol name;
+    VariableDeclaration* declaration = nullptr;
+
+    IdentifierExpression(Symbol name)
+        : Expression(NodeKind::IdentifierExpression), name(name) {}
+
+    void accept(Visitor& visitor) override;
+};
 
-    IdentifierExpression(const std::string& name) : name(name) {}
+// Выражение, которое не удалось разобрать (при восстановлении после ошибок)
+class ErrorExpression : public Expression {
+public:
+    ErrorExpression() : Expression(NodeKind::ErrorExpression) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -426,9 +545,10 @@ public:
 // Простой идентификатор как lvalue
 class IdentifierLValue : public LValue {
 public:
-    std::string name;
+    Symbol name;
+    VariableDeclaration* declaration = nullptr;
 
-    IdentifierLValue(const std::string& name) : name(name) {}
+    IdentifierLValue(Symbol name) : LValue(NodeKind::IdentifierLValue), name(name) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -436,11 +556,12 @@ public:
 // Доступ к элементу массива как lvalue
 class ArrayAccess : public LValue {
 public:
-    std::string arrayName;
-    std::unique_ptr<Expression> index;
+    Symbol arrayName;
+    Expression* index;
+    VariableDeclaration* declaration = nullptr;
 
-    ArrayAccess(const std::string& arrayName, std::unique_ptr<Expression> index)
-        : arrayName(arrayName), index(std::move(index)) {}
+    ArrayAccess(Symbol arrayName, Expression* index)
+        : LValue(NodeKind::ArrayAccess), arrayName(arrayName), index(index) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -448,15 +569,18 @@ public:
 // Базовый класс для обращения к полю
 class FieldInvocation : public LValue {
 public:
+    explicit FieldInvocation(NodeKind kind) : LValue(kind) {}
     virtual ~FieldInvocation() = default;
 };
 
 // Простое обращение к полю (this.field)
 class SimpleFieldInvocation : public FieldInvocation {
 public:
-    std::string fieldName;
+    Symbol fieldName;
+    VariableDeclaration* declaration = nullptr;
 
-    SimpleFieldInvocation(const std::string& fieldName) : fieldName(fieldName) {}
+    SimpleFieldInvocation(Symbol fieldName)
+        : FieldInvocation(NodeKind::SimpleFieldInvocation), fieldName(fieldName) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -464,11 +588,12 @@ public:
 // Обращение к элементу массива-поля (this.field[index])
 class FieldArrayInvocation : public FieldInvocation {
 public:
-    std::string fieldName;
-    std::unique_ptr<Expression> index;
+    Symbol fieldName;
+    Expression* index;
+    VariableDeclaration* declaration = nullptr;
 
-    FieldArrayInvocation(const std::string& fieldName, std::unique_ptr<Expression> index)
-        : fieldName(fieldName), index(std::move(index)) {}
+    FieldArrayInvocation(Symbol fieldName, Expression* index)
+        : FieldInvocation(NodeKind::FieldArrayInvocation), fieldName(fieldName), index(index) {}
 
     void accept(Visitor& visitor) override;
 };
@@ -500,6 +625,7 @@ public:
     virtual void visit(AssignStatement& node) = 0;
     virtual void visit(ReturnStatement& node) = 0;
     virtual void visit(MethodInvocationStatement& node) = 0;
+    virtual void visit(ErrorStatement& node) = 0;
 
     virtual void visit(BinaryOperation& node) = 0;
     virtual void visit(UnaryOperation& node) = 0;
@@ -513,6 +639,7 @@ public:
     virtual void visit(BooleanLiteral& node) = 0;
     virtual void visit(ThisExpression& node) = 0;
     virtual void visit(IdentifierExpression& node) = 0;
+    virtual void visit(ErrorExpression& node) = 0;
 
     virtual void visit(IdentifierLValue& node) = 0;
     virtual void visit(ArrayAccess& node) = 0;
@@ -540,6 +667,7 @@ inline void PrintStatement::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void AssignStatement::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void ReturnStatement::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void MethodInvocationStatement::accept(Visitor& visitor) { visitor.visit(*this); }
+inline void ErrorStatement::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void BinaryOperation::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void UnaryOperation::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void ArrayIndexing::accept(Visitor& visitor) { visitor.visit(*this); }
@@ -552,6 +680,7 @@ inline void IntegerLiteral::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void BooleanLiteral::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void ThisExpression::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void IdentifierExpression::accept(Visitor& visitor) { visitor.visit(*this); }
+inline void ErrorExpression::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void IdentifierLValue::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void ArrayAccess::accept(Visitor& visitor) { visitor.visit(*this); }
 inline void SimpleFieldInvocation::accept(Visitor& visitor) { visitor.visit(*this); }
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Список дочерних узлов: непрерывный массив указателей в арене.
+// Индексация и обход такие же, как у вектора указателей
+template <typename T>
+class AstList {
+public:
+    AstList() = default;
+    AstList(T* const* items, size_t count) : items(items), count(count) {}
+
+    T* const* begin() const { return items; }
+    T* const* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* operator[](size_t index) const { return items[index]; }
+
+private:
+    T* const* items = nullptr;
+    size_t count = 0;
+};
+
+// Арена для узлов AST: память выделяется сдвигом указателя внутри
+// больших блоков и освобождается целиком, по блоку за раз.
+// Деструкторы размещённых объектов не вызываются, поэтому в арене
+// хранятся только объекты, которым освобождение не нужно: узлы AST
+// ссылаются на детей простыми указателями и списками AstList
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(AstArena&& other) noexcept;
+    AstArena& operator=(AstArena&& other) noexcept;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+    ~AstArena();
+
+    void* allocate(size_t size, size_t alignment) {
+        size_t padding = (alignment - reinterpret_cast<size_t>(cursor)) & (alignment - 1);
+        if (padding + size > static_cast<size_t>(limit - cursor)) {
+            return allocateSlow(size, alignment);
+        }
+        char* result = cursor + padding;
+        cursor = result + size;
+        return result;
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Неинициализированный массив из count элементов
+    template <typename T>
+    T* allocateArray(size_t count) {
+        if (count == 0) return nullptr;
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Забирает блоки другой арены: узлы, построенные в ней (например,
+    // на другом потоке), живут, пока жива эта арена. Текущий блок
+    // не меняется, остаток блоков other не используется
+    void adopt(AstArena&& other);
+
+    // Байт занято во всех блоках, включая недозаполненные хвосты
+    size_t bytesReserved() const { return reserved; }
+
+private:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    std::vector<char*> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t reserved = 0;
+
+    void* allocateSlow(size_t size, size_t alignment);
+    void release();
+};
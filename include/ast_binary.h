@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "flat_ast.h"
+
+// Двоичный формат разобранной программы (файлы .ast).
+// Файл - это массивы FlatAst как есть: заголовок, таблица секций
+// (смещение от начала файла, число элементов, размер элемента)
+// и сами секции, выровненные на 8 байт. Указателей нет, поэтому файл
+// не зависит от адреса, по которому загружен. Имена хранятся один раз
+// в таблице строк, а в узлах - номерами в ней; при загрузке номера
+// переводятся в Symbol текущего процесса.
+// В заголовке - размер и хеш XXH64 исходника, по которым проверяется,
+// что файл построен по этому тексту. Числа записаны в порядке байтов
+// машины; файл с другим порядком или версией не загружается
+class AstBinary {
+public:
+    // Версия меняется при любом изменении раскладки, в том числе при
+    // изменении порядка пулов FlatAst::forEachPool или NodeKind
+    static constexpr uint32_t kVersion = 1;
+
+    // Файл не в этом формате, другой версии или повреждён
+    class FormatError : public std::runtime_error {
+    public:
+        explicit FormatError(const std::string& message) : std::runtime_error(message) {}
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t sectionCount;
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+        uint32_t mainClass;
+        uint32_t classesBegin;
+        uint32_t classesCount;
+        uint32_t reserved;
+    };
+
+    // Файл для дерева ast, построенного по тексту source
+    static std::string serialize(const FlatAst& ast, std::string_view source);
+
+    // Похоже ли data на файл этого формата (по сигнатуре)
+    static bool isBinary(std::string_view data);
+
+    // Заголовок с проверкой сигнатуры, версии и порядка байтов
+    static Header readHeader(std::string_view data);
+
+    // Построен ли файл с заголовком header по тексту source
+    static bool matchesSource(const Header& header, std::string_view source);
+
+    // Дерево из содержимого файла: массивы копируются целиком, номера
+    // имён переводятся одним проходом; объекты узлов не создаются.
+    // Секции копируются в собственные массивы FlatAst (memcpy), а не
+    // используются на месте: столбцы имён всё равно переводятся в Symbol
+    // этого процесса, а FlatAst владеет своими массивами и живёт
+    // дольше буфера data
+    static FlatAst deserialize(std::string_view data);
+
+    // Загрузка из файла: файл отображается в память только на время
+    // deserialize, результат от отображения не зависит
+    static FlatAst load(const std::string& path);
+
+    // Запись через временный файл и rename: читатели видят либо старый
+    // файл, либо новый целиком. При ошибке бросает std::runtime_error
+    static void writeFile(const std::string& path, std::string_view data);
+};
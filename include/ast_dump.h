@@ -0,0 +1,20 @@
+#pragma once
+#include <ostream>
+#include <string_view>
+#include "ast.h"
+
+// Формат вывода дерева (--dump-ast)
+enum class AstFormat {
+    Tree,   // читаемый вид с отступами (ASTPrinter)
+    Json,   // один объект JSON в строку
+    Sexpr,  // S-выражение в строку
+};
+
+// "tree", "json" или "sexpr"; false для неизвестного имени
+bool parseAstFormat(std::string_view name, AstFormat& format);
+
+// Печатает дерево в формате format. Узел JSON - объект с полем "node"
+// (имя класса из ast.h) и полями узла; S-выражение - (Имя поле...).
+// Списки - массивы JSON и скобки, отсутствующие ветки и пустые имена -
+// null и nil. Вывод идёт через OutputBuffer
+void dumpAst(Program& program, AstFormat format, std::ostream& out);
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Вид узла AST: по одному значению на каждый конкретный класс узла
+// из ast.h, в том же порядке, что и методы Visitor
+enum class NodeKind : uint8_t {
+    Program,
+    MainClass,
+    ClassDeclaration,
+
+    IntType,
+    BooleanType,
+    VoidType,
+    IdentifierType,
+    ArrayType,
+
+    VariableDeclaration,
+    MethodDeclaration,
+
+    AssertStatement,
+    LocalVarDeclStatement,
+    BlockStatement,
+    IfStatement,
+    WhileStatement,
+    PrintStatement,
+    AssignStatement,
+    ReturnStatement,
+    MethodInvocationStatement,
+    ErrorStatement,
+
+    BinaryOperation,
+    UnaryOperation,
+    ArrayIndexing,
+    ArrayLength,
+    MethodInvocation,
+    FieldAccess,
+    NewArray,
+    NewObject,
+    IntegerLiteral,
+    BooleanLiteral,
+    ThisExpression,
+    IdentifierExpression,
+    ErrorExpression,
+
+    IdentifierLValue,
+    ArrayAccess,
+    SimpleFieldInvocation,
+    FieldArrayInvocation,
+};
+
+constexpr size_t kNodeKindCount = static_cast<size_t>(NodeKind::FieldArrayInvocation) + 1;
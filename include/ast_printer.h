@@ -1,284 +1,300 @@
 #pragma once
 #include "ast.h"
+#include "output_buffer.h"
+#include "static_visitor.h"
 #include <iostream>
-#include <string>
 
-class ASTPrinter : public Visitor {
+// Вывод дерева в читаемом виде с отступами. Текст идёт через
+// OutputBuffer и попадает в поток большими кусками: в конце Program
+// и при уничтожении принтера. Внутри дерева узлы выбираются через
+// StaticVisitor; Visitor нужен только для входа через accept
+class ASTPrinter final : public Visitor, public StaticVisitor<ASTPrinter> {
 private:
+    OutputBuffer out;
     int indent = 0;
-    std::string getIndent() const {
-        return std::string(indent * 2, ' ');
+    Indent getIndent() const {
+        return Indent{static_cast<size_t>(indent) * 2};
     }
     
     void increaseIndent() { indent++; }
     void decreaseIndent() { indent--; }
     
 public:
+    explicit ASTPrinter(std::ostream& out = std::cout) : out(out) {}
+    
     void visit(Program& node) override {
-        std::cout << "Program" << std::endl;
+        out << "Program" << '\n';
         increaseIndent();
         
-        std::cout << getIndent() << "MainClass:" << std::endl;
+        out << getIndent() << "MainClass:" << '\n';
         increaseIndent();
-        node.mainClass->accept(*this);
+        dispatch(*node.mainClass);
         decreaseIndent();
         
         if (!node.classes.empty()) {
-            std::cout << getIndent() << "Classes:" << std::endl;
+            out << getIndent() << "Classes:" << '\n';
             increaseIndent();
             for (auto& cls : node.classes) {
-                cls->accept(*this);
+                dispatch(*cls);
             }
             decreaseIndent();
         }
         
         decreaseIndent();
+        out.flush();
     }
     
     void visit(MainClass& node) override {
-        std::cout << getIndent() << "Class: " << node.className << std::endl;
+        out << getIndent() << "Class: " << node.className << '\n';
         
         increaseIndent();
-        std::cout << getIndent() << "main() statements:" << std::endl;
+        out << getIndent() << "main() statements:" << '\n';
         increaseIndent();
         for (auto& stmt : node.statements) {
-            stmt->accept(*this);
+            dispatch(*stmt);
         }
         decreaseIndent();
         decreaseIndent();
     }
     
     void visit(ClassDeclaration& node) override {
-        std::cout << getIndent() << "Class: " << node.className;
+        out << getIndent() << "Class: " << node.className;
         if (!node.baseClassName.empty()) {
-            std::cout << " extends " << node.baseClassName;
+            out << " extends " << node.baseClassName;
         }
-        std::cout << std::endl;
+        out << '\n';
         
         increaseIndent();
         for (auto& decl : node.declarations) {
-            decl->accept(*this);
+            dispatch(*decl);
         }
         decreaseIndent();
     }
     
     // Типы
     void visit(IntType& node) override {
-        std::cout << "int";
+        out << "int";
     }
     
     void visit(BooleanType& node) override {
-        std::cout << "boolean";
+        out << "boolean";
     }
     
     void visit(VoidType& node) override {
-        std::cout << "void";
+        out << "void";
     }
     
     void visit(IdentifierType& node) override {
-        std::cout << node.typeName;
+        out << node.typeName;
     }
     
     void visit(ArrayType& node) override {
-        node.elementType->accept(*this);
-        std::cout << "[]";
+        dispatch(*node.elementType);
+        out << "[]";
     }
     
     // Объявления
     void visit(VariableDeclaration& node) override {
-        std::cout << getIndent() << "Variable: ";
-        node.type->accept(*this);
-        std::cout << " " << node.name << std::endl;
+        out << getIndent() << "Variable: ";
+        dispatch(*node.type);
+        out << " " << node.name << '\n';
     }
     
     void visit(MethodDeclaration& node) override {
-        std::cout << getIndent() << "Method: ";
-        node.returnType->accept(*this);
-        std::cout << " " << node.name << "(";
+        out << getIndent() << "Method: ";
+        dispatch(*node.returnType);
+        out << " " << node.name << "(";
         
         // Параметры
         for (size_t i = 0; i < node.parameters.size(); i++) {
-            if (i > 0) std::cout << ", ";
-            node.parameters[i]->type->accept(*this);
-            std::cout << " " << node.parameters[i]->name;
+            if (i > 0) out << ", ";
+            dispatch(*node.parameters[i]->type);
+            out << " " << node.parameters[i]->name;
         }
-        std::cout << ")" << std::endl;
+        out << ")" << '\n';
         
         increaseIndent();
         for (auto& stmt : node.statements) {
-            stmt->accept(*this);
+            dispatch(*stmt);
         }
         decreaseIndent();
     }
     
     // Операторы
     void visit(AssertStatement& node) override {
-        std::cout << getIndent() << "Assert(" << std::endl;
+        out << getIndent() << "Assert(" << '\n';
         increaseIndent();
-        node.condition->accept(*this);
+        dispatch(*node.condition);
         decreaseIndent();
-        std::cout << getIndent() << ")" << std::endl;
+        out << getIndent() << ")" << '\n';
     }
     
     void visit(LocalVarDeclStatement& node) override {
-        node.declaration->accept(*this);
+        dispatch(*node.declaration);
     }
     
     void visit(BlockStatement& node) override {
-        std::cout << getIndent() << "Block {" << std::endl;
+        out << getIndent() << "Block {" << '\n';
         increaseIndent();
         for (auto& stmt : node.statements) {
-            stmt->accept(*this);
+            dispatch(*stmt);
         }
         decreaseIndent();
-        std::cout << getIndent() << "}" << std::endl;
+        out << getIndent() << "}" << '\n';
     }
     
     void visit(IfStatement& node) override {
-        std::cout << getIndent() << "If (" << std::endl;
+        out << getIndent() << "If (" << '\n';
         increaseIndent();
-        node.condition->accept(*this);
+        dispatch(*node.condition);
         decreaseIndent();
-        std::cout << getIndent() << ") Then" << std::endl;
+        out << getIndent() << ") Then" << '\n';
         
         increaseIndent();
-        node.thenStatement->accept(*this);
+        dispatch(*node.thenStatement);
         decreaseIndent();
         
         if (node.elseStatement) {
-            std::cout << getIndent() << "Else" << std::endl;
+            out << getIndent() << "Else" << '\n';
             increaseIndent();
-            node.elseStatement->accept(*this);
+            dispatch(*node.elseStatement);
             decreaseIndent();
         }
     }
     
     void visit(WhileStatement& node) override {
-        std::cout << getIndent() << "While (" << std::endl;
+        out << getIndent() << "While (" << '\n';
         increaseIndent();
-        node.condition->accept(*this);
+        dispatch(*node.condition);
         decreaseIndent();
-        std::cout << getIndent() << ")" << std::endl;
+        out << getIndent() << ")" << '\n';
         
         increaseIndent();
-        node.body->accept(*this);
+        dispatch(*node.body);
         decreaseIndent();
     }
     
     void visit(PrintStatement& node) override {
-        std::cout << getIndent() << "System.out.println(" << std::endl;
+        out << getIndent() << "System.out.println(" << '\n';
         increaseIndent();
-        node.expression->accept(*this);
+        dispatch(*node.expression);
         decreaseIndent();
-        std::cout << getIndent() << ")" << std::endl;
+        out << getIndent() << ")" << '\n';
     }
     
     void visit(AssignStatement& node) override {
-        std::cout << getIndent() << "Assign:" << std::endl;
+        out << getIndent() << "Assign:" << '\n';
         increaseIndent();
-        std::cout << getIndent() << "LValue: " << std::endl;
+        out << getIndent() << "LValue: " << '\n';
         increaseIndent();
-        node.lvalue->accept(*this);
+        dispatch(*node.lvalue);
         decreaseIndent();
         
-        std::cout << getIndent() << "= " << std::endl;
+        out << getIndent() << "= " << '\n';
         increaseIndent();
-        node.expression->accept(*this);
+        dispatch(*node.expression);
         decreaseIndent();
         decreaseIndent();
     }
     
     void visit(ReturnStatement& node) override {
-        std::cout << getIndent() << "Return:" << std::endl;
+        out << getIndent() << "Return:" << '\n';
         increaseIndent();
-        node.expression->accept(*this);
+        dispatch(*node.expression);
         decreaseIndent();
     }
     
     void visit(MethodInvocationStatement& node) override {
-        std::cout << getIndent() << "Method Call:" << std::endl;
+        out << getIndent() << "Method Call:" << '\n';
         increaseIndent();
-        node.invocation->accept(*this);
+        dispatch(*node.invocation);
         decreaseIndent();
     }
     
+    void visit(ErrorStatement&) override {
+        out << getIndent() << "<ошибка>" << '\n';
+    }
+    
     // Выражения
     void visit(BinaryOperation& node) override {
-        std::cout << getIndent() << "BinaryOp ";
+        out << getIndent() << "BinaryOp ";
         switch (node.op) {
-            case BinaryOperator::AND: std::cout << "&&"; break;
-            case BinaryOperator::OR: std::cout << "||"; break;
-            case BinaryOperator::LESS: std::cout << "<"; break;
-            case BinaryOperator::GREATER: std::cout << ">"; break;
-            case BinaryOperator::EQUAL: std::cout << "=="; break;
-            case BinaryOperator::PLUS: std::cout << "+"; break;
-            case BinaryOperator::MINUS: std::cout << "-"; break;
-            case BinaryOperator::MULTIPLY: std::cout << "*"; break;
-            case BinaryOperator::DIVIDE: std::cout << "/"; break;
-            case BinaryOperator::MODULO: std::cout << "%"; break;
+            case BinaryOperator::AND: out << "&&"; break;
+            case BinaryOperator::OR: out << "||"; break;
+            case BinaryOperator::LESS: out << "<"; break;
+            case BinaryOperator::GREATER: out << ">"; break;
+            case BinaryOperator::EQUAL: out << "=="; break;
+            case BinaryOperator::PLUS: out << "+"; break;
+            case BinaryOperator::MINUS: out << "-"; break;
+            case BinaryOperator::MULTIPLY: out << "*"; break;
+            case BinaryOperator::DIVIDE: out << "/"; break;
+            case BinaryOperator::MODULO: out << "%"; break;
+            case BinaryOperator::NOT_EQUAL: out << "!="; break;
+            case BinaryOperator::LESS_EQUAL: out << "<="; break;
+            case BinaryOperator::GREATER_EQUAL: out << ">="; break;
         }
-        std::cout << std::endl;
+        out << '\n';
         
         increaseIndent();
-        std::cout << getIndent() << "Left: " << std::endl;
+        out << getIndent() << "Left: " << '\n';
         increaseIndent();
-        node.left->accept(*this);
+        dispatch(*node.left);
         decreaseIndent();
         
-        std::cout << getIndent() << "Right: " << std::endl;
+        out << getIndent() << "Right: " << '\n';
         increaseIndent();
-        node.right->accept(*this);
+        dispatch(*node.right);
         decreaseIndent();
         decreaseIndent();
     }
     
     void visit(UnaryOperation& node) override {
-        std::cout << getIndent() << "UnaryOp ";
+        out << getIndent() << "UnaryOp ";
         switch (node.op) {
-            case UnaryOperator::NOT: std::cout << "!"; break;
+            case UnaryOperator::NOT: out << "!"; break;
         }
-        std::cout << std::endl;
+        out << '\n';
         
         increaseIndent();
-        node.expression->accept(*this);
+        dispatch(*node.expression);
         decreaseIndent();
     }
     
     void visit(ArrayIndexing& node) override {
-        std::cout << getIndent() << "ArrayIndex:" << std::endl;
+        out << getIndent() << "ArrayIndex:" << '\n';
         increaseIndent();
-        std::cout << getIndent() << "Array:" << std::endl;
+        out << getIndent() << "Array:" << '\n';
         increaseIndent();
-        node.array->accept(*this);
+        dispatch(*node.array);
         decreaseIndent();
         
-        std::cout << getIndent() << "Index:" << std::endl;
+        out << getIndent() << "Index:" << '\n';
         increaseIndent();
-        node.index->accept(*this);
+        dispatch(*node.index);
         decreaseIndent();
         decreaseIndent();
     }
     
     void visit(ArrayLength& node) override {
-        std::cout << getIndent() << "ArrayLength:" << std::endl;
+        out << getIndent() << "ArrayLength:" << '\n';
         increaseIndent();
-        node.array->accept(*this);
+        dispatch(*node.array);
         decreaseIndent();
     }
     
     void visit(MethodInvocation& node) override {
-        std::cout << getIndent() << "MethodInvocation: " << node.methodName << "()" << std::endl;
+        out << getIndent() << "MethodInvocation: " << node.methodName << "()" << '\n';
         increaseIndent();
-        std::cout << getIndent() << "Object:" << std::endl;
+        out << getIndent() << "Object:" << '\n';
         increaseIndent();
-        node.object->accept(*this);
+        dispatch(*node.object);
         decreaseIndent();
         
         if (!node.arguments.empty()) {
-            std::cout << getIndent() << "Arguments:" << std::endl;
+            out << getIndent() << "Arguments:" << '\n';
             increaseIndent();
             for (auto& arg : node.arguments) {
-                arg->accept(*this);
+                dispatch(*arg);
             }
             decreaseIndent();
         }
@@ -286,63 +302,67 @@ public:
     }
     
     void visit(FieldAccess& node) override {
-        std::cout << getIndent() << "FieldAccess: " << node.fieldName << std::endl;
+        out << getIndent() << "FieldAccess: " << node.fieldName << '\n';
         increaseIndent();
-        node.object->accept(*this);
+        dispatch(*node.object);
         decreaseIndent();
     }
     
     void visit(NewArray& node) override {
-        std::cout << getIndent() << "NewArray: ";
-        node.elementType->accept(*this);
-        std::cout << "[" << std::endl;
+        out << getIndent() << "NewArray: ";
+        dispatch(*node.elementType);
+        out << "[" << '\n';
         increaseIndent();
-        node.size->accept(*this);
+        dispatch(*node.size);
         decreaseIndent();
-        std::cout << getIndent() << "]" << std::endl;
+        out << getIndent() << "]" << '\n';
     }
     
     void visit(NewObject& node) override {
-        std::cout << getIndent() << "NewObject: " << node.className << "()" << std::endl;
+        out << getIndent() << "NewObject: " << node.className << "()" << '\n';
     }
     
     void visit(IntegerLiteral& node) override {
-        std::cout << getIndent() << "IntegerLiteral: " << node.value << std::endl;
+        out << getIndent() << "IntegerLiteral: " << node.value << '\n';
     }
     
     void visit(BooleanLiteral& node) override {
-        std::cout << getIndent() << "BooleanLiteral: " << (node.value ? "true" : "false") << std::endl;
+        out << getIndent() << "BooleanLiteral: " << (node.value ? "true" : "false") << '\n';
     }
     
     void visit(ThisExpression& node) override {
-        std::cout << getIndent() << "This" << std::endl;
+        out << getIndent() << "This" << '\n';
     }
     
     void visit(IdentifierExpression& node) override {
-        std::cout << getIndent() << "Identifier: " << node.name << std::endl;
+        out << getIndent() << "Identifier: " << node.name << '\n';
+    }
+    
+    void visit(ErrorExpression&) override {
+        out << getIndent() << "<ошибка>" << '\n';
     }
     
     void visit(IdentifierLValue& node) override {
-        std::cout << getIndent() << "Identifier: " << node.name << std::endl;
+        out << getIndent() << "Identifier: " << node.name << '\n';
     }
     
     void visit(ArrayAccess& node) override {
-        std::cout << getIndent() << "ArrayAccess: " << node.arrayName << "[" << std::endl;
+        out << getIndent() << "ArrayAccess: " << node.arrayName << "[" << '\n';
         increaseIndent();
-        node.index->accept(*this);
+        dispatch(*node.index);
         decreaseIndent();
-        std::cout << getIndent() << "]" << std::endl;
+        out << getIndent() << "]" << '\n';
     }
     
     void visit(SimpleFieldInvocation& node) override {
-        std::cout << getIndent() << "this." << node.fieldName << std::endl;
+        out << getIndent() << "this." << node.fieldName << '\n';
     }
     
     void visit(FieldArrayInvocation& node) override {
-        std::cout << getIndent() << "this." << node.fieldName << "[" << std::endl;
+        out << getIndent() << "this." << node.fieldName << "[" << '\n';
         increaseIndent();
-        node.index->accept(*this);
+        dispatch(*node.index);
         decreaseIndent();
-        std::cout << getIndent() << "]" << std::endl;
+        out << getIndent() << "]" << '\n';
     }
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class CompileCache;
+
+// Пакетная компиляция: много файлов за один запуск процесса.
+// Файлы разбираются параллельно (runWorkStealing из parallel.h), каждый -
+// теми же фазами, что и одиночный файл (CompileDriver::runStages), с
+// последовательными лексером и парсером в режиме восстановления.
+// Сообщения об ошибках файла собираются в буфер и выводятся одним куском
+// в порядке входного списка, как только готовы этот файл и все
+// предыдущие, поэтому вывод не зависит от числа потоков.
+// AST в пакетном режиме не печатается
+class BatchCompiler {
+public:
+    struct Options {
+        unsigned jobs = 0;              // потоков; 0 - по числу ядер
+        bool emitBinary = false;        // записать <файл>.ast для файлов без ошибок
+        CompileCache* cache = nullptr;  // общий кэш; может отсутствовать
+    };
+
+    // Итоги пакета. Время фаз - сумма по всем файлам (то есть по всем
+    // потокам), общее время - от начала до конца пакета
+    struct Summary {
+        size_t files = 0;
+        size_t failed = 0;
+        size_t cacheHits = 0;
+        uint64_t tokens = 0;
+        unsigned threads = 0;
+        double readSeconds = 0;
+        double parseSeconds = 0;  // лексер и парсер: токены читаются по ходу разбора
+        double semanticSeconds = 0;
+        double cacheSeconds = 0;  // кэш и сериализация дерева
+        double emitSeconds = 0;
+        double wallSeconds = 0;
+    };
+
+    explicit BatchCompiler(Options options) : options(options) {}
+
+    // Нужен ли пакетный режим для этих аргументов: больше одного файла,
+    // каталог или список @файл
+    static bool needsBatch(const std::vector<std::string>& arguments);
+
+    // Список файлов по аргументам: каталоги обходятся рекурсивно (файлы
+    // .java в порядке имён), @файл содержит по одному пути в строке
+    // (пустые строки и строки с # пропускаются). Остальные аргументы
+    // берутся как есть. При ошибке бросает std::runtime_error
+    static std::vector<std::string> expandInputs(const std::vector<std::string>& arguments);
+
+    // Компилирует files; сообщения об ошибках выводятся в diagnostics
+    Summary run(const std::vector<std::string>& files, std::ostream& diagnostics);
+
+    static void printSummary(const Summary& summary, std::ostream& out);
+
+private:
+    Options options;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "parser.h"
+
+// Кэш результатов компиляции на диске, адресуемый содержимым.
+// Ключ - хеш XXH64 текста исходника, версии компилятора и ключей,
+// влияющих на результат; запись лежит в файле <каталог>/<ключ>.mjc.
+// Запись хранит всё, что иначе дали бы лексер и парсер: число токенов,
+// диагностики и дерево в формате ast_binary.h, а также размер и хеш
+// исходника, так что совпадение ключей разных текстов обнаруживается
+// при чтении и считается промахом.
+// Записи пишутся через временный файл и rename, так что несколько
+// процессов могут пользоваться одним каталогом одновременно. Время
+// изменения файла записи обновляется при каждом попадании; когда
+// суммарный размер превышает предел, удаляются записи, которые дольше
+// всех не использовались (LRU). Счётчики попаданий и промахов хранятся
+// в файле stats того же каталога и обновляются под flock
+class CompileCache {
+public:
+    // Меняется при любом изменении вывода компилятора, чтобы старые
+    // записи не выдавались за новые
+    static constexpr uint32_t kCompilerVersion = 2;
+
+    // Ключи драйвера, от которых зависит результат разбора (разбор всегда
+    // идёт в режиме восстановления); --jobs на результат не влияет
+    static constexpr const char* kDriverOptions = "recovery";
+
+    // Предел размера по умолчанию
+    static constexpr uint64_t kDefaultMaxBytes = 1ull << 30;
+
+    // Результат разбора одного файла
+    struct Entry {
+        uint64_t tokenCount = 0;
+        // Ошибки разбора, а если их нет - семантического анализа (у них
+        // line и column равны 0)
+        std::vector<Parser::Diagnostic> diagnostics;
+        std::string ast;  // файл AstBinary; пуст, если были ошибки
+    };
+
+    // Счётчики за всё время жизни каталога
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+        uint64_t bytes = 0;  // размер записей по оценке; уточняется при вытеснении
+    };
+
+    // Создаёт каталог, если его нет. При ошибке бросает std::runtime_error
+    explicit CompileCache(std::string directory, uint64_t maxBytes = kDefaultMaxBytes);
+
+    // Ключ для исходника source; options - ключи компилятора в каноническом
+    // виде (только те, от которых зависит результат)
+    static uint64_t makeKey(std::string_view source, std::string_view options);
+
+    // Ищет запись по ключу и проверяет, что она построена по source.
+    // Повреждённая запись удаляется и считается промахом
+    bool lookup(uint64_t key, std::string_view source, Entry& entry);
+
+    // Сохраняет запись для исходника source и, если кэш стал больше
+    // предела, вытесняет старые
+    void store(uint64_t key, std::string_view source, const Entry& entry);
+
+    // Удаляет самые давние записи, пока размер не станет не больше
+    // трёх четвертей предела (запас, чтобы не вытеснять при каждой записи).
+    // Возвращает число удалённых записей
+    size_t evict();
+
+    Stats stats() const;
+
+    const std::string& directory() const { return root; }
+    std::string pathFor(uint64_t key) const;
+
+private:
+    std::string root;
+    uint64_t maxBytes;
+
+    // Чтение-изменение-запись файла stats под исключительной блокировкой
+    template <typename F>
+    void updateStats(F&& update);
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ast_dump.h"
+#include "compile_cache.h"
+#include "parser.h"
+
+class SourceBuffer;
+
+// Компиляция одного файла так, как её выполняет minijava_compiler:
+// чтение, кэш, лексер и парсер, запись .ast и вывод AST. Общий путь для
+// main, сервера компиляции (server.h) и пакетного режима (batch.h,
+// только runStages); вывод идёт в переданные потоки,
+// поэтому одновременно может работать несколько драйверов
+class CompileDriver {
+public:
+    struct Options {
+        bool parallel = false;      // параллельные лексер и парсер (--jobs)
+        unsigned jobs = 0;          // 0 - по числу ядер
+        bool emitBinary = false;    // --emit-ast=bin
+        std::string output;         // путь .ast; пуст - <файл>.ast
+        AstFormat format = AstFormat::Tree;  // --dump-ast; в JSON и S-выражениях
+                                             // печатается только дерево
+    };
+
+    // cache может отсутствовать; при ошибке кэша компиляция идёт без него
+    CompileDriver(Options options, CompileCache* cache) : options(std::move(options)), cache(cache) {}
+
+    // Компилирует файл path ("-" - стандартный ввод). Результат печатается
+    // в out, ошибки - в err; возвращает код завершения процесса
+    int compile(const std::string& path, std::ostream& out, std::ostream& err);
+
+    // То же для уже прочитанного текста; name - имя файла для пути .ast
+    // по умолчанию ("-" - имени нет)
+    int compile(const std::string& name, const SourceBuffer& source, std::ostream& out, std::ostream& err);
+
+    // Результат фаз компиляции до вывода
+    struct Stages {
+        CompileCache::Entry entry;          // ast - только если есть кэш или emitBinary
+        std::unique_ptr<Program> program;   // nullptr, если запись взята из кэша
+        bool cached = false;
+        std::string cacheError;             // пусто - кэш работал; иначе он отключён
+        double parseSeconds = 0;            // лексер и парсер
+        double semanticSeconds = 0;
+        double cacheSeconds = 0;            // кэш и сериализация дерева
+    };
+
+    // Кэш, лексер и парсер, семантический анализ (только для
+    // синтаксически верной программы), сериализация дерева и запись
+    // в кэш. Ошибка кэша не прерывает компиляцию; остальные ошибки
+    // бросаются исключением
+    Stages runStages(const SourceBuffer& source) const;
+
+private:
+    Options options;
+    CompileCache* cache;
+};
@@ -0,0 +1,314 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "ast.h"
+#include "ast_kind.h"
+#include "symbol.h"
+
+// Плоское представление AST: узлы - это 32-битные номера, а не объекты.
+// Для каждого узла хранятся вид и номер записи (slot) в пуле этого вида;
+// поля узлов одного вида лежат в отдельных массивах пула (SoA), дети -
+// номерами, списки детей - диапазонами в общем массиве lists.
+// Номера узлов идут в прямом порядке обхода, поэтому проход по дереву
+// идёт по массивам почти подряд, а проход, которому нужны узлы одного
+// вида (например, все литералы), перебирает пул линейно, без рекурсии.
+// Нет ни указателей, ни виртуальных вызовов: дерево можно копировать
+// и сохранять как набор массивов
+class FlatAst {
+public:
+    using NodeId = uint32_t;
+
+    // Отсутствующий ребёнок: пустая ветка else, индекс в ArrayIndexing
+    static constexpr NodeId kNone = UINT32_MAX;
+
+    // Список детей: count номеров в lists, начиная с begin
+    struct Range {
+        uint32_t begin = 0;
+        uint32_t count = 0;
+    };
+
+    // Пулы по видам узлов. Виды без полей (IntType, BooleanType,
+    // VoidType, ThisExpression, ErrorStatement, ErrorExpression) пула
+    // не имеют
+    struct MainClasses {
+        std::vector<Symbol> name;
+        std::vector<Range> statements;
+    };
+    struct ClassDeclarations {
+        std::vector<Symbol> name;
+        std::vector<Symbol> baseName;
+        std::vector<Range> declarations;
+    };
+    struct IdentifierTypes {
+        std::vector<Symbol> name;
+    };
+    struct ArrayTypes {
+        std::vector<NodeId> elementType;
+    };
+    struct VariableDeclarations {
+        std::vector<NodeId> type;
+        std::vector<Symbol> name;
+    };
+    struct MethodDeclarations {
+        std::vector<NodeId> returnType;
+        std::vector<Symbol> name;
+        std::vector<Range> parameters;
+        std::vector<Range> statements;
+    };
+    struct Blocks {
+        std::vector<Range> statements;
+    };
+    struct IfStatements {
+        std::vector<NodeId> condition;
+        std::vector<NodeId> thenStatement;
+        std::vector<NodeId> elseStatement;
+    };
+    struct WhileStatements {
+        std::vector<NodeId> condition;
+        std::vector<NodeId> body;
+    };
+    struct AssignStatements {
+        std::vector<NodeId> lvalue;
+        std::vector<NodeId> expression;
+    };
+    // Операторы с одним ребёнком: assert, объявление переменной,
+    // вывод, return, вызов метода
+    struct UnaryStatements {
+        std::vector<NodeId> child;
+    };
+    struct BinaryOperations {
+        std::vector<BinaryOperator> op;
+        std::vector<NodeId> left;
+        std::vector<NodeId> right;
+    };
+    struct UnaryOperations {
+        std::vector<UnaryOperator> op;
+        std::vector<NodeId> operand;
+    };
+    struct ArrayIndexings {
+        std::vector<NodeId> array;
+        std::vector<NodeId> index;
+    };
+    struct ArrayLengths {
+        std::vector<NodeId> array;
+    };
+    struct MethodInvocations {
+        std::vector<NodeId> object;
+        std::vector<Symbol> name;
+        std::vector<Range> arguments;
+    };
+    struct FieldAccesses {
+        std::vector<NodeId> object;
+        std::vector<Symbol> name;
+    };
+    struct NewArrays {
+        std::vector<NodeId> elementType;
+        std::vector<NodeId> size;
+    };
+    struct IntegerLiterals {
+        std::vector<int32_t> value;
+    };
+    struct BooleanLiterals {
+        std::vector<uint8_t> value;  // 0 или 1
+    };
+    // Узлы, у которых есть только имя: NewObject, IdentifierExpression,
+    // IdentifierLValue, SimpleFieldInvocation
+    struct Names {
+        std::vector<Symbol> name;
+    };
+    // Имя и индекс: ArrayAccess, FieldArrayInvocation
+    struct IndexedNames {
+        std::vector<Symbol> name;
+        std::vector<NodeId> index;
+    };
+
+    // Вид каждого узла и номер его записи в пуле вида
+    std::vector<NodeKind> kinds;
+    std::vector<uint32_t> slots;
+
+    // Общий массив для всех списков детей
+    std::vector<NodeId> lists;
+
+    // Корень: главный класс и остальные классы
+    NodeId mainClass = kNone;
+    Range classes;
+
+    MainClasses mainClasses;
+    ClassDeclarations classDeclarations;
+    IdentifierTypes identifierTypes;
+    ArrayTypes arrayTypes;
+    VariableDeclarations variables;
+    MethodDeclarations methods;
+    Blocks blocks;
+    IfStatements ifStatements;
+    WhileStatements whileStatements;
+    AssignStatements assignStatements;
+    UnaryStatements unaryStatements;
+    BinaryOperations binaryOperations;
+    UnaryOperations unaryOperations;
+    ArrayIndexings arrayIndexings;
+    ArrayLengths arrayLengths;
+    MethodInvocations methodInvocations;
+    FieldAccesses fieldAccesses;
+    NewArrays newArrays;
+    IntegerLiterals integerLiterals;
+    BooleanLiterals booleanLiterals;
+    Names names;
+    IndexedNames indexedNames;
+
+    // Преобразование дерева из объектов. Program не изменяется; ссылка
+    // неконстантная только потому, что обход идёт через Visitor
+    static FlatAst fromProgram(Program& program);
+
+    // Обратное преобразование: дерево объектов в новой арене
+    std::unique_ptr<Program> toProgram() const;
+
+    // Совместимость с существующими проходами: строит дерево объектов
+    // (toProgram, со всеми его выделениями) и обходит его посетителем.
+    // Visitor получает объекты узлов и спускается к детям по указателям,
+    // поэтому без дерева объектов его не вызвать. Проходам, которым
+    // важна скорость, нужно работать с пулами и forEachChild напрямую
+    void materializeAndAccept(Visitor& visitor) const;
+
+    size_t nodeCount() const { return kinds.size(); }
+    NodeKind kind(NodeId id) const { return kinds[id]; }
+    uint32_t slot(NodeId id) const { return slots[id]; }
+
+    const NodeId* begin(Range range) const { return lists.data() + range.begin; }
+    const NodeId* end(Range range) const { return lists.data() + range.begin + range.count; }
+
+    // Вызывает f(child) для каждого ребёнка узла id в порядке исходного
+    // текста; отсутствующие дети пропускаются
+    template <typename F>
+    void forEachChild(NodeId id, F&& f) const;
+
+    // Вызывает f(columns...) для каждого пула с массивами его полей.
+    // Порядок пулов и полей постоянный и входит в двоичный формат
+    // (ast_binary.h): при его изменении меняется версия формата
+    template <typename F>
+    void forEachPool(F&& f) { forEachPool(*this, f); }
+    template <typename F>
+    void forEachPool(F&& f) const { forEachPool(*this, f); }
+
+    // Число записей в пуле вида kind (1 для видов без пула)
+    size_t poolSize(NodeKind kind) const;
+
+    // Предел глубины дерева, которое принимает validate: toProgram
+    // и обходы рекурсивны. С запасом больше глубины, которую строит
+    // парсер (Parser::kMaxExpressionDepth плюс вложенность операторов)
+    static constexpr uint32_t kMaxDepth = 1 << 14;
+
+    // Проверяет, что все номера и диапазоны в границах массивов, дети
+    // идут после родителей (значит, циклов нет), у каждого узла, кроме
+    // главного класса, ровно один родитель (узел из списка классов
+    // считается ребёнком списка), глубина не больше kMaxDepth, вид каждого ребёнка
+    // подходит его полю (на месте условия - выражение, в списке классов -
+    // ClassDeclaration), обязательные дети есть, а операторы и логические
+    // значения в своих диапазонах. После неё обход, forEachChild
+    // и toProgram безопасны. При нарушении бросает std::runtime_error
+    void validate() const;
+
+    // Байт занято массивами дерева (без запаса ёмкости)
+    size_t bytesUsed() const;
+
+private:
+    template <typename Ast, typename F>
+    static void forEachPool(Ast& ast, F& f);
+};
+
+template <typename Ast, typename F>
+void FlatAst::forEachPool(Ast& ast, F& f) {
+    f(ast.mainClasses.name, ast.mainClasses.statements);
+    f(ast.classDeclarations.name, ast.classDeclarations.baseName, ast.classDeclarations.declarations);
+    f(ast.identifierTypes.name);
+    f(ast.arrayTypes.elementType);
+    f(ast.variables.type, ast.variables.name);
+    f(ast.methods.returnType, ast.methods.name, ast.methods.parameters, ast.methods.statements);
+    f(ast.blocks.statements);
+    f(ast.ifStatements.condition, ast.ifStatements.thenStatement, ast.ifStatements.elseStatement);
+    f(ast.whileStatements.condition, ast.whileStatements.body);
+    f(ast.assignStatements.lvalue, ast.assignStatements.expression);
+    f(ast.unaryStatements.child);
+    f(ast.binaryOperations.op, ast.binaryOperations.left, ast.binaryOperations.right);
+    f(ast.unaryOperations.op, ast.unaryOperations.operand);
+    f(ast.arrayIndexings.array, ast.arrayIndexings.index);
+    f(ast.arrayLengths.array);
+    f(ast.methodInvocations.object, ast.methodInvocations.name, ast.methodInvocations.arguments);
+    f(ast.fieldAccesses.object, ast.fieldAccesses.name);
+    f(ast.newArrays.elementType, ast.newArrays.size);
+    f(ast.integerLiterals.value);
+    f(ast.booleanLiterals.value);
+    f(ast.names.name);
+    f(ast.indexedNames.name, ast.indexedNames.index);
+}
+
+template <typename F>
+void FlatAst::forEachChild(NodeId id, F&& f) const {
+    auto one = [&f](NodeId child) {
+        if (child != kNone) f(child);
+    };
+    auto all = [this, &f](Range range) {
+        for (const NodeId* it = begin(range); it != end(range); ++it) f(*it);
+    };
+
+    uint32_t s = slots[id];
+    switch (kinds[id]) {
+        case NodeKind::MainClass: all(mainClasses.statements[s]); break;
+        case NodeKind::ClassDeclaration: all(classDeclarations.declarations[s]); break;
+        case NodeKind::ArrayType: one(arrayTypes.elementType[s]); break;
+        case NodeKind::VariableDeclaration: one(variables.type[s]); break;
+        case NodeKind::MethodDeclaration:
+            one(methods.returnType[s]);
+            all(methods.parameters[s]);
+            all(methods.statements[s]);
+            break;
+        case NodeKind::AssertStatement:
+        case NodeKind::LocalVarDeclStatement:
+        case NodeKind::PrintStatement:
+        case NodeKind::ReturnStatement:
+        case NodeKind::MethodInvocationStatement:
+            one(unaryStatements.child[s]);
+            break;
+        case NodeKind::BlockStatement: all(blocks.statements[s]); break;
+        case NodeKind::IfStatement:
+            one(ifStatements.condition[s]);
+            one(ifStatements.thenStatement[s]);
+            one(ifStatements.elseStatement[s]);
+            break;
+        case NodeKind::WhileStatement:
+            one(whileStatements.condition[s]);
+            one(whileStatements.body[s]);
+            break;
+        case NodeKind::AssignStatement:
+            one(assignStatements.lvalue[s]);
+            one(assignStatements.expression[s]);
+            break;
+        case NodeKind::BinaryOperation:
+            one(binaryOperations.left[s]);
+            one(binaryOperations.right[s]);
+            break;
+        case NodeKind::UnaryOperation: one(unaryOperations.operand[s]); break;
+        case NodeKind::ArrayIndexing:
+            one(arrayIndexings.array[s]);
+            one(arrayIndexings.index[s]);
+            break;
+        case NodeKind::ArrayLength: one(arrayLengths.array[s]); break;
+        case NodeKind::MethodInvocation:
+            one(methodInvocations.object[s]);
+            all(methodInvocations.arguments[s]);
+            break;
+        case NodeKind::FieldAccess: one(fieldAccesses.object[s]); break;
+        case NodeKind::NewArray:
+            one(newArrays.elementType[s]);
+            one(newArrays.size[s]);
+            break;
+        case NodeKind::ArrayAccess:
+        case NodeKind::FieldArrayInvocation:
+            one(indexedNames.index[s]);
+            break;
+        default:
+            break;
+    }
+}
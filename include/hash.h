@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 64-битный некриптографический хеш XXH64 (совместим с эталонным xxHash).
+// Около 10 ГБ/с на длинных входах; используется как отпечаток исходника
+// У варианта с указателем нет seed по умолчанию, чтобы вызов
+// xxh64("abc", 1) не принял seed за размер
+uint64_t xxh64(const void* data, size_t size, uint64_t seed);
+
+inline uint64_t xxh64(std::string_view text, uint64_t seed = 0) {
+    return xxh64(text.data(), text.size(), seed);
+}
@@ -1,38 +1,111 @@
 #pragma once
 #include "token.h"
+#include "source_buffer.h"
+#include "scan.h"
+#include "symbol.h"
+#include "token_stream.h"
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 
+// Лексер не копирует исходник: он и лексемы токенов ссылаются на
+// переданный буфер, который должен жить дольше них
 class Lexer {
 public:
-    Lexer(const std::string& source);
+    Lexer(std::string_view source);
+    Lexer(const SourceBuffer& buffer);
     Token getNextToken();
     std::vector<Token> tokenize();
 
+    // Компактный поток (структура массивов) без строк и столбцов:
+    // лексер не ведёт их учёт, они вычисляются по смещению при надобности
+    TokenStream tokenizeCompact();
+
+    // То же, что tokenize(), но текст делится на фрагменты, которые
+    // разбираются параллельно в threads потоках (0 - по числу ядер).
+    // Фрагменты короче minChunkSize не выделяются. Результат совпадает
+    // с tokenize() независимо от числа потоков
+    std::vector<Token> tokenizeParallel(unsigned threads = 0,
+                                        size_t minChunkSize = 256 * 1024);
+
+    // Результат relex: токены [first, first + removed) старого потока
+    // заменены на [first, first + inserted)
+    struct Relexed {
+        size_t first;
+        size_t removed;
+        size_t inserted;
+    };
+
+    // Обновляет поток tokens, полученный tokenizeCompact() для текста до
+    // правки edit, так, чтобы он совпадал с tokenizeCompact() для текста
+    // этого лексера (текста после правки). Заново разбирается участок от
+    // последнего не затронутого правкой токена до первого совпадения
+    // со старым потоком
+    Relexed relex(TokenStream& tokens, const TextEdit& edit);
+
 private:
-    std::string source;
+    // Состояние лексера на границе фрагмента: незакрытый комментарий
+    // и признак afterOperand
+    struct State {
+        int blockDepth = 0;        // Глубина вложенности блочного комментария
+        bool lineComment = false;  // Внутри строчного комментария
+        bool afterOperand = false;
+
+        bool operator==(const State& other) const {
+            return blockDepth == other.blockDepth &&
+                   lineComment == other.lineComment &&
+                   afterOperand == other.afterOperand;
+        }
+    };
+
+    struct Chunk;
+
+    // Лексер фрагмента [begin, source.size()), начинающий в состоянии entry.
+    // Строки считаются от begin: первая строка фрагмента имеет номер 1,
+    // а столбцы на ней отсчитываются от begin
+    Lexer(std::string_view source, size_t begin, const State& entry);
+
+    // Разбор фрагмента до его конца; EOF в результат не попадает,
+    // если keepEof == false
+    std::vector<Token> lexChunk(bool keepEof, State& exit);
+    // Повторный разбор фрагмента в истинном начальном состоянии
+    void repairChunk(Chunk& chunk, const State& entry, bool last) const;
+
+    std::string_view source;
+    size_t start = 0;     // Начало текущего токена
     size_t position = 0;
-    size_t currentLine = 1;
-    size_t currentColumn = 1;
+    const char* errorMessage = nullptr;  // Сообщение для токена ERROR
+    int32_t literalValue = 0;            // Значение INTEGER_LITERAL
+    // Предыдущий токен завершает операнд: '-' после него - бинарный минус,
+    // а не знак отрицательного литерала
+    bool afterOperand = false;
+    // Строки досчитываются лениво в getNextToken, столбец - смещение
+    // от начала текущей строки
+    scan::LineCursor lines;
+    // Комментарий, не закрытый к концу текста. Важно только для
+    // фрагментов при параллельном разборе
+    int openBlockComments = 0;
+    bool openLineComment = false;
+    // Идентификаторы сразу переводятся в номера имён
+    SymbolCache symbols;
     
-    std::unordered_map<std::string, TokenType> keywords;
-    
-    char peek() const;
-    char advance();
     bool isAtEnd() const;
     
-    Token makeToken(TokenType type, const std::string& lexeme);
-    Token errorToken(const std::string& message);
+    TokenType scanToken();
+    TokenType dispatchToken();
+    TokenType errorToken(const char* message);
+    // Добавляет в поток только что распознанный токен [start, position)
+    void pushToken(TokenStream& stream, TokenType type);
     
     void skipWhitespace();
     bool match(char expected);
     
-    Token identifier();
-    Token number();
+    TokenType identifier();
+    TokenType number();
     
     bool skipLineComment();
     bool skipBlockComment();
-    
-    void initKeywords();
+    void skipLineCommentBody();
+    void skipBlockCommentBody(int nestingLevel);
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <memory>
+#include "symbol.h"
+
+// Отступ: out << Indent{n} пишет n пробелов
+struct Indent {
+    size_t width;
+};
+
+// Буфер вывода для больших дампов. Текст копируется в буфер и уходит
+// в поток одним вызовом write, только когда буфер заполнен, и при
+// flush(), а не на каждой строке, как с std::endl. Отступы берутся
+// из статического блока пробелов, числа форматируются без std::ostream.
+// Буфер выделяется один раз и используется повторно
+class OutputBuffer {
+public:
+    static constexpr size_t kCapacity = 1 << 20;
+
+    explicit OutputBuffer(std::ostream& out) : out(out), buffer(new char[kCapacity]) {}
+    ~OutputBuffer() { flush(); }
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    OutputBuffer& operator<<(std::string_view text) {
+        if (text.size() > kCapacity - used) return writeSlow(text);
+        std::memcpy(buffer.get() + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+
+    OutputBuffer& operator<<(const char* text) { return *this << std::string_view(text); }
+    OutputBuffer& operator<<(Symbol symbol) { return *this << symbol.str(); }
+
+    OutputBuffer& operator<<(char c) {
+        if (used == kCapacity) flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    OutputBuffer& operator<<(int32_t value);
+
+    OutputBuffer& operator<<(Indent indent) {
+        spaces(indent.width);
+        return *this;
+    }
+
+    // count пробелов
+    void spaces(size_t count);
+
+    // Отдаёт накопленное в поток и сбрасывает его буфер
+    void flush();
+
+private:
+    std::ostream& out;
+    std::unique_ptr<char[]> buffer;  // без обнуления: страницы занимаются по мере записи
+    size_t used = 0;
+
+    OutputBuffer& writeSlow(std::string_view text);
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Общие средства параллельных проходов (лексер, парсер, пакетная
+// компиляция)
+
+// Число потоков по умолчанию (threads == 0) - по числу ядер
+inline unsigned resolveThreads(unsigned threads) {
+    return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Выполняет task(i) для i из [0, count): нулевой - в текущем потоке.
+// Потоки создаются на время вызова; task не должна бросать исключений
+template <typename Task>
+void runParallel(size_t count, Task task) {
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    for (size_t i = 1; i < count; i++) {
+        workers.emplace_back(task, i);
+    }
+    task(0);
+    for (std::thread& worker : workers) worker.join();
+}
+
+// Очередь заданий одного потока в runWorkStealing: владелец берёт
+// задания с начала, другие потоки крадут с конца
+class WorkDeque {
+public:
+    void push(size_t task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(task);
+    }
+
+    bool pop(size_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+
+    bool steal(size_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+};
+
+// Выполняет task(i) для i из [0, count) в threads потоках (0 - по числу
+// ядер) с кражей работы: каждый поток получает свой отрезок заданий
+// подряд и идёт по нему с начала, а опустевший поток забирает задания
+// с конца чужих отрезков. Так задания разной длины (файлы разного
+// размера) распределяются без общей очереди. Новых заданий во время
+// работы не появляется, поэтому поток, не нашедший работы ни у кого,
+// завершается. task не должна бросать исключений
+template <typename Task>
+void runWorkStealing(size_t count, unsigned threads, Task task) {
+    size_t workers = std::min<size_t>(resolveThreads(threads), std::max<size_t>(count, 1));
+    std::unique_ptr<WorkDeque[]> queues(new WorkDeque[workers]);
+    for (size_t worker = 0; worker < workers; worker++) {
+        size_t begin = count * worker / workers;
+        size_t end = count * (worker + 1) / workers;
+        for (size_t i = begin; i < end; i++) queues[worker].push(i);
+    }
+
+    runParallel(workers, [&](size_t worker) {
+        size_t index;
+        for (;;) {
+            if (queues[worker].pop(index)) {
+                task(index);
+                continue;
+            }
+            bool stolen = false;
+            for (size_t step = 1; step < workers && !stolen; step++) {
+                stolen = queues[(worker + step) % workers].steal(index);
+            }
+            if (!stolen) return;
+            task(index);
+        }
+    });
+}
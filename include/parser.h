@@ -6,9 +6,10 @@
 #include <string>
 #include "ast.h"
 
-// Предполагается, что класс Token определен ранее
-class Token;
-enum class TokenType;
+#include "token.h"
+#include "token_stream.h"
+
+class Lexer;
 
 // Класс для парсинга токенов и построения AST
 class Parser {
@@ -19,59 +20,158 @@ public:
         ParseError(const std::string& message) : std::runtime_error(message) {}
     };
 
-    // Конструктор принимает последовательность токенов
+    // Ошибка, записанная в режиме восстановления; message - полный текст,
+    // как у ParseError
+    struct Diagnostic {
+        int line;
+        int column;
+        std::string message;
+    };
+
+    // Конструктор принимает готовую последовательность токенов
     Parser(const std::vector<Token>& tokens);
 
+    // Потоковый режим: токены запрашиваются у лексера по мере разбора,
+    // в памяти держится только небольшое окно вокруг текущей позиции
+    Parser(Lexer& lexer);
+
+    // Разбор компактного потока; строки и столбцы вычисляются только
+    // для сообщений об ошибках
+    Parser(const TokenStream& stream);
+
     // Основной метод парсинга, возвращает корень AST
     std::unique_ptr<Program> parseProgram();
 
+    // Параллельный разбор в threads потоках (0 - по числу ядер): главный
+    // класс разбирается в текущем потоке, остальные классы делятся
+    // на группы, и каждая группа разбирается своим парсером в своей
+    // арене. Дерево, ошибки и диагностики те же, что у parseProgram().
+    // Нужен произвольный доступ к токенам, поэтому в потоковом режиме
+    // и для компактного потока выполняется обычный parseProgram()
+    std::unique_ptr<Program> parseProgramParallel(unsigned threads = 0);
+
+    // Режим восстановления после ошибок: parseProgram() не бросает
+    // ParseError, а записывает ошибки в diagnostics(), пропускает токены
+    // до границы оператора, объявления или класса и продолжает разбор.
+    // Неразобранные конструкции заменяются в дереве на ErrorStatement
+    // и ErrorExpression. Так все ошибки файла находятся за один проход
+    void setRecovery(bool enabled) { recovery = enabled; }
+    const std::vector<Diagnostic>& diagnostics() const { return errors; }
+
+    // Число токенов, прочитанных парсером (включая EOF)
+    size_t tokenCount() const;
+
 private:
     // Поля для отслеживания токенов и текущей позиции
-    const std::vector<Token>& tokens;
-    size_t current;
+    const std::vector<Token>* tokens = nullptr;
+    size_t current = 0;
+
+    // Потоковый режим и компактный поток: токен с индексом i лежит
+    // в window[i % kWindowSize]. Окна хватает на previous() и на откат
+    // на один токен в parseStatement
+    static constexpr size_t kWindowSize = 8;
+    Lexer* lexer = nullptr;
+    const TokenStream* stream = nullptr;
+    std::vector<Token> window;
+    size_t fetched = 0;
+
+    // Узлы строящегося дерева; при успешном разборе арена передаётся
+    // в Program
+    AstArena arena;
+
+    // Общий стек для элементов строящихся списков: вложенные списки
+    // занимают его вершину и снимаются, когда список готов
+    std::vector<ASTNode*> scratch;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return arena.make<T>(std::forward<Args>(args)...);
+    }
+
+    // Текущая глубина вложенности операторов и выражений
+    static constexpr int kMaxNesting = 256;
+    int nesting = 0;
+    bool nestingReported = false;  // в текущем теле метода
+
+    // Предел глубины дерева выражения и глубина последнего разобранного
+    // выражения (см. tooDeep)
+    static constexpr int kMaxExpressionDepth = 10000;
+    int depth = 0;
+    bool tooDeep(int childDepth);
+
+    class NestingScope {
+    public:
+        explicit NestingScope(Parser& parser) : parser(parser) { parser.nesting++; }
+        ~NestingScope() { parser.nesting--; }
+
+        // Сообщает об ошибке, если лимит вложенности превышен
+        bool exceeded();
+
+    private:
+        Parser& parser;
+    };
+
+    // Переносит элементы стека, начиная с base, в список в арене
+    template <typename T>
+    AstList<T> takeList(size_t base);
+
+    const Token& tokenAt(size_t index) const;
+    void fetch();
 
     // Вспомогательные методы для навигации по токенам
-    Token peek() const;
-    Token previous() const;
+    const Token& peek() const;
+    const Token& previous() const;
     bool isAtEnd() const;
-    Token advance();
+    const Token& advance();
     bool check(TokenType type) const;
     bool match(TokenType type);
-    Token consume(TokenType type, const std::string& message);
+    const Token& consume(TokenType type, const char* message);
+    Diagnostic describe(const Token& token, const std::string& message) const;
     ParseError error(const Token& token, const std::string& message);
     void synchronize();
+    void skipGroup();
+
+    // Восстановление после ошибок
+    static constexpr size_t kMaxDiagnostics = 100;
+    bool recovery = false;
+    bool panicking = false;
+    std::vector<Diagnostic> errors;
+
+    enum class Boundary { Statement, Declaration, Class };
+    void report(const Token& token, const std::string& message);
+    bool recover(Boundary boundary, size_t start);
+    void resetState();
+
+    // Разбирает классы, начинающиеся до токена с индексом end
+    AstList<ClassDeclaration> parseClasses(size_t end);
 
     // Методы для парсинга различных нетерминалов грамматики
-    std::unique_ptr<MainClass> parseMainClass();
-    std::unique_ptr<ClassDeclaration> parseClassDeclaration();
-    std::unique_ptr<Declaration> parseDeclaration();
-    std::unique_ptr<MethodDeclaration> parseMethodDeclaration();
-    std::unique_ptr<VariableDeclaration> parseVariableDeclaration();
-    std::vector<std::unique_ptr<VariableDeclaration>> parseFormals();
-    std::unique_ptr<Type> parseType();
-    std::unique_ptr<Type> parseSimpleType();
-    std::unique_ptr<Statement> parseStatement();
-    std::unique_ptr<Statement> parseAssertStatement();
-    std::unique_ptr<Statement> parseBlockStatement();
-    std::unique_ptr<Statement> parseIfStatement();
-    std::unique_ptr<Statement> parseWhileStatement();
-    std::unique_ptr<Statement> parsePrintStatement();
-    std::unique_ptr<Statement> parseReturnStatement();
+    MainClass* parseMainClass();
+    ClassDeclaration* parseClassDeclaration();
+    Declaration* parseDeclaration();
+    MethodDeclaration* parseMethodDeclaration();
+    VariableDeclaration* parseVariableDeclaration();
+    AstList<VariableDeclaration> parseFormals();
+    Type* parseType();
+    SimpleType* parseSimpleType();
+    AstList<Statement> parseStatements();
+    Statement* parseStatement();
+    Statement* parseAssertStatement();
+    Statement* parseBlockStatement();
+    Statement* parseIfStatement();
+    Statement* parseWhileStatement();
+    Statement* parsePrintStatement();
+    Statement* parseReturnStatement();
 
     // Методы для парсинга выражений
-    std::unique_ptr<Expression> parseExpression();
-    std::unique_ptr<Expression> parseLogicalOr();
-    std::unique_ptr<Expression> parseLogicalAnd();
-    std::unique_ptr<Expression> parseEquality();
-    std::unique_ptr<Expression> parseRelational();
-    std::unique_ptr<Expression> parseAdditive();
-    std::unique_ptr<Expression> parseMultiplicative();
-    std::unique_ptr<Expression> parseUnary();
-    std::unique_ptr<Expression> parsePostfix();
-    std::unique_ptr<Expression> parsePrimary();
+    Expression* parseExpression();
+    Expression* parseBinary(int minPrecedence);
+    Expression* parseUnary();
+    Expression* parsePostfix();
+    Expression* parsePrimary();
 
     // Методы для парсинга LValue и связанных конструкций
-    std::unique_ptr<LValue> parseLValue();
-    std::unique_ptr<MethodInvocation> parseMethodInvocation();
-    std::unique_ptr<FieldInvocation> parseFieldInvocation();
+    LValue* parseLValue();
+    MethodInvocation* parseMethodInvocation();
+    FieldInvocation* parseFieldInvocation();
 };
\ No newline at end of file
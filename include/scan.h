@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+
+// Векторные ядра для пропуска длинных участков исходника: пробелов,
+// комментариев и символов идентификаторов.
+// На x86 используется SSE2 (16 байт за шаг) или AVX2 (32 байта), если
+// процессор его поддерживает; на остальных платформах - скалярный код.
+// Функции пропуска работают с диапазоном [pos, end) и возвращают позицию
+// первого байта, на котором остановились.
+namespace scan {
+
+// Номер строки и смещение её начала для позиции position.
+// Переводы строк учитываются лениво, только когда нужен номер строки
+struct LineCursor {
+    size_t line = 1;
+    size_t lineStart = 0;
+    size_t position = 0;
+};
+
+// Пропускает ' ', '\t', '\r', '\n'
+size_t skipWhitespace(const char* text, size_t pos, size_t end);
+
+// Пропускает [A-Za-z0-9_]
+size_t skipIdentifierChars(const char* text, size_t pos, size_t end);
+
+// Ищет '\n', завершающий строчный комментарий (или end)
+size_t findLineEnd(const char* text, size_t pos, size_t end);
+
+// Ищет следующий '*' или '/' внутри блочного комментария
+size_t findCommentDelimiter(const char* text, size_t pos, size_t end);
+
+// Продвигает курсор до target (target >= lines.position), подсчитывая
+// переводы строк popcount-ом по маске каждого блока
+void advanceLinesBlocks(const char* text, size_t target, LineCursor& lines);
+
+// Между соседними токенами обычно несколько байт, их дешевле
+// просмотреть на месте, чем вызывать векторное ядро
+inline void advanceLines(const char* text, size_t target, LineCursor& lines) {
+    if (target - lines.position >= 32) {
+        advanceLinesBlocks(text, target, lines);
+        return;
+    }
+    for (size_t pos = lines.position; pos < target; pos++) {
+        if (text[pos] == '\n') {
+            lines.line++;
+            lines.lineStart = pos + 1;
+        }
+    }
+    lines.position = target;
+}
+
+enum class Backend { Scalar, SSE2, AVX2 };
+
+// Лучшая реализация для текущего процессора
+Backend bestBackend();
+Backend activeBackend();
+const char* backendName(Backend backend);
+
+// Принудительный выбор реализации (для бенчмарков и тестов).
+// Возвращает false, если процессор её не поддерживает
+bool setBackend(Backend backend);
+
+}  // namespace scan
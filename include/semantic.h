@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "symbol_map.h"
+
+// Таблица классов программы. У каждого класса свои хеш-таблицы полей
+// и методов, объявленных в нём самом (ключ - имя); члены базовых
+// классов находятся подъёмом по цепочке base
+class ClassTable {
+public:
+    static constexpr uint32_t kNoClass = UINT32_MAX;
+
+    struct ClassInfo {
+        Symbol name;
+        ClassDeclaration* declaration = nullptr;  // nullptr у главного класса
+        uint32_t base = kNoClass;
+        SymbolMap<VariableDeclaration*> fields;
+        SymbolMap<MethodDeclaration*> methods;
+    };
+
+    // Добавляет класс и возвращает его номер. Имя регистрируется, только
+    // если оно ещё свободно: повторно объявленный класс получает номер,
+    // но find его не находит
+    uint32_t add(Symbol name, ClassDeclaration* declaration, bool* duplicate = nullptr);
+
+    // Номер класса по имени или kNoClass
+    uint32_t find(Symbol name) const {
+        const uint32_t* index = byName.find(name);
+        return index ? *index : kNoClass;
+    }
+
+    ClassInfo& operator[](uint32_t index) { return classes[index]; }
+    const ClassInfo& operator[](uint32_t index) const { return classes[index]; }
+    size_t size() const { return classes.size(); }
+
+    // Поле или метод класса index с учётом базовых классов; в owner
+    // записывается номер класса, где найдено объявление
+    VariableDeclaration* findField(uint32_t index, Symbol name, uint32_t* owner = nullptr) const;
+    MethodDeclaration* findMethod(uint32_t index, Symbol name, uint32_t* owner = nullptr) const;
+
+    // derived совпадает с base или наследует его
+    bool isSubclass(uint32_t derived, uint32_t base) const;
+
+    void clear();
+
+private:
+    std::vector<ClassInfo> classes;
+    SymbolMap<uint32_t> byName;
+};
+
+// Семантический анализ дерева: разрешение имён классов, полей, методов
+// и переменных и проверка типов. Анализ заполняет аннотации узлов
+// (Expression::type, поля declaration у использований имён, роль
+// VariableDeclaration::scope) и собирает все ошибки программы за один
+// проход, не останавливаясь на первой. Правила - правила Java для
+// подмножества Mini-Java: поля закрыты (видны только в своём классе),
+// методы открыты и наследуются, перегрузки нет, переопределение
+// сохраняет сигнатуру, локальная переменная не может скрыть другую
+// локальную переменную или параметр
+class SemanticAnalyzer {
+public:
+    struct Diagnostic {
+        Symbol className;   // класс, в котором найдена ошибка
+        Symbol methodName;  // пусто - ошибка в объявлении класса или поля
+        std::string message;
+    };
+
+    // Анализирует program; true, если ошибок нет. Анализатор можно
+    // использовать повторно: таблицы и ошибки предыдущей программы
+    // сбрасываются
+    bool analyze(Program& program);
+
+    const std::vector<Diagnostic>& diagnostics() const { return errors; }
+    const ClassTable& classes() const { return table; }
+
+    // Анализатор текущего потока. Массив локальных переменных по номерам
+    // имён выделяется один раз на поток, а не на каждый файл
+    static SemanticAnalyzer& forThread();
+
+private:
+    class Checker;
+
+    ClassTable table;
+    std::vector<Diagnostic> errors;
+    // Локальные переменные и параметры текущего метода по номеру имени:
+    // Symbol нумерует имена плотно, поэтому хеш не нужен. Массив
+    // переиспользуется между методами и программами
+    std::vector<VariableDeclaration*> locals;
+    std::vector<Symbol> localStack;  // имена в порядке объявления
+    // Цепочки бинарных (по левому операнду) и унарных операций,
+    // которые проверяются циклом, а не рекурсией
+    std::vector<Expression*> spine;
+};
+
+// Запись типа для сообщений: int, boolean[], Tree
+std::string typeName(const ValueType& type);
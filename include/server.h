@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "driver.h"
+
+class CompileCache;
+
+// Сервер компиляции на локальном сокете (AF_UNIX). Процесс живёт между
+// запросами, поэтому запуск, разогрев аллокатора, таблица имён Symbol
+// и кэш компиляции достаются всем запросам, а не создаются заново.
+// Таблица имён только растёт: имена всех файлов остаются в ней до
+// остановки сервера.
+// Запросы обслуживаются пулом потоков: каждый поток ждёт соединения
+// на общем слушающем сокете (очередь соединений ядра и есть очередь
+// заданий), разбирает один запрос через CompileDriver и передаёт вывод
+// кадрами по мере заполнения буфера. Сервер останавливается запросом
+// Shutdown, вызовом stop() или после idleSeconds без запросов.
+// Протокол - кадры с заголовком фиксированного размера в порядке байтов
+// машины: клиент и сервер - это один и тот же исполняемый файл
+class CompileServer {
+public:
+    struct Options {
+        std::string socketPath;
+        unsigned threads = 0;        // 0 - по числу ядер
+        double idleSeconds = 300;    // 0 - не останавливаться по простою
+        CompileCache* cache = nullptr;
+    };
+
+    // Предел длины текста, переданного в запросе
+    static constexpr uint64_t kMaxSourceLength = uint64_t(64) << 20;
+
+    enum class RequestType : uint32_t { Compile, Stats, Shutdown };
+
+    struct Request {
+        RequestType type = RequestType::Compile;
+        std::string path;            // файл; для текста из source - имя ("-")
+        bool inlineSource = false;   // текст передан в source, сервер файл не читает
+        std::string source;
+        CompileDriver::Options options;
+    };
+
+    explicit CompileServer(Options options);
+    ~CompileServer();
+    CompileServer(const CompileServer&) = delete;
+    CompileServer& operator=(const CompileServer&) = delete;
+
+    // Создаёт сокет с доступом только для владельца. Сокет, оставшийся от упавшего сервера, заменяется,
+    // занятый работающим сервером - ошибка. Бросает std::runtime_error
+    void listen();
+
+    // Обслуживает запросы до остановки; возвращается, когда все потоки
+    // закончили текущие запросы
+    void run();
+    void stop() { stopping = true; }
+
+    // Число запросов и гистограмма задержек по степеням двойки (мкс)
+    std::string latencyReport() const;
+
+    // Клиент: отправляет запрос и переносит ответ в out и err по мере
+    // получения. Возвращает код завершения компиляции; при ошибке
+    // соединения бросает std::runtime_error
+    static int send(const std::string& socketPath, const Request& request,
+                    std::ostream& out, std::ostream& err);
+
+private:
+    static constexpr size_t kBuckets = 32;
+
+    Options options;
+    int listenFd = -1;
+    std::atomic<bool> stopping{false};
+    std::atomic<int> active{0};
+    std::atomic<int64_t> lastActivity{0};  // steady_clock, нс
+    std::atomic<uint64_t> latency[kBuckets] = {};
+
+    void serve(int fd);
+    void serveRequest(int fd, int64_t start);
+    void touch();
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Буфер с исходным кодом программы.
+// Обычные файлы отображаются в память только для чтения, каналы и stdin
+// читаются в один растущий буфер. Лексер и токены ссылаются на эти байты,
+// поэтому буфер должен жить дольше них.
+class SourceBuffer {
+public:
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // Открывает файл по пути; "-" означает стандартный ввод.
+    // При ошибке бросает std::runtime_error
+    static SourceBuffer fromFile(const std::string& path);
+
+    // Читает всё из дескриптора (канал, терминал, stdin) до конца
+    static SourceBuffer fromDescriptor(int fd);
+
+    // Буфер поверх уже готовой строки (тесты, встроенный исходник)
+    static SourceBuffer fromString(std::string text);
+
+    std::string_view text() const {
+        return mapped ? std::string_view(mappedBytes, mappedSize)
+                      : std::string_view(storage);
+    }
+    const char* data() const { return text().data(); }
+    size_t size() const { return text().size(); }
+    bool empty() const { return size() == 0; }
+    bool isMapped() const { return mapped; }
+
+private:
+    const char* mappedBytes = nullptr;
+    size_t mappedSize = 0;
+    bool mapped = false;
+    std::string storage;
+
+    void release();
+};
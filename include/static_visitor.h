@@ -0,0 +1,167 @@
+#pragma once
+#include "ast.h"
+
+// Посетитель со статической диспетчеризацией (CRTP). dispatch выбирает
+// visit наследника по node.kind через switch: виртуальных вызовов нет,
+// и тела visit встраиваются в обход. Наследник объявляет
+// Result visit(X& node) для каждого конкретного класса узла из ast.h;
+// переопределять методы Visitor для этого не нужно.
+//
+//   class Counter : public StaticVisitor<Counter> {
+//   public:
+//       void visit(IntegerLiteral& node) { ... }
+//       ...
+//   };
+//   counter.dispatch(*program);
+template <typename Derived, typename Result = void>
+class StaticVisitor {
+public:
+    Result dispatch(ASTNode& node) {
+        Derived& self = static_cast<Derived&>(*this);
+        switch (node.kind) {
+            case NodeKind::Program: return self.visit(static_cast<Program&>(node));
+            case NodeKind::MainClass: return self.visit(static_cast<MainClass&>(node));
+            case NodeKind::ClassDeclaration: return self.visit(static_cast<ClassDeclaration&>(node));
+
+            case NodeKind::IntType: return self.visit(static_cast<IntType&>(node));
+            case NodeKind::BooleanType: return self.visit(static_cast<BooleanType&>(node));
+            case NodeKind::VoidType: return self.visit(static_cast<VoidType&>(node));
+            case NodeKind::IdentifierType: return self.visit(static_cast<IdentifierType&>(node));
+            case NodeKind::ArrayType: return self.visit(static_cast<ArrayType&>(node));
+
+            case NodeKind::VariableDeclaration: return self.visit(static_cast<VariableDeclaration&>(node));
+            case NodeKind::MethodDeclaration: return self.visit(static_cast<MethodDeclaration&>(node));
+
+            case NodeKind::AssertStatement: return self.visit(static_cast<AssertStatement&>(node));
+            case NodeKind::LocalVarDeclStatement: return self.visit(static_cast<LocalVarDeclStatement&>(node));
+            case NodeKind::BlockStatement: return self.visit(static_cast<BlockStatement&>(node));
+            case NodeKind::IfStatement: return self.visit(static_cast<IfStatement&>(node));
+            case NodeKind::WhileStatement: return self.visit(static_cast<WhileStatement&>(node));
+            case NodeKind::PrintStatement: return self.visit(static_cast<PrintStatement&>(node));
+            case NodeKind::AssignStatement: return self.visit(static_cast<AssignStatement&>(node));
+            case NodeKind::ReturnStatement: return self.visit(static_cast<ReturnStatement&>(node));
+            case NodeKind::MethodInvocationStatement:
+                return self.visit(static_cast<MethodInvocationStatement&>(node));
+            case NodeKind::ErrorStatement: return self.visit(static_cast<ErrorStatement&>(node));
+
+            case NodeKind::BinaryOperation: return self.visit(static_cast<BinaryOperation&>(node));
+            case NodeKind::UnaryOperation: return self.visit(static_cast<UnaryOperation&>(node));
+            case NodeKind::ArrayIndexing: return self.visit(static_cast<ArrayIndexing&>(node));
+            case NodeKind::ArrayLength: return self.visit(static_cast<ArrayLength&>(node));
+            case NodeKind::MethodInvocation: return self.visit(static_cast<MethodInvocation&>(node));
+            case NodeKind::FieldAccess: return self.visit(static_cast<FieldAccess&>(node));
+            case NodeKind::NewArray: return self.visit(static_cast<NewArray&>(node));
+            case NodeKind::NewObject: return self.visit(static_cast<NewObject&>(node));
+            case NodeKind::IntegerLiteral: return self.visit(static_cast<IntegerLiteral&>(node));
+            case NodeKind::BooleanLiteral: return self.visit(static_cast<BooleanLiteral&>(node));
+            case NodeKind::ThisExpression: return self.visit(static_cast<ThisExpression&>(node));
+            case NodeKind::IdentifierExpression: return self.visit(static_cast<IdentifierExpression&>(node));
+            case NodeKind::ErrorExpression: return self.visit(static_cast<ErrorExpression&>(node));
+
+            case NodeKind::IdentifierLValue: return self.visit(static_cast<IdentifierLValue&>(node));
+            case NodeKind::ArrayAccess: return self.visit(static_cast<ArrayAccess&>(node));
+            case NodeKind::SimpleFieldInvocation: return self.visit(static_cast<SimpleFieldInvocation&>(node));
+            case NodeKind::FieldArrayInvocation: return self.visit(static_cast<FieldArrayInvocation&>(node));
+        }
+        return Result();
+    }
+};
+
+// Рекурсивный обход на StaticVisitor. По умолчанию visit только обходит
+// детей узла в порядке полей; наследник переопределяет visit для нужных
+// ему узлов и при необходимости спускается дальше через walkChildren.
+// Переопределение скрывает одноимённые методы базы, поэтому в наследнике
+// нужен using AstWalker<Derived>::visit:
+//
+//   class Calls : public AstWalker<Calls> {
+//   public:
+//       using AstWalker<Calls>::visit;
+//       size_t count = 0;
+//       void visit(MethodInvocation& node) { count++; walkChildren(node); }
+//   };
+template <typename Derived>
+class AstWalker : public StaticVisitor<Derived> {
+public:
+    void walk(ASTNode* node) {
+        if (node) this->dispatch(*node);
+    }
+
+    template <typename Node>
+    void walk(const AstList<Node>& nodes) {
+        for (Node* node : nodes) walk(node);
+    }
+
+    void walkChildren(Program& node) {
+        walk(node.mainClass);
+        walk(node.classes);
+    }
+    void walkChildren(MainClass& node) { walk(node.statements); }
+    void walkChildren(ClassDeclaration& node) { walk(node.declarations); }
+    void walkChildren(IntType&) {}
+    void walkChildren(BooleanType&) {}
+    void walkChildren(VoidType&) {}
+    void walkChildren(IdentifierType&) {}
+    void walkChildren(ArrayType& node) { walk(node.elementType); }
+    void walkChildren(VariableDeclaration& node) { walk(node.type); }
+    void walkChildren(MethodDeclaration& node) {
+        walk(node.returnType);
+        walk(node.parameters);
+        walk(node.statements);
+    }
+    void walkChildren(AssertStatement& node) { walk(node.condition); }
+    void walkChildren(LocalVarDeclStatement& node) { walk(node.declaration); }
+    void walkChildren(BlockStatement& node) { walk(node.statements); }
+    void walkChildren(IfStatement& node) {
+        walk(node.condition);
+        walk(node.thenStatement);
+        walk(node.elseStatement);
+    }
+    void walkChildren(WhileStatement& node) {
+        walk(node.condition);
+        walk(node.body);
+    }
+    void walkChildren(PrintStatement& node) { walk(node.expression); }
+    void walkChildren(AssignStatement& node) {
+        walk(node.lvalue);
+        walk(node.expression);
+    }
+    void walkChildren(ReturnStatement& node) { walk(node.expression); }
+    void walkChildren(MethodInvocationStatement& node) { walk(node.invocation); }
+    void walkChildren(ErrorStatement&) {}
+    void walkChildren(BinaryOperation& node) {
+        walk(node.left);
+        walk(node.right);
+    }
+    void walkChildren(UnaryOperation& node) { walk(node.expression); }
+    void walkChildren(ArrayIndexing& node) {
+        walk(node.array);
+        walk(node.index);
+    }
+    void walkChildren(ArrayLength& node) { walk(node.array); }
+    void walkChildren(MethodInvocation& node) {
+        walk(node.object);
+        walk(node.arguments);
+    }
+    void walkChildren(FieldAccess& node) { walk(node.object); }
+    void walkChildren(NewArray& node) {
+        walk(node.elementType);
+        walk(node.size);
+    }
+    void walkChildren(NewObject&) {}
+    void walkChildren(IntegerLiteral&) {}
+    void walkChildren(BooleanLiteral&) {}
+    void walkChildren(ThisExpression&) {}
+    void walkChildren(IdentifierExpression&) {}
+    void walkChildren(ErrorExpression&) {}
+    void walkChildren(IdentifierLValue&) {}
+    void walkChildren(ArrayAccess& node) { walk(node.index); }
+    void walkChildren(SimpleFieldInvocation&) {}
+    void walkChildren(FieldArrayInvocation& node) { walk(node.index); }
+
+    // Обход по умолчанию: любой узел, для которого у наследника нет
+    // своего visit
+    template <typename Node>
+    void visit(Node& node) {
+        static_cast<Derived&>(*this).walkChildren(node);
+    }
+};
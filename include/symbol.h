@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string_view>
+
+// Имя из глобальной таблицы имён: 32-битный номер вместо строки.
+// Номера плотные (1, 2, 3, ... в порядке появления), поэтому по ним можно
+// индексировать массивы, а одинаковые строки всегда получают один номер,
+// так что сравнение имён - сравнение чисел. Номер 0 - пустая строка.
+// Таблица общая для всех потоков и живёт до конца программы
+class Symbol {
+public:
+    Symbol() = default;
+
+    // Номер строки text; при первом обращении строка копируется в таблицу
+    static Symbol intern(std::string_view text);
+
+    // Имя по номеру, ранее полученному от id()
+    static Symbol fromId(uint32_t id) { return Symbol(id); }
+
+    // Верхняя граница номеров: массив такого размера вмещает все имена
+    static size_t tableSize();
+
+    uint32_t id() const { return value; }
+    std::string_view str() const;
+    bool empty() const { return value == 0; }
+
+    bool operator==(Symbol other) const { return value == other.value; }
+    bool operator!=(Symbol other) const { return value != other.value; }
+    bool operator<(Symbol other) const { return value < other.value; }
+
+private:
+    explicit Symbol(uint32_t value) : value(value) {}
+
+    uint32_t value = 0;
+};
+
+std::ostream& operator<<(std::ostream& out, Symbol symbol);
+
+namespace std {
+template <>
+struct hash<Symbol> {
+    size_t operator()(Symbol symbol) const noexcept { return symbol.id(); }
+};
+}  // namespace std
+
+// Небольшой кэш недавних имён перед глобальной таблицей. Повторяющиеся
+// идентификаторы находятся в нём без блокировок, поэтому у каждого
+// лексера (и потока) свой кэш
+class SymbolCache {
+public:
+    Symbol intern(std::string_view text) {
+        // Индекс по длине и крайним символам дешевле полного хеша
+        size_t index = text.empty()
+            ? 0
+            : (text.size() * 31 + static_cast<unsigned char>(text.front()) * 7 +
+               static_cast<unsigned char>(text.back())) & (kSize - 1);
+        Entry& entry = entries[index];
+        if (entry.text != text) {
+            entry.symbol = Symbol::intern(text);
+            entry.text = entry.symbol.str();
+        }
+        return entry.symbol;
+    }
+
+private:
+    static constexpr size_t kSize = 256;
+
+    // Строка хранится рядом с номером, чтобы попадание не обращалось
+    // к глобальной таблице
+    struct Entry {
+        std::string_view text;
+        Symbol symbol;
+    };
+    std::array<Entry, kSize> entries{};
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "symbol.h"
+
+// Хеш-таблица с ключом Symbol: открытая адресация с линейным
+// пробированием в одном векторе ячеек, без узлов в куче и без
+// сравнения строк. Номера имён идут подряд, поэтому перед взятием
+// ячейки они перемешиваются умножением (хеш Фибоначчи). Удаления нет:
+// таблицы символов только растут и очищаются целиком
+template <typename T>
+class SymbolMap {
+public:
+    // Значение по ключу или nullptr
+    T* find(Symbol key) {
+        if (slots.empty() || key.empty()) return nullptr;
+        for (size_t index = slotFor(key);; index = (index + 1) & mask()) {
+            Slot& slot = slots[index];
+            if (slot.key == key) return &slot.value;
+            if (slot.key.empty()) return nullptr;
+        }
+    }
+
+    const T* find(Symbol key) const { return const_cast<SymbolMap*>(this)->find(key); }
+
+    // Добавляет пару, если ключа ещё нет. Возвращает значение по ключу
+    // и true, если пара добавлена. Пустой ключ не добавляется
+    std::pair<T*, bool> insert(Symbol key, const T& value) {
+        if (key.empty()) return {nullptr, false};
+        if ((used + 1) * 4 > slots.size() * 3) grow();
+        for (size_t index = slotFor(key);; index = (index + 1) & mask()) {
+            Slot& slot = slots[index];
+            if (slot.key == key) return {&slot.value, false};
+            if (slot.key.empty()) {
+                slot.key = key;
+                slot.value = value;
+                used++;
+                return {&slot.value, true};
+            }
+        }
+    }
+
+    size_t size() const { return used; }
+    bool empty() const { return used == 0; }
+
+    void clear() {
+        slots.clear();
+        used = 0;
+        bits = 0;
+    }
+
+    // Перебор пар в порядке ячеек
+    template <typename Function>
+    void forEach(Function&& function) const {
+        for (const Slot& slot : slots) {
+            if (!slot.key.empty()) function(slot.key, slot.value);
+        }
+    }
+
+private:
+    struct Slot {
+        Symbol key;  // пустой - свободная ячейка
+        T value{};
+    };
+
+    std::vector<Slot> slots;
+    size_t used = 0;
+    unsigned bits = 0;  // slots.size() == 1 << bits
+
+    size_t mask() const { return slots.size() - 1; }
+
+    size_t slotFor(Symbol key) const {
+        return static_cast<size_t>((key.id() * 0x9E3779B9u) >> (32 - bits));
+    }
+
+    void grow() {
+        std::vector<Slot> old(bits == 0 ? 8 : slots.size() * 2);
+        old.swap(slots);
+        bits = bits == 0 ? 3 : bits + 1;
+        for (Slot& slot : old) {
+            if (slot.key.empty()) continue;
+            size_t index = slotFor(slot.key);
+            while (!slots[index].key.empty()) index = (index + 1) & mask();
+            slots[index] = std::move(slot);
+        }
+    }
+};
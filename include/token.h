@@ -1,5 +1,7 @@
 #pragma once
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include "symbol.h"
 
 enum class TokenType {
     // Ключевые слова
@@ -56,12 +58,23 @@ enum class TokenType {
     ERROR
 };
 
+// Токен не владеет текстом: lexeme указывает в буфер исходного кода
+// (или на статическое сообщение для ERROR), поэтому буфер должен жить
+// дольше токенов.
+// line и column равны 0, если позиция не вычислялась (токены из TokenStream);
+// тогда её можно получить по offset через LineIndex.
+// Для IDENTIFIER symbol - имя из таблицы имён, у остальных токенов пусто.
+// Для INTEGER_LITERAL value - значение, уже разобранное лексером
 struct Token {
     TokenType type;
-    std::string lexeme;
+    uint32_t offset;
+    std::string_view lexeme;
     int line;
     int column;
+    Symbol symbol;
+    int32_t value = 0;
     
-    Token(TokenType t, const std::string& l, int lin, int col)
-        : type(t), lexeme(l), line(lin), column(col) {}
+    Token(TokenType t, std::string_view l, int lin, int col, uint32_t off,
+          Symbol sym = Symbol())
+        : type(t), offset(off), lexeme(l), line(lin), column(col), symbol(sym) {}
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+#include "token.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Правка текста: участок [offset, offset + removedLength) старого текста
+// заменён на insertedText
+struct TextEdit {
+    size_t offset;
+    size_t removedLength;
+    std::string_view insertedText;
+};
+
+// Правки потока токенов и индекса строк стоят пропорционально размеру
+// правки и расстоянию от предыдущей, а не размеру файла. Массивы
+// хранятся с разрывом (gap buffer) в месте последней правки: элементы
+// до разрыва хранят смещение от начала текста, после разрыва - от его
+// конца. Правка меняет только окрестность разрыва, а смещения хвоста
+// от конца текста от неё не меняются. Переезд разрыва к следующей
+// правке пересчитывает лишь элементы между старым и новым местом
+//
+// Индекс начал строк исходника. Строится одним проходом поиска '\n',
+// строка и столбец по смещению находятся двоичным поиском
+class LineIndex {
+public:
+    struct Location {
+        int line;
+        int column;
+    };
+
+    LineIndex() = default;
+    explicit LineIndex(std::string_view source);
+
+    Location locate(uint32_t offset) const;
+    size_t lineCount() const { return lineStarts.size() - gapLength; }
+
+    // Перестраивает только начала строк внутри правки; начала после
+    // неё не переписываются. newSource - текст после правки
+    void applyEdit(const TextEdit& edit, std::string_view newSource);
+
+private:
+    std::vector<uint32_t> lineStarts;
+    size_t gapStart = SIZE_MAX;  // SIZE_MAX - разрыва нет, все смещения от начала
+    size_t gapLength = 0;
+    size_t textSize = 0;
+
+    // Начало строки с номером index - 1 (от начала текста)
+    uint32_t lineStart(size_t index) const {
+        return index < gapStart ? lineStarts[index]
+                                : static_cast<uint32_t>(textSize) - lineStarts[index + gapLength];
+    }
+};
+
+// Компактный поток токенов в виде структуры массивов: тип, смещение и
+// длина лексемы в исходнике и значение (номер имени или число) - 13 байт
+// на токен. Строки и
+// столбцы не хранятся, а вычисляются через LineIndex, когда они
+// действительно нужны
+class TokenStream {
+public:
+    explicit TokenStream(std::string_view source) : source(source) {}
+
+    void reserve(size_t count);
+    // payload - номер имени для IDENTIFIER, значение для INTEGER_LITERAL
+    void push(TokenType type, uint32_t offset, uint32_t length,
+              uint32_t payload = 0);
+    // Для ERROR вместо лексемы хранится статическое сообщение лексера
+    void pushError(uint32_t offset, uint32_t length, const char* message);
+
+    size_t size() const { return types.size() - gapLength; }
+    TokenType type(size_t index) const { return static_cast<TokenType>(types[slot(index)]); }
+    uint32_t offset(size_t index) const {
+        return index < gapStart ? offsets[index]
+                                : static_cast<uint32_t>(source.size()) - offsets[index + gapLength];
+    }
+    uint32_t length(size_t index) const { return lengths[slot(index)]; }
+    // Имя IDENTIFIER (для остальных токенов пусто)
+    Symbol symbol(size_t index) const {
+        return type(index) == TokenType::IDENTIFIER ? Symbol::fromId(payloads[slot(index)])
+                                                    : Symbol();
+    }
+    // Значение INTEGER_LITERAL (для остальных токенов 0)
+    int32_t value(size_t index) const {
+        return type(index) == TokenType::INTEGER_LITERAL
+                   ? static_cast<int32_t>(payloads[slot(index)])
+                   : 0;
+    }
+    std::string_view lexeme(size_t index) const;
+    std::string_view text() const { return source; }
+
+    // Токен без позиции (line = column = 0)
+    Token token(size_t index) const;
+    // Токен со строкой и столбцом; индекс строк строится при первом вызове
+    Token locatedToken(size_t index) const;
+
+    const LineIndex& lines() const;
+
+    // Переводит поток на текст после правки edit: токены [first, last)
+    // заменяются токенами replacement (разобранными по новому тексту).
+    // Токены после правки не переписываются: разрыв переезжает к first
+    void splice(size_t first, size_t last, const TokenStream& replacement,
+                const TextEdit& edit);
+
+private:
+    std::string_view source;
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> payloads;
+    std::vector<std::pair<uint32_t, const char*>> errors;  // индекс токена -> сообщение
+    size_t gapStart = SIZE_MAX;  // SIZE_MAX - разрыва нет
+    size_t gapLength = 0;
+
+    size_t slot(size_t index) const { return index < gapStart ? index : index + gapLength; }
+    void moveGap(size_t target);
+    void closeGap();
+
+    mutable LineIndex lineIndex;
+    mutable bool lineIndexBuilt = false;
+};
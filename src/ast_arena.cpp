@@ -0,0 +1,70 @@
+#include "ast_arena.h"
+
+#include <cstdlib>
+
+AstArena::AstArena(AstArena&& other) noexcept
+    : blocks(std::move(other.blocks)),
+      cursor(other.cursor),
+      limit(other.limit),
+      reserved(other.reserved) {
+  other.blocks.clear();
+  other.cursor = other.limit = nullptr;
+  other.reserved = 0;
+}
+
+AstArena& AstArena::operator=(AstArena&& other) noexcept {
+  if (this != &other) {
+    release();
+    blocks = std::move(other.blocks);
+    cursor = other.cursor;
+    limit = other.limit;
+    reserved = other.reserved;
+    other.blocks.clear();
+    other.cursor = other.limit = nullptr;
+    other.reserved = 0;
+  }
+  return *this;
+}
+
+AstArena::~AstArena() { release(); }
+
+void AstArena::adopt(AstArena&& other) {
+  if (this == &other) return;
+  blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+  reserved += other.reserved;
+  other.blocks.clear();
+  other.cursor = other.limit = nullptr;
+  other.reserved = 0;
+}
+
+void AstArena::release() {
+  for (char* block : blocks) std::free(block);
+  blocks.clear();
+  cursor = limit = nullptr;
+  reserved = 0;
+}
+
+// Текущий блок закончился. Большие запросы (длинные списки) получают
+// отдельный блок, чтобы не выбрасывать остаток текущего
+void* AstArena::allocateSlow(size_t size, size_t alignment) {
+  size_t blockSize = size + alignment;
+  bool dedicated = blockSize > kBlockSize / 4;
+  if (!dedicated) blockSize = kBlockSize;
+
+  blocks.push_back(nullptr);
+  char* block = static_cast<char*>(std::malloc(blockSize));
+  if (!block) {
+    blocks.pop_back();
+    throw std::bad_alloc();
+  }
+  blocks.back() = block;
+  reserved += blockSize;
+
+  size_t padding = (alignment - reinterpret_cast<size_t>(block)) & (alignment - 1);
+  char* result = block + padding;
+  if (!dedicated) {
+    cursor = result + size;
+    limit = block + blockSize;
+  }
+  return result;
+}
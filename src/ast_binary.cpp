@@ -0,0 +1,288 @@
+#include "ast_binary.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "hash.h"
+#include "source_buffer.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'M', 'J', 'A', 'B'};
+constexpr uint32_t kByteOrder = 0x01020304;
+constexpr size_t kAlignment = 8;
+
+// Секции, которые идут до и после столбцов пулов
+constexpr size_t kLeadingSections = 3;   // kinds, slots, lists
+constexpr size_t kTrailingSections = 2;  // таблица строк: смещения, байты
+
+struct Section {
+  uint64_t offset;
+  uint64_t count;
+  uint32_t elementSize;
+  uint32_t reserved;
+};
+
+size_t alignUp(size_t size) { return (size + kAlignment - 1) & ~(kAlignment - 1); }
+
+size_t tableEnd(size_t sectionCount) {
+  return alignUp(sizeof(AstBinary::Header) + sectionCount * sizeof(Section));
+}
+
+size_t poolColumnCount() {
+  size_t count = 0;
+  FlatAst().forEachPool([&count](const auto&... columns) { count += sizeof...(columns); });
+  return count;
+}
+
+// Секции дописываются в конец буфера; заголовок и таблица секций
+// заполняются в начале буфера, когда известны все смещения
+class SectionWriter {
+ public:
+  SectionWriter(std::string& out, size_t sectionCount) : out(out) {
+    out.assign(tableEnd(sectionCount), '\0');
+    sections.reserve(sectionCount);
+  }
+
+  template <typename T>
+  void add(const T* data, size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value, "секция копируется побайтно");
+    out.resize(alignUp(out.size()), '\0');
+    sections.push_back(Section{out.size(), count, sizeof(T), 0});
+    out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+  }
+
+  template <typename T>
+  void add(const std::vector<T>& column) {
+    add(column.data(), column.size());
+  }
+
+  void finish(AstBinary::Header header) {
+    header.sectionCount = static_cast<uint32_t>(sections.size());
+    std::memcpy(&out[0], &header, sizeof(header));
+    std::memcpy(&out[sizeof(header)], sections.data(), sections.size() * sizeof(Section));
+  }
+
+ private:
+  std::string& out;
+  std::vector<Section> sections;
+};
+
+AstBinary::FormatError corrupted(const std::string& what) {
+  return AstBinary::FormatError("Повреждённый файл AST: " + what);
+}
+
+class SectionReader {
+ public:
+  SectionReader(std::string_view data, size_t sectionCount) : data(data) {
+    if (data.size() < tableEnd(sectionCount)) throw corrupted("обрезана таблица секций");
+    sections.resize(sectionCount);
+    std::memcpy(sections.data(), data.data() + sizeof(AstBinary::Header),
+                sectionCount * sizeof(Section));
+  }
+
+  // Начало секции index с элементами типа T и их число
+  template <typename T>
+  const char* section(size_t index, size_t& count) const {
+    const Section& section = sections[index];
+    if (section.elementSize != sizeof(T)) throw corrupted("неверный размер элемента");
+    if (section.offset > data.size() ||
+        section.count > (data.size() - section.offset) / sizeof(T)) {
+      throw corrupted("секция за концом файла");
+    }
+    count = static_cast<size_t>(section.count);
+    return data.data() + section.offset;
+  }
+
+  template <typename T>
+  void read(size_t index, std::vector<T>& column) const {
+    size_t count;
+    const char* bytes = section<T>(index, count);
+    column.resize(count);
+    std::memcpy(column.data(), bytes, count * sizeof(T));
+  }
+
+ private:
+  std::string_view data;
+  std::vector<Section> sections;
+};
+
+}  // namespace
+
+std::string AstBinary::serialize(const FlatAst& ast, std::string_view source) {
+  size_t sectionCount = kLeadingSections + poolColumnCount() + kTrailingSections;
+  std::string out;
+  SectionWriter writer(out, sectionCount);
+  writer.add(ast.kinds);
+  writer.add(ast.slots);
+  writer.add(ast.lists);
+
+  // Таблица строк: номер 0 - пустое имя. Номера Symbol плотные,
+  // поэтому соответствие хранится в массиве, а не в хеш-таблице
+  std::vector<uint32_t> indexOf(Symbol::tableSize(), 0);
+  std::vector<Symbol> names{Symbol()};
+  std::vector<uint32_t> indices;
+  auto addColumn = [&](const auto& column) {
+    using Element = typename std::decay_t<decltype(column)>::value_type;
+    if constexpr (std::is_same<Element, Symbol>::value) {
+      indices.clear();
+      for (Symbol symbol : column) {
+        uint32_t& index = indexOf[symbol.id()];
+        if (index == 0 && !symbol.empty()) {
+          index = static_cast<uint32_t>(names.size());
+          names.push_back(symbol);
+        }
+        indices.push_back(index);
+      }
+      writer.add(indices);
+    } else {
+      writer.add(column);
+    }
+  };
+  ast.forEachPool([&addColumn](const auto&... columns) { (addColumn(columns), ...); });
+
+  std::vector<uint32_t> offsets{0};
+  std::string bytes;
+  for (size_t i = 1; i < names.size(); i++) {
+    bytes += names[i].str();
+    offsets.push_back(static_cast<uint32_t>(bytes.size()));
+  }
+  writer.add(offsets);
+  writer.add(bytes.data(), bytes.size());
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byteOrder = kByteOrder;
+  header.sourceHash = xxh64(source);
+  header.sourceSize = source.size();
+  header.mainClass = ast.mainClass;
+  header.classesBegin = ast.classes.begin;
+  header.classesCount = ast.classes.count;
+  writer.finish(header);
+  return out;
+}
+
+bool AstBinary::isBinary(std::string_view data) {
+  return data.size() >= sizeof(kMagic) &&
+         std::memcmp(data.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+AstBinary::Header AstBinary::readHeader(std::string_view data) {
+  if (!isBinary(data)) throw FormatError("Файл не содержит AST");
+  if (data.size() < sizeof(Header)) throw corrupted("обрезан заголовок");
+
+  Header header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.byteOrder != kByteOrder) {
+    throw FormatError("Файл AST записан на машине с другим порядком байтов");
+  }
+  if (header.version != kVersion) {
+    throw FormatError("Неподдерживаемая версия файла AST: " +
+                      std::to_string(header.version) + " (ожидалась " +
+                      std::to_string(kVersion) + ")");
+  }
+  return header;
+}
+
+bool AstBinary::matchesSource(const Header& header, std::string_view source) {
+  return header.sourceSize == source.size() && header.sourceHash == xxh64(source);
+}
+
+FlatAst AstBinary::deserialize(std::string_view data) {
+  Header header = readHeader(data);
+  size_t poolColumns = poolColumnCount();
+  if (header.sectionCount != kLeadingSections + poolColumns + kTrailingSections) {
+    throw corrupted("неверное число секций");
+  }
+  SectionReader reader(data, header.sectionCount);
+
+  FlatAst ast;
+  reader.read(0, ast.kinds);
+  reader.read(1, ast.slots);
+  reader.read(2, ast.lists);
+  ast.mainClass = header.mainClass;
+  ast.classes = FlatAst::Range{header.classesBegin, header.classesCount};
+
+  // Имена из таблицы строк получают номера Symbol этого процесса
+  size_t stringSection = kLeadingSections + poolColumns;
+  std::vector<uint32_t> offsets;
+  reader.read(stringSection, offsets);
+  size_t byteCount;
+  const char* bytes = reader.section<char>(stringSection + 1, byteCount);
+  if (offsets.empty() || offsets[0] != 0) throw corrupted("таблица строк");
+  std::vector<Symbol> names{Symbol()};
+  for (size_t i = 1; i < offsets.size(); i++) {
+    if (offsets[i] < offsets[i - 1] || offsets[i] > byteCount) {
+      throw corrupted("таблица строк");
+    }
+    names.push_back(Symbol::intern(
+        std::string_view(bytes + offsets[i - 1], offsets[i] - offsets[i - 1])));
+  }
+
+  size_t section = kLeadingSections;
+  std::vector<uint32_t> indices;
+  auto readColumn = [&](auto& column) {
+    using Element = typename std::decay_t<decltype(column)>::value_type;
+    if constexpr (std::is_same<Element, Symbol>::value) {
+      reader.read(section++, indices);
+      column.resize(indices.size());
+      for (size_t i = 0; i < indices.size(); i++) {
+        if (indices[i] >= names.size()) throw corrupted("номер имени вне таблицы строк");
+        column[i] = names[indices[i]];
+      }
+    } else {
+      reader.read(section++, column);
+    }
+  };
+  ast.forEachPool([&readColumn](auto&... columns) { (readColumn(columns), ...); });
+
+  try {
+    ast.validate();
+  } catch (const std::runtime_error& e) {
+    throw FormatError(e.what());
+  }
+  return ast;
+}
+
+FlatAst AstBinary::load(const std::string& path) {
+  SourceBuffer file = SourceBuffer::fromFile(path);
+  return deserialize(file.text());
+}
+
+void AstBinary::writeFile(const std::string& path, std::string_view data) {
+  // Уникальное имя: одновременно пишущие потоки и процессы не мешают
+  // друг другу, а rename выигрывает последний
+  std::string temporary = path + ".tmp.XXXXXX";
+  int fd = mkstemp(&temporary[0]);
+  if (fd >= 0) fchmod(fd, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Не удалось создать файл: " + temporary + ": " +
+                             std::strerror(errno));
+  }
+
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t result = write(fd, data.data() + written, data.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    written += static_cast<size_t>(result);
+  }
+  int error = written == data.size() ? 0 : errno;
+  if (close(fd) != 0 && error == 0) error = errno;
+  if (error == 0 && rename(temporary.c_str(), path.c_str()) != 0) error = errno;
+  if (error != 0) {
+    unlink(temporary.c_str());
+    throw std::runtime_error("Не удалось записать файл: " + path + ": " +
+                             std::strerror(error));
+  }
+}
@@ -0,0 +1,370 @@
+#include "ast_dump.h"
+
+#include "ast_printer.h"
+#include "output_buffer.h"
+#include "static_visitor.h"
+
+namespace {
+
+// Разметка JSON: {"node":"Имя","поле":значение,...}
+struct JsonFormat {
+  static void begin(OutputBuffer& out, const char* kind) { out << "{\"node\":\"" << kind << '"'; }
+  static void field(OutputBuffer& out, const char* name) { out << ",\"" << name << "\":"; }
+  static void end(OutputBuffer& out) { out << '}'; }
+  static void beginList(OutputBuffer& out) { out << '['; }
+  static void separator(OutputBuffer& out) { out << ','; }
+  static void endList(OutputBuffer& out) { out << ']'; }
+  static void null(OutputBuffer& out) { out << "null"; }
+  static void word(OutputBuffer& out, std::string_view text) { string(out, text); }
+
+  // Имена - идентификаторы, но строка экранируется полностью, чтобы
+  // вывод оставался JSON при любом тексте
+  static void string(OutputBuffer& out, std::string_view text) {
+    out << '"';
+    size_t plain = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+      unsigned char c = static_cast<unsigned char>(text[i]);
+      if (c >= 0x20 && c != '"' && c != '\\') continue;
+      out << text.substr(plain, i - plain);
+      if (c == '"' || c == '\\') {
+        out << '\\' << static_cast<char>(c);
+      } else {
+        const char* hex = "0123456789abcdef";
+        out << "\\u00" << hex[c >> 4] << hex[c & 15];
+      }
+      plain = i + 1;
+    }
+    out << text.substr(plain) << '"';
+  }
+};
+
+// Разметка S-выражений: (Имя значение ...)
+struct SexprFormat {
+  static void begin(OutputBuffer& out, const char* kind) { out << '(' << kind; }
+  static void field(OutputBuffer& out, const char*) { out << ' '; }
+  static void end(OutputBuffer& out) { out << ')'; }
+  static void beginList(OutputBuffer& out) { out << '('; }
+  static void separator(OutputBuffer& out) { out << ' '; }
+  static void endList(OutputBuffer& out) { out << ')'; }
+  static void null(OutputBuffer& out) { out << "nil"; }
+  static void word(OutputBuffer& out, std::string_view text) { out << text; }
+  static void string(OutputBuffer& out, std::string_view text) { out << text; }
+};
+
+// Обход один для обоих форматов; Format задаёт только разметку, поэтому
+// её вызовы встраиваются, как и visit при статической диспетчеризации
+template <typename Format>
+class StructuredPrinter : public StaticVisitor<StructuredPrinter<Format>> {
+ public:
+  explicit StructuredPrinter(std::ostream& stream) : out(stream) {}
+
+  void visit(Program& node) {
+    begin("Program");
+    field("mainClass");
+    this->dispatch(*node.mainClass);
+    field("classes");
+    list(node.classes);
+    end();
+    out << '\n';
+    out.flush();
+  }
+
+  void visit(MainClass& node) {
+    begin("MainClass");
+    name("name", node.className);
+    field("statements");
+    list(node.statements);
+    end();
+  }
+
+  void visit(ClassDeclaration& node) {
+    begin("ClassDeclaration");
+    name("name", node.className);
+    name("base", node.baseClassName);
+    field("declarations");
+    list(node.declarations);
+    end();
+  }
+
+  void visit(IntType&) { leaf("IntType"); }
+  void visit(BooleanType&) { leaf("BooleanType"); }
+  void visit(VoidType&) { leaf("VoidType"); }
+
+  void visit(IdentifierType& node) {
+    begin("IdentifierType");
+    name("name", node.typeName);
+    end();
+  }
+
+  void visit(ArrayType& node) {
+    begin("ArrayType");
+    child("elementType", node.elementType);
+    end();
+  }
+
+  void visit(VariableDeclaration& node) {
+    begin("VariableDeclaration");
+    child("type", node.type);
+    name("name", node.name);
+    end();
+  }
+
+  void visit(MethodDeclaration& node) {
+    begin("MethodDeclaration");
+    child("returnType", node.returnType);
+    name("name", node.name);
+    field("parameters");
+    list(node.parameters);
+    field("statements");
+    list(node.statements);
+    end();
+  }
+
+  void visit(AssertStatement& node) {
+    begin("AssertStatement");
+    child("condition", node.condition);
+    end();
+  }
+
+  void visit(LocalVarDeclStatement& node) {
+    begin("LocalVarDeclStatement");
+    child("declaration", node.declaration);
+    end();
+  }
+
+  void visit(BlockStatement& node) {
+    begin("BlockStatement");
+    field("statements");
+    list(node.statements);
+    end();
+  }
+
+  void visit(IfStatement& node) {
+    begin("IfStatement");
+    child("condition", node.condition);
+    child("then", node.thenStatement);
+    child("else", node.elseStatement);
+    end();
+  }
+
+  void visit(WhileStatement& node) {
+    begin("WhileStatement");
+    child("condition", node.condition);
+    child("body", node.body);
+    end();
+  }
+
+  void visit(PrintStatement& node) {
+    begin("PrintStatement");
+    child("expression", node.expression);
+    end();
+  }
+
+  void visit(AssignStatement& node) {
+    begin("AssignStatement");
+    child("lvalue", node.lvalue);
+    child("expression", node.expression);
+    end();
+  }
+
+  void visit(ReturnStatement& node) {
+    begin("ReturnStatement");
+    child("expression", node.expression);
+    end();
+  }
+
+  void visit(MethodInvocationStatement& node) {
+    begin("MethodInvocationStatement");
+    child("invocation", node.invocation);
+    end();
+  }
+
+  void visit(ErrorStatement&) { leaf("ErrorStatement"); }
+
+  void visit(BinaryOperation& node) {
+    begin("BinaryOperation");
+    word("op", operatorText(node.op));
+    child("left", node.left);
+    child("right", node.right);
+    end();
+  }
+
+  void visit(UnaryOperation& node) {
+    begin("UnaryOperation");
+    word("op", operatorText(node.op));
+    child("operand", node.expression);
+    end();
+  }
+
+  void visit(ArrayIndexing& node) {
+    begin("ArrayIndexing");
+    child("array", node.array);
+    child("index", node.index);
+    end();
+  }
+
+  void visit(ArrayLength& node) {
+    begin("ArrayLength");
+    child("array", node.array);
+    end();
+  }
+
+  void visit(MethodInvocation& node) {
+    begin("MethodInvocation");
+    child("object", node.object);
+    name("name", node.methodName);
+    field("arguments");
+    list(node.arguments);
+    end();
+  }
+
+  void visit(FieldAccess& node) {
+    begin("FieldAccess");
+    child("object", node.object);
+    name("name", node.fieldName);
+    end();
+  }
+
+  void visit(NewArray& node) {
+    begin("NewArray");
+    child("elementType", node.elementType);
+    child("size", node.size);
+    end();
+  }
+
+  void visit(NewObject& node) {
+    begin("NewObject");
+    name("name", node.className);
+    end();
+  }
+
+  void visit(IntegerLiteral& node) {
+    begin("IntegerLiteral");
+    field("value");
+    out << node.value;
+    end();
+  }
+
+  void visit(BooleanLiteral& node) {
+    begin("BooleanLiteral");
+    field("value");
+    out << (node.value ? "true" : "false");
+    end();
+  }
+
+  void visit(ThisExpression&) { leaf("ThisExpression"); }
+
+  void visit(IdentifierExpression& node) {
+    begin("IdentifierExpression");
+    name("name", node.name);
+    end();
+  }
+
+  void visit(ErrorExpression&) { leaf("ErrorExpression"); }
+
+  void visit(IdentifierLValue& node) {
+    begin("IdentifierLValue");
+    name("name", node.name);
+    end();
+  }
+
+  void visit(ArrayAccess& node) {
+    begin("ArrayAccess");
+    name("name", node.arrayName);
+    child("index", node.index);
+    end();
+  }
+
+  void visit(SimpleFieldInvocation& node) {
+    begin("SimpleFieldInvocation");
+    name("name", node.fieldName);
+    end();
+  }
+
+  void visit(FieldArrayInvocation& node) {
+    begin("FieldArrayInvocation");
+    name("name", node.fieldName);
+    child("index", node.index);
+    end();
+  }
+
+ private:
+  OutputBuffer out;
+
+  void begin(const char* kind) { Format::begin(out, kind); }
+  void field(const char* field) { Format::field(out, field); }
+  void end() { Format::end(out); }
+
+  void leaf(const char* kind) {
+    begin(kind);
+    end();
+  }
+
+  void child(const char* field, ASTNode* node) {
+    this->field(field);
+    if (node) {
+      this->dispatch(*node);
+    } else {
+      Format::null(out);
+    }
+  }
+
+  void name(const char* field, Symbol symbol) {
+    this->field(field);
+    if (symbol.empty()) {
+      Format::null(out);
+    } else {
+      Format::string(out, symbol.str());
+    }
+  }
+
+  void word(const char* field, const char* text) {
+    this->field(field);
+    Format::word(out, text);
+  }
+
+  template <typename T>
+  void list(AstList<T> items) {
+    Format::beginList(out);
+    for (size_t i = 0; i < items.size(); i++) {
+      if (i > 0) Format::separator(out);
+      this->dispatch(*items[i]);
+    }
+    Format::endList(out);
+  }
+};
+
+}  // namespace
+
+bool parseAstFormat(std::string_view name, AstFormat& format) {
+  if (name == "tree") {
+    format = AstFormat::Tree;
+  } else if (name == "json") {
+    format = AstFormat::Json;
+  } else if (name == "sexpr") {
+    format = AstFormat::Sexpr;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void dumpAst(Program& program, AstFormat format, std::ostream& out) {
+  switch (format) {
+    case AstFormat::Tree: {
+      ASTPrinter printer(out);
+      program.accept(printer);
+      break;
+    }
+    case AstFormat::Json: {
+      StructuredPrinter<JsonFormat> printer(out);
+      printer.dispatch(program);
+      break;
+    }
+    case AstFormat::Sexpr: {
+      StructuredPrinter<SexprFormat> printer(out);
+      printer.dispatch(program);
+      break;
+    }
+  }
+}
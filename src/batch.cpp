@@ -0,0 +1,223 @@
+#include "batch.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+
+#include "ast_binary.h"
+#include "compile_cache.h"
+#include "driver.h"
+#include "parallel.h"
+#include "parser.h"
+#include "source_buffer.h"
+
+namespace {
+
+// Результат одного файла; заполняется рабочим потоком, читается
+// при выводе и подсчёте итогов
+struct FileResult {
+  bool failed = false;
+  bool cached = false;
+  uint64_t tokens = 0;
+  std::string messages;
+  double readSeconds = 0;
+  double parseSeconds = 0;
+  double semanticSeconds = 0;
+  double cacheSeconds = 0;
+  double emitSeconds = 0;
+};
+
+// Время от предыдущей отметки
+class Stopwatch {
+ public:
+  double lap() {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - last).count();
+    last = now;
+    return seconds;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+};
+
+bool isDirectory(const std::string& path) {
+  struct stat info;
+  return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool hasJavaSuffix(const std::string& name) {
+  return name.size() > 5 && name.compare(name.size() - 5, 5, ".java") == 0;
+}
+
+// Файлы .java каталога и его подкаталогов; имена внутри каталога
+// сортируются, чтобы список не зависел от порядка readdir. Ссылки на
+// каталоги не обходятся: петля из ссылок дала бы бесконечную рекурсию
+void collectDirectory(const std::string& path, std::vector<std::string>& files) {
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) throw std::runtime_error("Не удалось открыть каталог: " + path);
+  std::vector<std::string> names;
+  while (struct dirent* item = readdir(dir)) {
+    std::string name = item->d_name;
+    if (name != "." && name != "..") names.push_back(name);
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+
+  for (const std::string& name : names) {
+    std::string child = path + "/" + name;
+    struct stat info;
+    if (lstat(child.c_str(), &info) != 0) continue;
+    if (S_ISDIR(info.st_mode)) {
+      collectDirectory(child, files);
+    } else if (S_ISLNK(info.st_mode) && isDirectory(child)) {
+      continue;
+    } else if (hasJavaSuffix(name)) {
+      files.push_back(child);
+    }
+  }
+}
+
+void expandPath(const std::string& path, std::vector<std::string>& files) {
+  if (isDirectory(path)) {
+    collectDirectory(path, files);
+  } else {
+    files.push_back(path);
+  }
+}
+
+void compileFile(const std::string& path, const BatchCompiler::Options& options,
+                 FileResult& result) {
+  Stopwatch watch;
+  try {
+    SourceBuffer source = SourceBuffer::fromFile(path);
+    result.readSeconds = watch.lap();
+    if (source.empty()) {
+      result.failed = true;
+      result.messages += path + ": Файл пуст или не может быть прочитан.\n";
+      return;
+    }
+
+    // Фазы те же, что у одиночной компиляции; ошибка кэша не мешает
+    // компиляции файла
+    CompileDriver::Options driverOptions;
+    driverOptions.emitBinary = options.emitBinary;
+    CompileDriver::Stages stages = CompileDriver(driverOptions, options.cache).runStages(source);
+    watch.lap();
+    if (!stages.cacheError.empty()) {
+      result.messages += path + ": Предупреждение: " + stages.cacheError + "\n";
+    }
+    result.cached = stages.cached;
+    result.parseSeconds = stages.parseSeconds;
+    result.semanticSeconds = stages.semanticSeconds;
+    result.cacheSeconds = stages.cacheSeconds;
+
+    const CompileCache::Entry& entry = stages.entry;
+    result.tokens = entry.tokenCount;
+    result.failed = !entry.diagnostics.empty();
+    for (const Parser::Diagnostic& diagnostic : entry.diagnostics) {
+      result.messages += path + ": " + diagnostic.message + "\n";
+    }
+    if (!result.failed && options.emitBinary) {
+      AstBinary::writeFile(path + ".ast", entry.ast);
+      result.emitSeconds = watch.lap();
+    }
+  } catch (const std::exception& e) {
+    result.failed = true;
+    result.messages += path + ": Ошибка: " + e.what() + "\n";
+  }
+}
+
+}  // namespace
+
+bool BatchCompiler::needsBatch(const std::vector<std::string>& arguments) {
+  return arguments.size() > 1 ||
+         (arguments.size() == 1 && (arguments[0].rfind('@', 0) == 0 || isDirectory(arguments[0])));
+}
+
+std::vector<std::string> BatchCompiler::expandInputs(const std::vector<std::string>& arguments) {
+  std::vector<std::string> files;
+  for (const std::string& argument : arguments) {
+    if (argument.rfind('@', 0) != 0) {
+      expandPath(argument, files);
+      continue;
+    }
+
+    std::string listPath = argument.substr(1);
+    std::ifstream list(listPath);
+    if (!list) throw std::runtime_error("Не удалось открыть список файлов: " + listPath);
+    std::string line;
+    while (std::getline(list, line)) {
+      size_t begin = line.find_first_not_of(" \t\r");
+      if (begin == std::string::npos || line[begin] == '#') continue;
+      size_t end = line.find_last_not_of(" \t\r");
+      expandPath(line.substr(begin, end - begin + 1), files);
+    }
+  }
+  return files;
+}
+
+BatchCompiler::Summary BatchCompiler::run(const std::vector<std::string>& files,
+                                          std::ostream& diagnostics) {
+  Stopwatch wall;
+  std::vector<FileResult> results(files.size());
+
+  // Сообщения выводятся по порядку: файл, закончивший работу, выводит
+  // себя и все готовые файлы за ним, если предыдущие уже выведены
+  std::mutex outputMutex;
+  std::vector<char> done(files.size(), 0);
+  size_t nextToPrint = 0;
+
+  Summary summary;
+  summary.files = files.size();
+  summary.threads = static_cast<unsigned>(
+      std::min<size_t>(resolveThreads(options.jobs), std::max<size_t>(files.size(), 1)));
+
+  runWorkStealing(files.size(), options.jobs, [&](size_t index) {
+    compileFile(files[index], options, results[index]);
+
+    std::lock_guard<std::mutex> lock(outputMutex);
+    done[index] = 1;
+    for (; nextToPrint < files.size() && done[nextToPrint]; nextToPrint++) {
+      diagnostics << results[nextToPrint].messages;
+      results[nextToPrint].messages.clear();
+    }
+    diagnostics.flush();
+  });
+
+  for (const FileResult& result : results) {
+    summary.failed += result.failed;
+    summary.cacheHits += result.cached;
+    summary.tokens += result.tokens;
+    summary.readSeconds += result.readSeconds;
+    summary.parseSeconds += result.parseSeconds;
+    summary.semanticSeconds += result.semanticSeconds;
+    summary.cacheSeconds += result.cacheSeconds;
+    summary.emitSeconds += result.emitSeconds;
+  }
+  summary.wallSeconds = wall.lap();
+  return summary;
+}
+
+void BatchCompiler::printSummary(const Summary& summary, std::ostream& out) {
+  auto ms = [](double seconds) { return seconds * 1000; };
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(1);
+  out << "Файлов: " << summary.files << ", с ошибками: " << summary.failed
+      << ", из кэша: " << summary.cacheHits << ", токенов: " << summary.tokens << std::endl;
+  out << "Время фаз (сумма по потокам): чтение " << ms(summary.readSeconds)
+      << " мс, лексер и парсер " << ms(summary.parseSeconds)
+      << " мс, семантика " << ms(summary.semanticSeconds) << " мс, кэш "
+      << ms(summary.cacheSeconds) << " мс, запись .ast " << ms(summary.emitSeconds) << " мс"
+      << std::endl;
+  double perSecond = summary.wallSeconds > 0 ? summary.files / summary.wallSeconds : 0;
+  out << "Всего: " << ms(summary.wallSeconds) << " мс, потоков: " << summary.threads
+      << ", файлов в секунду: " << std::setprecision(0) << perSecond << std::endl;
+  out.flags(flags);
+}
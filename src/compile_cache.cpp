@@ -0,0 +1,261 @@
+#include "compile_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "ast_binary.h"
+#include "hash.h"
+#include "source_buffer.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'M', 'J', 'C', 'E'};
+constexpr char kSuffix[] = ".mjc";
+constexpr size_t kSuffixLength = sizeof(kSuffix) - 1;
+constexpr char kStatsFile[] = "stats";
+
+// Заголовок записи; за ним идут диагностики (строка, столбец, длина
+// и текст сообщения), а после них до конца файла - дерево
+struct EntryHeader {
+  char magic[4];
+  uint32_t compilerVersion;
+  uint64_t sourceHash;
+  uint64_t sourceSize;
+  uint64_t tokenCount;
+  uint32_t diagnosticCount;
+  uint32_t reserved;
+};
+
+struct DiagnosticHeader {
+  int32_t line;
+  int32_t column;
+  uint32_t length;
+};
+
+std::runtime_error systemError(const std::string& what, const std::string& path) {
+  return std::runtime_error(what + ": " + path + ": " + std::strerror(errno));
+}
+
+template <typename T>
+void append(std::string& out, const T& value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::string encode(std::string_view source, const CompileCache::Entry& entry) {
+  std::string out;
+  EntryHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.compilerVersion = CompileCache::kCompilerVersion;
+  header.sourceHash = xxh64(source);
+  header.sourceSize = source.size();
+  header.tokenCount = entry.tokenCount;
+  header.diagnosticCount = static_cast<uint32_t>(entry.diagnostics.size());
+  append(out, header);
+  for (const Parser::Diagnostic& diagnostic : entry.diagnostics) {
+    append(out, DiagnosticHeader{diagnostic.line, diagnostic.column,
+                                 static_cast<uint32_t>(diagnostic.message.size())});
+    out += diagnostic.message;
+  }
+  out += entry.ast;
+  return out;
+}
+
+// Разбор записи; false, если она обрезана, другой версии или построена
+// не по тексту source (совпадение ключей разных текстов)
+bool decode(std::string_view data, std::string_view source, CompileCache::Entry& entry) {
+  EntryHeader header;
+  if (data.size() < sizeof(header)) return false;
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.compilerVersion != CompileCache::kCompilerVersion ||
+      header.sourceSize != source.size() || header.sourceHash != xxh64(source)) {
+    return false;
+  }
+  data.remove_prefix(sizeof(header));
+
+  entry.tokenCount = header.tokenCount;
+  entry.diagnostics.clear();
+  for (uint32_t i = 0; i < header.diagnosticCount; i++) {
+    DiagnosticHeader diagnostic;
+    if (data.size() < sizeof(diagnostic)) return false;
+    std::memcpy(&diagnostic, data.data(), sizeof(diagnostic));
+    data.remove_prefix(sizeof(diagnostic));
+    if (data.size() < diagnostic.length) return false;
+    entry.diagnostics.push_back(Parser::Diagnostic{
+        diagnostic.line, diagnostic.column, std::string(data.substr(0, diagnostic.length))});
+    data.remove_prefix(diagnostic.length);
+  }
+  entry.ast.assign(data.data(), data.size());
+  return true;
+}
+
+// Дескриптор, который закрывается при выходе из области видимости
+class Descriptor {
+ public:
+  explicit Descriptor(int fd) : fd(fd) {}
+  ~Descriptor() {
+    if (fd >= 0) close(fd);
+  }
+  Descriptor(const Descriptor&) = delete;
+  Descriptor& operator=(const Descriptor&) = delete;
+  int get() const { return fd; }
+
+ private:
+  int fd;
+};
+
+}  // namespace
+
+CompileCache::CompileCache(std::string directory, uint64_t maxBytes)
+    : root(std::move(directory)), maxBytes(maxBytes) {
+  if (mkdir(root.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw systemError("Не удалось создать каталог кэша", root);
+  }
+  struct stat info;
+  if (stat(root.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+    throw std::runtime_error("Каталог кэша недоступен: " + root);
+  }
+}
+
+uint64_t CompileCache::makeKey(std::string_view source, std::string_view options) {
+  // Версии формата дерева и компилятора входят в ключ: после обновления
+  // старые записи просто перестают находиться и со временем вытесняются
+  std::string salt = "minijava/" + std::to_string(kCompilerVersion) + "/" +
+                     std::to_string(AstBinary::kVersion) + "/";
+  salt += options;
+  return xxh64(source, xxh64(salt));
+}
+
+std::string CompileCache::pathFor(uint64_t key) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+  return root + "/" + name + kSuffix;
+}
+
+template <typename F>
+void CompileCache::updateStats(F&& update) {
+  std::string path = root + "/" + kStatsFile;
+  Descriptor file(open(path.c_str(), O_RDWR | O_CREAT, 0644));
+  if (file.get() < 0) throw systemError("Не удалось открыть файл", path);
+  while (flock(file.get(), LOCK_EX) != 0) {
+    if (errno != EINTR) throw systemError("Не удалось заблокировать файл", path);
+  }
+  // Короткий или пустой файл - новый каталог: счётчики с нуля
+  Stats current;
+  if (pread(file.get(), &current, sizeof(current), 0) != sizeof(current)) current = Stats();
+  update(current);
+  if (pwrite(file.get(), &current, sizeof(current), 0) != sizeof(current)) {
+    throw systemError("Не удалось записать файл", path);
+  }
+  // Блокировка снимается при закрытии дескриптора
+}
+
+CompileCache::Stats CompileCache::stats() const {
+  Stats current;
+  std::string path = root + "/" + kStatsFile;
+  Descriptor file(open(path.c_str(), O_RDONLY));
+  if (file.get() < 0) return current;
+  flock(file.get(), LOCK_SH);
+  if (pread(file.get(), &current, sizeof(current), 0) != sizeof(current)) current = Stats();
+  return current;
+}
+
+bool CompileCache::lookup(uint64_t key, std::string_view source, Entry& entry) {
+  std::string path = pathFor(key);
+  bool hit = false;
+  try {
+    SourceBuffer file = SourceBuffer::fromFile(path);
+    hit = decode(file.text(), source, entry);
+    // Дерево есть ровно у записей без ошибок
+    if (hit && !entry.diagnostics.empty() == !entry.ast.empty()) hit = false;
+    // Дерево записи используется вместо разбора source, поэтому его
+    // заголовок тоже должен указывать на этот текст
+    if (hit && !entry.ast.empty() &&
+        (!AstBinary::isBinary(entry.ast) ||
+         !AstBinary::matchesSource(AstBinary::readHeader(entry.ast), source))) {
+      hit = false;
+    }
+    if (!hit) unlink(path.c_str());
+  } catch (const std::exception&) {
+    // Записи нет или она не читается: обычный промах
+    hit = false;
+  }
+
+  if (hit) {
+    // Время использования для LRU; ошибка здесь не мешает попаданию
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+  }
+  updateStats([hit](Stats& stats) { (hit ? stats.hits : stats.misses)++; });
+  return hit;
+}
+
+void CompileCache::store(uint64_t key, std::string_view source, const Entry& entry) {
+  std::string data = encode(source, entry);
+  std::string path = pathFor(key);
+  // Перезапись ключа заменяет старую запись, а не добавляет к ней
+  uint64_t replaced = 0;
+  struct stat info;
+  if (stat(path.c_str(), &info) == 0) replaced = static_cast<uint64_t>(info.st_size);
+  AstBinary::writeFile(path, data);
+  bool overflow = false;
+  updateStats([&](Stats& stats) {
+    stats.stores++;
+    stats.bytes -= std::min(stats.bytes, replaced);
+    stats.bytes += data.size();
+    overflow = stats.bytes > maxBytes;
+  });
+  if (overflow) evict();
+}
+
+size_t CompileCache::evict() {
+  struct Record {
+    struct timespec used;
+    uint64_t size;
+    std::string path;
+  };
+  std::vector<Record> records;
+  uint64_t total = 0;
+
+  DIR* dir = opendir(root.c_str());
+  if (dir == nullptr) throw systemError("Не удалось открыть каталог кэша", root);
+  while (struct dirent* item = readdir(dir)) {
+    size_t length = std::strlen(item->d_name);
+    if (length <= kSuffixLength ||
+        std::strcmp(item->d_name + length - kSuffixLength, kSuffix) != 0) {
+      continue;  // stats, временные файлы записи
+    }
+    std::string path = root + "/" + item->d_name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) continue;  // удалена другим процессом
+    records.push_back(Record{info.st_mtim, static_cast<uint64_t>(info.st_size), path});
+    total += records.back().size;
+  }
+  closedir(dir);
+
+  std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+    if (a.used.tv_sec != b.used.tv_sec) return a.used.tv_sec < b.used.tv_sec;
+    return a.used.tv_nsec < b.used.tv_nsec;
+  });
+  uint64_t target = maxBytes / 4 * 3;
+  size_t removed = 0;
+  for (const Record& record : records) {
+    if (total <= target) break;
+    if (unlink(record.path.c_str()) == 0) removed++;
+    total -= record.size;
+  }
+
+  updateStats([&](Stats& stats) {
+    stats.evictions += removed;
+    stats.bytes = total;
+  });
+  return removed;
+}
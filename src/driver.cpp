@@ -0,0 +1,194 @@
+#include "driver.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "ast_binary.h"
+#include "ast_printer.h"
+#include "compile_cache.h"
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+#include "source_buffer.h"
+
+namespace {
+
+// Файл name.ast по умолчанию лежит рядом со своим исходником name:
+// если исходник есть и изменился после записи дерева, выводится
+// предупреждение, что дерево устарело
+void warnIfStale(const std::string& name, std::string_view data, std::ostream& err) {
+  const std::string suffix = ".ast";
+  if (name.size() <= suffix.size() ||
+      name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+    return;
+  }
+  std::string sourcePath = name.substr(0, name.size() - suffix.size());
+  SourceBuffer source;
+  try {
+    source = SourceBuffer::fromFile(sourcePath);
+  } catch (const std::exception&) {
+    return;  // Исходника нет: сравнивать не с чем
+  }
+  if (!AstBinary::matchesSource(AstBinary::readHeader(data), source.text())) {
+    err << "Предупреждение: " << name << " построен не по текущему тексту " << sourcePath
+        << std::endl;
+  }
+}
+
+}  // namespace
+
+CompileDriver::Stages CompileDriver::runStages(const SourceBuffer& source) const {
+  Stages stages;
+  CompileCache::Entry& entry = stages.entry;
+  CompileCache* cache = this->cache;
+  auto disableCache = [&stages, &cache](const std::exception& e) {
+    stages.cacheError = e.what();
+    cache = nullptr;
+  };
+  auto last = std::chrono::steady_clock::now();
+  auto lap = [&last] {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - last).count();
+    last = now;
+    return seconds;
+  };
+
+  // При попадании в кэш лексер и парсер не запускаются: число
+  // токенов, диагностики и дерево берутся из записи
+  uint64_t key = 0;
+  if (cache) {
+    key = CompileCache::makeKey(source.text(), CompileCache::kDriverOptions);
+    try {
+      stages.cached = cache->lookup(key, source.text(), entry);
+    } catch (const std::exception& e) {
+      disableCache(e);
+    }
+    stages.cacheSeconds += lap();
+    if (stages.cached) return stages;
+  }
+
+  // Лексический и синтаксический анализ идут одним потоком:
+  // парсер запрашивает токены у лексера по мере надобности.
+  // В параллельном режиме токены сначала собираются в вектор,
+  // а классы разбираются независимо друг от друга
+  Lexer lexer(source);
+  std::vector<Token> tokens;
+  if (options.parallel) tokens = lexer.tokenizeParallel(options.jobs);
+  Parser parser = options.parallel ? Parser(tokens) : Parser(lexer);
+  parser.setRecovery(true);
+  stages.program = options.parallel ? parser.parseProgramParallel(options.jobs) : parser.parseProgram();
+  entry.tokenCount = parser.tokenCount();
+  entry.diagnostics = parser.diagnostics();
+  stages.parseSeconds = lap();
+
+  // Семантический анализ - только для синтаксически верной
+  // программы; его ошибки кэшируются вместе с ошибками разбора
+  if (entry.diagnostics.empty()) {
+    SemanticAnalyzer& analyzer = SemanticAnalyzer::forThread();
+    analyzer.analyze(*stages.program);
+    for (const SemanticAnalyzer::Diagnostic& diagnostic : analyzer.diagnostics()) {
+      entry.diagnostics.push_back(Parser::Diagnostic{0, 0, diagnostic.message});
+    }
+    stages.semanticSeconds = lap();
+  }
+
+  if (entry.diagnostics.empty() && (cache || options.emitBinary)) {
+    entry.ast = AstBinary::serialize(FlatAst::fromProgram(*stages.program), source.text());
+  }
+  if (cache) {
+    try {
+      cache->store(key, source.text(), entry);
+    } catch (const std::exception& e) {
+      disableCache(e);
+    }
+  }
+  stages.cacheSeconds += lap();
+  return stages;
+}
+
+int CompileDriver::compile(const std::string& path, std::ostream& out, std::ostream& err) {
+  // Чтение исходного файла (обычные файлы отображаются в память)
+  SourceBuffer source;
+  try {
+    source = SourceBuffer::fromFile(path);
+  } catch (const std::exception& e) {
+    err << e.what() << std::endl;
+    return 1;
+  }
+  return compile(path, source, out, err);
+}
+
+int CompileDriver::compile(const std::string& name, const SourceBuffer& source,
+                           std::ostream& out, std::ostream& err) {
+  if (source.empty()) {
+    err << "Файл пуст или не может быть прочитан." << std::endl;
+    return 1;
+  }
+
+  // Двоичный файл AST, записанный ключом --emit-ast=bin: лексер
+  // и парсер не нужны
+  if (AstBinary::isBinary(source.text())) {
+    try {
+      FlatAst flat = AstBinary::deserialize(source.text());
+      warnIfStale(name, source.text(), err);
+      if (options.format == AstFormat::Tree) {
+        out << "AST загружено из двоичного файла. Узлов: " << flat.nodeCount() << std::endl;
+        out << "AST дерево:" << std::endl;
+        ASTPrinter printer(out);
+        flat.materializeAndAccept(printer);
+      } else {
+        dumpAst(*flat.toProgram(), options.format, out);
+      }
+    } catch (const std::exception& e) {
+      err << "Ошибка: " << e.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  try {
+    // Кэш не обязателен: после ошибки компиляция продолжается без него
+    Stages stages = runStages(source);
+    if (!stages.cacheError.empty()) {
+      err << "Предупреждение: " << stages.cacheError << ", кэш отключён" << std::endl;
+    }
+    const CompileCache::Entry& entry = stages.entry;
+
+    // Все синтаксические (или семантические) ошибки файла собираются
+    // за один проход
+    if (!entry.diagnostics.empty()) {
+      for (const Parser::Diagnostic& diagnostic : entry.diagnostics) {
+        err << diagnostic.message << std::endl;
+      }
+      return 1;
+    }
+
+    if (options.emitBinary) {
+      std::string output = options.output;
+      if (output.empty()) {
+        if (name == "-") {
+          err << "Для стандартного ввода нужен ключ --output=PATH" << std::endl;
+          return 1;
+        }
+        output = name + ".ast";
+      }
+      AstBinary::writeFile(output, entry.ast);
+    }
+
+    if (options.format == AstFormat::Tree) {
+      out << "Лексический анализ завершен. Найдено токенов: " << entry.tokenCount << std::endl;
+      out << "Синтаксический анализ завершен. AST дерево:" << std::endl;
+    }
+
+    // Вывод AST
+    std::unique_ptr<Program> program = std::move(stages.program);
+    if (!program) program = AstBinary::deserialize(entry.ast).toProgram();
+    dumpAst(*program, options.format, out);
+  } catch (const std::exception& e) {
+    err << "Ошибка: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,724 @@
+#include "flat_ast.h"
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+using NodeId = FlatAst::NodeId;
+using Range = FlatAst::Range;
+
+// Переводит дерево объектов в пулы. Каждый visit первым делом
+// регистрирует свой узел, поэтому номер узла известен до обхода
+// детей и номера идут в прямом порядке обхода
+class FlatBuilder : public Visitor {
+ public:
+  explicit FlatBuilder(FlatAst& ast) : ast(ast) {}
+
+  NodeId convert(ASTNode* node) {
+    if (!node) return FlatAst::kNone;
+    NodeId id = static_cast<NodeId>(ast.kinds.size());
+    node->accept(*this);
+    return id;
+  }
+
+  // Дети списка переводятся раньше, чем список попадает в lists:
+  // их собственные списки ложатся в lists первыми
+  template <typename T>
+  Range convertList(const AstList<T>& nodes) {
+    size_t base = scratch.size();
+    for (T* node : nodes) {
+      NodeId id = convert(node);
+      scratch.push_back(id);
+    }
+    Range range{static_cast<uint32_t>(ast.lists.size()),
+                static_cast<uint32_t>(scratch.size() - base)};
+    ast.lists.insert(ast.lists.end(), scratch.begin() + base, scratch.end());
+    scratch.resize(base);
+    return range;
+  }
+
+  void visit(Program& node) override {
+    ast.mainClass = convert(node.mainClass);
+    ast.classes = convertList(node.classes);
+  }
+
+  void visit(MainClass& node) override {
+    uint32_t s = add(NodeKind::MainClass, ast.mainClasses.name.size());
+    ast.mainClasses.name.push_back(node.className);
+    ast.mainClasses.statements.emplace_back();
+    Range statements = convertList(node.statements);
+    ast.mainClasses.statements[s] = statements;
+  }
+
+  void visit(ClassDeclaration& node) override {
+    auto& pool = ast.classDeclarations;
+    uint32_t s = add(NodeKind::ClassDeclaration, pool.name.size());
+    pool.name.push_back(node.className);
+    pool.baseName.push_back(node.baseClassName);
+    pool.declarations.emplace_back();
+    Range declarations = convertList(node.declarations);
+    pool.declarations[s] = declarations;
+  }
+
+  void visit(IntType&) override { add(NodeKind::IntType, 0); }
+  void visit(BooleanType&) override { add(NodeKind::BooleanType, 0); }
+  void visit(VoidType&) override { add(NodeKind::VoidType, 0); }
+
+  void visit(IdentifierType& node) override {
+    add(NodeKind::IdentifierType, ast.identifierTypes.name.size());
+    ast.identifierTypes.name.push_back(node.typeName);
+  }
+
+  void visit(ArrayType& node) override {
+    uint32_t s = add(NodeKind::ArrayType, ast.arrayTypes.elementType.size());
+    ast.arrayTypes.elementType.push_back(FlatAst::kNone);
+    NodeId element = convert(node.elementType);
+    ast.arrayTypes.elementType[s] = element;
+  }
+
+  void visit(VariableDeclaration& node) override {
+    uint32_t s = add(NodeKind::VariableDeclaration, ast.variables.name.size());
+    ast.variables.name.push_back(node.name);
+    ast.variables.type.push_back(FlatAst::kNone);
+    NodeId type = convert(node.type);
+    ast.variables.type[s] = type;
+  }
+
+  void visit(MethodDeclaration& node) override {
+    auto& pool = ast.methods;
+    uint32_t s = add(NodeKind::MethodDeclaration, pool.name.size());
+    pool.name.push_back(node.name);
+    pool.returnType.push_back(FlatAst::kNone);
+    pool.parameters.emplace_back();
+    pool.statements.emplace_back();
+    NodeId returnType = convert(node.returnType);
+    pool.returnType[s] = returnType;
+    Range parameters = convertList(node.parameters);
+    pool.parameters[s] = parameters;
+    Range statements = convertList(node.statements);
+    pool.statements[s] = statements;
+  }
+
+  void visit(AssertStatement& node) override {
+    unaryStatement(NodeKind::AssertStatement, node.condition);
+  }
+
+  void visit(LocalVarDeclStatement& node) override {
+    unaryStatement(NodeKind::LocalVarDeclStatement, node.declaration);
+  }
+
+  void visit(BlockStatement& node) override {
+    uint32_t s = add(NodeKind::BlockStatement, ast.blocks.statements.size());
+    ast.blocks.statements.emplace_back();
+    Range statements = convertList(node.statements);
+    ast.blocks.statements[s] = statements;
+  }
+
+  void visit(IfStatement& node) override {
+    auto& pool = ast.ifStatements;
+    uint32_t s = add(NodeKind::IfStatement, pool.condition.size());
+    pool.condition.push_back(FlatAst::kNone);
+    pool.thenStatement.push_back(FlatAst::kNone);
+    pool.elseStatement.push_back(FlatAst::kNone);
+    NodeId condition = convert(node.condition);
+    pool.condition[s] = condition;
+    NodeId thenStatement = convert(node.thenStatement);
+    pool.thenStatement[s] = thenStatement;
+    NodeId elseStatement = convert(node.elseStatement);
+    pool.elseStatement[s] = elseStatement;
+  }
+
+  void visit(WhileStatement& node) override {
+    auto& pool = ast.whileStatements;
+    uint32_t s = add(NodeKind::WhileStatement, pool.condition.size());
+    pool.condition.push_back(FlatAst::kNone);
+    pool.body.push_back(FlatAst::kNone);
+    NodeId condition = convert(node.condition);
+    pool.condition[s] = condition;
+    NodeId body = convert(node.body);
+    pool.body[s] = body;
+  }
+
+  void visit(PrintStatement& node) override {
+    unaryStatement(NodeKind::PrintStatement, node.expression);
+  }
+
+  void visit(AssignStatement& node) override {
+    auto& pool = ast.assignStatements;
+    uint32_t s = add(NodeKind::AssignStatement, pool.lvalue.size());
+    pool.lvalue.push_back(FlatAst::kNone);
+    pool.expression.push_back(FlatAst::kNone);
+    NodeId lvalue = convert(node.lvalue);
+    pool.lvalue[s] = lvalue;
+    NodeId expression = convert(node.expression);
+    pool.expression[s] = expression;
+  }
+
+  void visit(ReturnStatement& node) override {
+    unaryStatement(NodeKind::ReturnStatement, node.expression);
+  }
+
+  void visit(MethodInvocationStatement& node) override {
+    unaryStatement(NodeKind::MethodInvocationStatement, node.invocation);
+  }
+
+  void visit(ErrorStatement&) override { add(NodeKind::ErrorStatement, 0); }
+
+  void visit(BinaryOperation& node) override {
+    auto& pool = ast.binaryOperations;
+    uint32_t s = add(NodeKind::BinaryOperation, pool.op.size());
+    pool.op.push_back(node.op);
+    pool.left.push_back(FlatAst::kNone);
+    pool.right.push_back(FlatAst::kNone);
+    NodeId left = convert(node.left);
+    pool.left[s] = left;
+    NodeId right = convert(node.right);
+    pool.right[s] = right;
+  }
+
+  void visit(UnaryOperation& node) override {
+    auto& pool = ast.unaryOperations;
+    uint32_t s = add(NodeKind::UnaryOperation, pool.op.size());
+    pool.op.push_back(node.op);
+    pool.operand.push_back(FlatAst::kNone);
+    NodeId operand = convert(node.expression);
+    pool.operand[s] = operand;
+  }
+
+  void visit(ArrayIndexing& node) override {
+    auto& pool = ast.arrayIndexings;
+    uint32_t s = add(NodeKind::ArrayIndexing, pool.array.size());
+    pool.array.push_back(FlatAst::kNone);
+    pool.index.push_back(FlatAst::kNone);
+    NodeId array = convert(node.array);
+    pool.array[s] = array;
+    NodeId index = convert(node.index);
+    pool.index[s] = index;
+  }
+
+  void visit(ArrayLength& node) override {
+    uint32_t s = add(NodeKind::ArrayLength, ast.arrayLengths.array.size());
+    ast.arrayLengths.array.push_back(FlatAst::kNone);
+    NodeId array = convert(node.array);
+    ast.arrayLengths.array[s] = array;
+  }
+
+  void visit(MethodInvocation& node) override {
+    auto& pool = ast.methodInvocations;
+    uint32_t s = add(NodeKind::MethodInvocation, pool.name.size());
+    pool.name.push_back(node.methodName);
+    pool.object.push_back(FlatAst::kNone);
+    pool.arguments.emplace_back();
+    NodeId object = convert(node.object);
+    pool.object[s] = object;
+    Range arguments = convertList(node.arguments);
+    pool.arguments[s] = arguments;
+  }
+
+  void visit(FieldAccess& node) override {
+    auto& pool = ast.fieldAccesses;
+    uint32_t s = add(NodeKind::FieldAccess, pool.name.size());
+    pool.name.push_back(node.fieldName);
+    pool.object.push_back(FlatAst::kNone);
+    NodeId object = convert(node.object);
+    pool.object[s] = object;
+  }
+
+  void visit(NewArray& node) override {
+    auto& pool = ast.newArrays;
+    uint32_t s = add(NodeKind::NewArray, pool.size.size());
+    pool.elementType.push_back(FlatAst::kNone);
+    pool.size.push_back(FlatAst::kNone);
+    NodeId elementType = convert(node.elementType);
+    pool.elementType[s] = elementType;
+    NodeId size = convert(node.size);
+    pool.size[s] = size;
+  }
+
+  void visit(NewObject& node) override {
+    name(NodeKind::NewObject, node.className);
+  }
+
+  void visit(IntegerLiteral& node) override {
+    add(NodeKind::IntegerLiteral, ast.integerLiterals.value.size());
+    ast.integerLiterals.value.push_back(node.value);
+  }
+
+  void visit(BooleanLiteral& node) override {
+    add(NodeKind::BooleanLiteral, ast.booleanLiterals.value.size());
+    ast.booleanLiterals.value.push_back(node.value ? 1 : 0);
+  }
+
+  void visit(ThisExpression&) override { add(NodeKind::ThisExpression, 0); }
+
+  void visit(IdentifierExpression& node) override {
+    name(NodeKind::IdentifierExpression, node.name);
+  }
+
+  void visit(ErrorExpression&) override { add(NodeKind::ErrorExpression, 0); }
+
+  void visit(IdentifierLValue& node) override {
+    name(NodeKind::IdentifierLValue, node.name);
+  }
+
+  void visit(ArrayAccess& node) override {
+    indexedName(NodeKind::ArrayAccess, node.arrayName, node.index);
+  }
+
+  void visit(SimpleFieldInvocation& node) override {
+    name(NodeKind::SimpleFieldInvocation, node.fieldName);
+  }
+
+  void visit(FieldArrayInvocation& node) override {
+    indexedName(NodeKind::FieldArrayInvocation, node.fieldName, node.index);
+  }
+
+ private:
+  FlatAst& ast;
+  std::vector<NodeId> scratch;
+
+  // Регистрирует узел вида kind с записью slot; возвращает slot
+  uint32_t add(NodeKind kind, size_t slot) {
+    ast.kinds.push_back(kind);
+    ast.slots.push_back(static_cast<uint32_t>(slot));
+    return static_cast<uint32_t>(slot);
+  }
+
+  void unaryStatement(NodeKind kind, ASTNode* child) {
+    auto& pool = ast.unaryStatements;
+    uint32_t s = add(kind, pool.child.size());
+    pool.child.push_back(FlatAst::kNone);
+    NodeId converted = convert(child);
+    pool.child[s] = converted;
+  }
+
+  void name(NodeKind kind, Symbol symbol) {
+    add(kind, ast.names.name.size());
+    ast.names.name.push_back(symbol);
+  }
+
+  void indexedName(NodeKind kind, Symbol symbol, Expression* index) {
+    auto& pool = ast.indexedNames;
+    uint32_t s = add(kind, pool.name.size());
+    pool.name.push_back(symbol);
+    pool.index.push_back(FlatAst::kNone);
+    NodeId converted = convert(index);
+    pool.index[s] = converted;
+  }
+};
+
+// Допустимые виды ребёнка в поле узла: классы узлов из ast.h занимают
+// в NodeKind непрерывные диапазоны (все выражения, все операторы, ...)
+struct KindSet {
+  NodeKind first;
+  NodeKind last;
+  const char* name;
+
+  bool contains(NodeKind kind) const { return kind >= first && kind <= last; }
+};
+
+constexpr KindSet kClasses{NodeKind::ClassDeclaration, NodeKind::ClassDeclaration, "класс"};
+constexpr KindSet kTypes{NodeKind::IntType, NodeKind::ArrayType, "тип"};
+constexpr KindSet kSimpleTypes{NodeKind::IntType, NodeKind::IdentifierType, "простой тип"};
+constexpr KindSet kVariables{NodeKind::VariableDeclaration, NodeKind::VariableDeclaration,
+                             "объявление переменной"};
+constexpr KindSet kDeclarations{NodeKind::VariableDeclaration, NodeKind::MethodDeclaration,
+                                "объявление"};
+constexpr KindSet kStatements{NodeKind::AssertStatement, NodeKind::ErrorStatement, "оператор"};
+constexpr KindSet kExpressions{NodeKind::BinaryOperation, NodeKind::FieldArrayInvocation,
+                               "выражение"};
+constexpr KindSet kInvocations{NodeKind::MethodInvocation, NodeKind::MethodInvocation,
+                               "вызов метода"};
+constexpr KindSet kLValues{NodeKind::IdentifierLValue, NodeKind::FieldArrayInvocation,
+                           "левая часть присваивания"};
+
+// Строит дерево объектов по пулам. Приведение static_cast<T*> в node
+// безопасно только для дерева, прошедшего validate
+class Materializer {
+ public:
+  Materializer(const FlatAst& ast, AstArena& arena) : ast(ast), arena(arena) {}
+
+  template <typename T>
+  T* node(NodeId id) {
+    return id == FlatAst::kNone ? nullptr : static_cast<T*>(build(id));
+  }
+
+  template <typename T>
+  AstList<T> list(Range range) {
+    T** items = arena.allocateArray<T*>(range.count);
+    for (uint32_t i = 0; i < range.count; i++) {
+      items[i] = node<T>(ast.lists[range.begin + i]);
+    }
+    return AstList<T>(items, range.count);
+  }
+
+ private:
+  const FlatAst& ast;
+  AstArena& arena;
+
+  template <typename T, typename... Args>
+  T* make(Args&&... args) {
+    return arena.make<T>(std::forward<Args>(args)...);
+  }
+
+  ASTNode* build(NodeId id) {
+    uint32_t s = ast.slot(id);
+    switch (ast.kind(id)) {
+      case NodeKind::MainClass:
+        return make<MainClass>(ast.mainClasses.name[s],
+                               list<Statement>(ast.mainClasses.statements[s]));
+      case NodeKind::ClassDeclaration:
+        return make<ClassDeclaration>(
+            ast.classDeclarations.name[s], ast.classDeclarations.baseName[s],
+            list<Declaration>(ast.classDeclarations.declarations[s]));
+      case NodeKind::IntType:
+        return make<IntType>();
+      case NodeKind::BooleanType:
+        return make<BooleanType>();
+      case NodeKind::VoidType:
+        return make<VoidType>();
+      case NodeKind::IdentifierType:
+        return make<IdentifierType>(ast.identifierTypes.name[s]);
+      case NodeKind::ArrayType:
+        return make<ArrayType>(node<SimpleType>(ast.arrayTypes.elementType[s]));
+      case NodeKind::VariableDeclaration:
+        return make<VariableDeclaration>(node<Type>(ast.variables.type[s]),
+                                         ast.variables.name[s]);
+      case NodeKind::MethodDeclaration: {
+        Type* returnType = node<Type>(ast.methods.returnType[s]);
+        auto parameters = list<VariableDeclaration>(ast.methods.parameters[s]);
+        auto statements = list<Statement>(ast.methods.statements[s]);
+        return make<MethodDeclaration>(returnType, ast.methods.name[s],
+                                       parameters, statements);
+      }
+      case NodeKind::AssertStatement:
+        return make<AssertStatement>(
+            node<Expression>(ast.unaryStatements.child[s]));
+      case NodeKind::LocalVarDeclStatement:
+        return make<LocalVarDeclStatement>(
+            node<VariableDeclaration>(ast.unaryStatements.child[s]));
+      case NodeKind::BlockStatement:
+        return make<BlockStatement>(list<Statement>(ast.blocks.statements[s]));
+      case NodeKind::IfStatement: {
+        Expression* condition = node<Expression>(ast.ifStatements.condition[s]);
+        Statement* thenStatement =
+            node<Statement>(ast.ifStatements.thenStatement[s]);
+        Statement* elseStatement =
+            node<Statement>(ast.ifStatements.elseStatement[s]);
+        return make<IfStatement>(condition, thenStatement, elseStatement);
+      }
+      case NodeKind::WhileStatement: {
+        Expression* condition =
+            node<Expression>(ast.whileStatements.condition[s]);
+        Statement* body = node<Statement>(ast.whileStatements.body[s]);
+        return make<WhileStatement>(condition, body);
+      }
+      case NodeKind::PrintStatement:
+        return make<PrintStatement>(
+            node<Expression>(ast.unaryStatements.child[s]));
+      case NodeKind::AssignStatement: {
+        LValue* lvalue = node<LValue>(ast.assignStatements.lvalue[s]);
+        Expression* expression =
+            node<Expression>(ast.assignStatements.expression[s]);
+        return make<AssignStatement>(lvalue, expression);
+      }
+      case NodeKind::ReturnStatement:
+        return make<ReturnStatement>(
+            node<Expression>(ast.unaryStatements.child[s]));
+      case NodeKind::MethodInvocationStatement:
+        return make<MethodInvocationStatement>(
+            node<MethodInvocation>(ast.unaryStatements.child[s]));
+      case NodeKind::ErrorStatement:
+        return make<ErrorStatement>();
+      case NodeKind::BinaryOperation: {
+        Expression* left = node<Expression>(ast.binaryOperations.left[s]);
+        Expression* right = node<Expression>(ast.binaryOperations.right[s]);
+        return make<BinaryOperation>(left, ast.binaryOperations.op[s], right);
+      }
+      case NodeKind::UnaryOperation:
+        return make<UnaryOperation>(
+            ast.unaryOperations.op[s],
+            node<Expression>(ast.unaryOperations.operand[s]));
+      case NodeKind::ArrayIndexing: {
+        Expression* array = node<Expression>(ast.arrayIndexings.array[s]);
+        Expression* index = node<Expression>(ast.arrayIndexings.index[s]);
+        return make<ArrayIndexing>(array, index);
+      }
+      case NodeKind::ArrayLength:
+        return make<ArrayLength>(node<Expression>(ast.arrayLengths.array[s]));
+      case NodeKind::MethodInvocation: {
+        Expression* object = node<Expression>(ast.methodInvocations.object[s]);
+        auto arguments = list<Expression>(ast.methodInvocations.arguments[s]);
+        return make<MethodInvocation>(object, ast.methodInvocations.name[s],
+                                      arguments);
+      }
+      case NodeKind::FieldAccess:
+        return make<FieldAccess>(node<Expression>(ast.fieldAccesses.object[s]),
+                                 ast.fieldAccesses.name[s]);
+      case NodeKind::NewArray: {
+        SimpleType* elementType =
+            node<SimpleType>(ast.newArrays.elementType[s]);
+        Expression* size = node<Expression>(ast.newArrays.size[s]);
+        return make<NewArray>(elementType, size);
+      }
+      case NodeKind::NewObject:
+        return make<NewObject>(ast.names.name[s]);
+      case NodeKind::IntegerLiteral:
+        return make<IntegerLiteral>(ast.integerLiterals.value[s]);
+      case NodeKind::BooleanLiteral:
+        return make<BooleanLiteral>(ast.booleanLiterals.value[s] != 0);
+      case NodeKind::ThisExpression:
+        return make<ThisExpression>();
+      case NodeKind::IdentifierExpression:
+        return make<IdentifierExpression>(ast.names.name[s]);
+      case NodeKind::ErrorExpression:
+        return make<ErrorExpression>();
+      case NodeKind::IdentifierLValue:
+        return make<IdentifierLValue>(ast.names.name[s]);
+      case NodeKind::ArrayAccess:
+        return make<ArrayAccess>(ast.indexedNames.name[s],
+                                 node<Expression>(ast.indexedNames.index[s]));
+      case NodeKind::SimpleFieldInvocation:
+        return make<SimpleFieldInvocation>(ast.names.name[s]);
+      case NodeKind::FieldArrayInvocation:
+        return make<FieldArrayInvocation>(
+            ast.indexedNames.name[s],
+            node<Expression>(ast.indexedNames.index[s]));
+      case NodeKind::Program:
+        break;
+    }
+    return nullptr;
+  }
+};
+
+}  // namespace
+
+FlatAst FlatAst::fromProgram(Program& program) {
+  FlatAst ast;
+  FlatBuilder builder(ast);
+  program.accept(builder);
+  return ast;
+}
+
+std::unique_ptr<Program> FlatAst::toProgram() const {
+  AstArena arena;
+  Materializer materializer(*this, arena);
+  MainClass* main = materializer.node<MainClass>(mainClass);
+  AstList<ClassDeclaration> declarations =
+      materializer.list<ClassDeclaration>(classes);
+  return std::make_unique<Program>(std::move(arena), main, declarations);
+}
+
+void FlatAst::materializeAndAccept(Visitor& visitor) const {
+  toProgram()->accept(visitor);
+}
+
+size_t FlatAst::poolSize(NodeKind kind) const {
+  switch (kind) {
+    case NodeKind::MainClass: return mainClasses.name.size();
+    case NodeKind::ClassDeclaration: return classDeclarations.name.size();
+    case NodeKind::IdentifierType: return identifierTypes.name.size();
+    case NodeKind::ArrayType: return arrayTypes.elementType.size();
+    case NodeKind::VariableDeclaration: return variables.name.size();
+    case NodeKind::MethodDeclaration: return methods.name.size();
+    case NodeKind::AssertStatement:
+    case NodeKind::LocalVarDeclStatement:
+    case NodeKind::PrintStatement:
+    case NodeKind::ReturnStatement:
+    case NodeKind::MethodInvocationStatement:
+      return unaryStatements.child.size();
+    case NodeKind::BlockStatement: return blocks.statements.size();
+    case NodeKind::IfStatement: return ifStatements.condition.size();
+    case NodeKind::WhileStatement: return whileStatements.condition.size();
+    case NodeKind::AssignStatement: return assignStatements.lvalue.size();
+    case NodeKind::BinaryOperation: return binaryOperations.op.size();
+    case NodeKind::UnaryOperation: return unaryOperations.op.size();
+    case NodeKind::ArrayIndexing: return arrayIndexings.array.size();
+    case NodeKind::ArrayLength: return arrayLengths.array.size();
+    case NodeKind::MethodInvocation: return methodInvocations.name.size();
+    case NodeKind::FieldAccess: return fieldAccesses.name.size();
+    case NodeKind::NewArray: return newArrays.size.size();
+    case NodeKind::IntegerLiteral: return integerLiterals.value.size();
+    case NodeKind::BooleanLiteral: return booleanLiterals.value.size();
+    case NodeKind::NewObject:
+    case NodeKind::IdentifierExpression:
+    case NodeKind::IdentifierLValue:
+    case NodeKind::SimpleFieldInvocation:
+      return names.name.size();
+    case NodeKind::ArrayAccess:
+    case NodeKind::FieldArrayInvocation:
+      return indexedNames.name.size();
+    case NodeKind::Program:
+      return 0;
+    default:
+      return 1;
+  }
+}
+
+void FlatAst::validate() const {
+  auto fail = [](const std::string& what) {
+    throw std::runtime_error("Повреждённое дерево: " + what);
+  };
+
+  size_t count = kinds.size();
+  if (slots.size() != count) fail("число слотов не совпадает с числом узлов");
+  forEachPool([&fail](const auto& first, const auto&... rest) {
+    if (((rest.size() != first.size()) || ...)) {
+      fail("поля пула разной длины");
+    }
+  });
+
+  auto checkRange = [&](Range range) {
+    if (static_cast<uint64_t>(range.begin) + range.count > lists.size()) {
+      fail("список за пределами массива списков");
+    }
+  };
+  for (NodeId child : lists) {
+    if (child >= count) fail("номер узла в списке вне дерева");
+  }
+  checkRange(classes);
+  if (mainClass >= count || kinds[mainClass] != NodeKind::MainClass) {
+    fail("нет главного класса");
+  }
+
+  // Диапазоны проверяются до forEachChild, который по ним читает
+  forEachPool([&checkRange](const auto&... columns) {
+    auto ranges = [&checkRange](const auto& column) {
+      using Element = typename std::decay_t<decltype(column)>::value_type;
+      if constexpr (std::is_same<Element, Range>::value) {
+        for (Range range : column) checkRange(range);
+      }
+    };
+    (ranges(columns), ...);
+  });
+
+  for (NodeId id = 0; id < count; id++) {
+    if (static_cast<size_t>(kinds[id]) >= kNodeKindCount ||
+        kinds[id] == NodeKind::Program) {
+      fail("неизвестный вид узла");
+    }
+    if (slots[id] >= poolSize(kinds[id])) fail("слот вне пула");
+  }
+  // Общий ребёнок превратил бы дерево в граф, который toProgram
+  // разворачивает заново для каждого родителя. Дети идут после
+  // родителей, поэтому глубина ребёнка известна к моменту, когда до
+  // него доходит цикл
+  std::vector<uint32_t> parents(count, 0);
+  std::vector<uint32_t> depth(count, 1);
+  auto adopt = [&](NodeId child) {
+    if (child == mainClass || ++parents[child] > 1) fail("у узла несколько родителей");
+  };
+  for (const NodeId* it = begin(classes); it != end(classes); ++it) adopt(*it);
+  for (NodeId id = 0; id < count; id++) {
+    if (depth[id] > kMaxDepth) {
+      fail("глубина больше " + std::to_string(kMaxDepth) + " уровней");
+    }
+    forEachChild(id, [&](NodeId child) {
+      if (child >= count || child <= id) fail("ребёнок не после родителя");
+      adopt(child);
+      depth[child] = depth[id] + 1;
+    });
+  }
+  for (NodeId id = 0; id < count; id++) {
+    if (id != mainClass && parents[id] == 0) fail("узел вне дерева");
+  }
+
+  // Виды детей: toProgram приводит ребёнка к классу поля без проверки
+  auto one = [&](NodeId child, const KindSet& expected, bool optional = false) {
+    if (child == kNone) {
+      if (!optional) fail(std::string("нет обязательного ребёнка: ") + expected.name);
+    } else if (!expected.contains(kinds[child])) {
+      fail(std::string("на месте, где ожидается ") + expected.name + ", узел другого вида");
+    }
+  };
+  auto all = [&](Range range, const KindSet& expected) {
+    for (const NodeId* it = begin(range); it != end(range); ++it) one(*it, expected);
+  };
+
+  all(classes, kClasses);
+  for (NodeId id = 0; id < count; id++) {
+    uint32_t s = slots[id];
+    switch (kinds[id]) {
+      case NodeKind::MainClass: all(mainClasses.statements[s], kStatements); break;
+      case NodeKind::ClassDeclaration: all(classDeclarations.declarations[s], kDeclarations); break;
+      case NodeKind::ArrayType: one(arrayTypes.elementType[s], kSimpleTypes); break;
+      case NodeKind::VariableDeclaration: one(variables.type[s], kTypes); break;
+      case NodeKind::MethodDeclaration:
+        one(methods.returnType[s], kTypes);
+        all(methods.parameters[s], kVariables);
+        all(methods.statements[s], kStatements);
+        break;
+      case NodeKind::AssertStatement:
+      case NodeKind::PrintStatement:
+      case NodeKind::ReturnStatement:
+        one(unaryStatements.child[s], kExpressions);
+        break;
+      case NodeKind::LocalVarDeclStatement: one(unaryStatements.child[s], kVariables); break;
+      case NodeKind::MethodInvocationStatement:
+        one(unaryStatements.child[s], kInvocations);
+        break;
+      case NodeKind::BlockStatement: all(blocks.statements[s], kStatements); break;
+      case NodeKind::IfStatement:
+        one(ifStatements.condition[s], kExpressions);
+        one(ifStatements.thenStatement[s], kStatements);
+        one(ifStatements.elseStatement[s], kStatements, true);
+        break;
+      case NodeKind::WhileStatement:
+        one(whileStatements.condition[s], kExpressions);
+        one(whileStatements.body[s], kStatements);
+        break;
+      case NodeKind::AssignStatement:
+        one(assignStatements.lvalue[s], kLValues);
+        one(assignStatements.expression[s], kExpressions);
+        break;
+      case NodeKind::BinaryOperation:
+        if (static_cast<size_t>(binaryOperations.op[s]) >= kBinaryOperatorCount) {
+          fail("неизвестный бинарный оператор");
+        }
+        one(binaryOperations.left[s], kExpressions);
+        one(binaryOperations.right[s], kExpressions);
+        break;
+      case NodeKind::UnaryOperation:
+        if (static_cast<size_t>(unaryOperations.op[s]) >= kUnaryOperatorCount) {
+          fail("неизвестный унарный оператор");
+        }
+        one(unaryOperations.operand[s], kExpressions);
+        break;
+      case NodeKind::ArrayIndexing:
+        one(arrayIndexings.array[s], kExpressions);
+        one(arrayIndexings.index[s], kExpressions, true);
+        break;
+      case NodeKind::ArrayLength: one(arrayLengths.array[s], kExpressions); break;
+      case NodeKind::MethodInvocation:
+        one(methodInvocations.object[s], kExpressions);
+        all(methodInvocations.arguments[s], kExpressions);
+        break;
+      case NodeKind::FieldAccess: one(fieldAccesses.object[s], kExpressions); break;
+      case NodeKind::NewArray:
+        one(newArrays.elementType[s], kSimpleTypes);
+        one(newArrays.size[s], kExpressions);
+        break;
+      case NodeKind::BooleanLiteral:
+        if (booleanLiterals.value[s] > 1) fail("логическое значение не 0 и не 1");
+        break;
+      case NodeKind::ArrayAccess:
+      case NodeKind::FieldArrayInvocation:
+        one(indexedNames.index[s], kExpressions);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+size_t FlatAst::bytesUsed() const {
+  size_t total = (kinds.size() * sizeof(NodeKind)) +
+                 (slots.size() * sizeof(uint32_t)) +
+                 (lists.size() * sizeof(NodeId));
+  forEachPool([&total](const auto&... columns) {
+    ((total += columns.size() * sizeof(columns[0])), ...);
+  });
+  return total;
+}
@@ -1,52 +1,182 @@
 #include "lexer.h"
 
-#include <cctype>
-
-Lexer::Lexer(const std::string& source) : source(source) { initKeywords(); }
-
-void Lexer::initKeywords() {
-  keywords["class"] = TokenType::CLASS;
-  keywords["public"] = TokenType::PUBLIC;
-  keywords["static"] = TokenType::STATIC;
-  keywords["void"] = TokenType::VOID_TYPE;
-  keywords["main"] = TokenType::MAIN;
-  keywords["extends"] = TokenType::EXTENDS;
-  keywords["return"] = TokenType::RETURN;
-  keywords["if"] = TokenType::IF;
-  keywords["else"] = TokenType::ELSE;
-  keywords["while"] = TokenType::WHILE;
-  keywords["new"] = TokenType::NEW;
-  keywords["this"] = TokenType::THIS;
-  keywords["assert"] = TokenType::ASSERT;
-  keywords["int"] = TokenType::INT_TYPE;
-  keywords["boolean"] = TokenType::BOOLEAN_TYPE;
-  keywords["true"] = TokenType::TRUE;
-  keywords["false"] = TokenType::FALSE;
-  keywords["System"] = TokenType::SYSTEM;
-  keywords["out"] = TokenType::OUT;
-  keywords["println"] = TokenType::PRINTLN;
-  keywords["length"] = TokenType::LENGTH;
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#include "parallel.h"
+
+namespace {
+
+// Распознавание ключевых слов без таблицы в памяти: сначала по длине,
+// затем по первому символу остаётся не больше двух кандидатов.
+// Возвращает IDENTIFIER, если слово не ключевое
+constexpr TokenType keywordType(std::string_view text) {
+  switch (text.size()) {
+    case 2:
+      if (text == "if") return TokenType::IF;
+      break;
+    case 3:
+      switch (text[0]) {
+        case 'n': if (text == "new") return TokenType::NEW; break;
+        case 'i': if (text == "int") return TokenType::INT_TYPE; break;
+        case 'o': if (text == "out") return TokenType::OUT; break;
+      }
+      break;
+    case 4:
+      switch (text[0]) {
+        case 'v': if (text == "void") return TokenType::VOID_TYPE; break;
+        case 'm': if (text == "main") return TokenType::MAIN; break;
+        case 'e': if (text == "else") return TokenType::ELSE; break;
+        case 't':
+          if (text == "this") return TokenType::THIS;
+          if (text == "true") return TokenType::TRUE;
+          break;
+      }
+      break;
+    case 5:
+      switch (text[0]) {
+        case 'c': if (text == "class") return TokenType::CLASS; break;
+        case 'w': if (text == "while") return TokenType::WHILE; break;
+        case 'f': if (text == "false") return TokenType::FALSE; break;
+      }
+      break;
+    case 6:
+      switch (text[0]) {
+        case 'p': if (text == "public") return TokenType::PUBLIC; break;
+        case 's': if (text == "static") return TokenType::STATIC; break;
+        case 'r': if (text == "return") return TokenType::RETURN; break;
+        case 'a': if (text == "assert") return TokenType::ASSERT; break;
+        case 'S': if (text == "System") return TokenType::SYSTEM; break;
+        case 'l': if (text == "length") return TokenType::LENGTH; break;
+      }
+      break;
+    case 7:
+      switch (text[0]) {
+        case 'e': if (text == "extends") return TokenType::EXTENDS; break;
+        case 'b': if (text == "boolean") return TokenType::BOOLEAN_TYPE; break;
+        case 'p': if (text == "println") return TokenType::PRINTLN; break;
+      }
+      break;
+  }
+  return TokenType::IDENTIFIER;
 }
 
-char Lexer::peek() const {
-  if (isAtEnd()) return '\0';
-  return source[position];
+static_assert(keywordType("class") == TokenType::CLASS);
+static_assert(keywordType("void") == TokenType::VOID_TYPE);
+static_assert(keywordType("true") == TokenType::TRUE);
+static_assert(keywordType("System") == TokenType::SYSTEM);
+static_assert(keywordType("system") == TokenType::IDENTIFIER);
+static_assert(keywordType("classes") == TokenType::IDENTIFIER);
+
+// Классы символов. Таблицы построены на все 256 значений байта,
+// поэтому не зависят от локали и знаковости char
+enum CharClass : uint8_t {
+  kDigit = 1 << 0,
+  kIdentifierStart = 1 << 1,
+};
+
+constexpr std::array<uint8_t, 256> makeCharClasses() {
+  std::array<uint8_t, 256> classes{};
+  for (int c = '0'; c <= '9'; c++) classes[c] |= kDigit;
+  for (int c = 'a'; c <= 'z'; c++) classes[c] |= kIdentifierStart;
+  for (int c = 'A'; c <= 'Z'; c++) classes[c] |= kIdentifierStart;
+  classes['_'] |= kIdentifierStart;
+  return classes;
 }
 
-char Lexer::advance() {
-  char current = peek();
-  position++;
+constexpr std::array<uint8_t, 256> kCharClasses = makeCharClasses();
+
+inline bool isDigit(char c) {
+  return kCharClasses[static_cast<unsigned char>(c)] & kDigit;
+}
+
+// Что делать с токеном, начинающимся с данного байта
+enum class Action : uint8_t { Unknown, Identifier, Number, Minus, Operator };
+
+struct ByteAction {
+  Action action = Action::Unknown;
+  TokenType type = TokenType::ERROR;      // Односимвольный токен
+  char second = '\0';                     // Второй символ оператора, если есть
+  TokenType pairType = TokenType::ERROR;  // Двухсимвольный токен
+  const char* error = nullptr;            // Одиночный символ недопустим
+};
 
-  if (current == '\n') {
-    currentLine++;
-    currentColumn = 1;
-  } else {
-    currentColumn++;
+constexpr ByteAction single(TokenType type) {
+  return {Action::Operator, type, '\0', TokenType::ERROR, nullptr};
+}
+
+constexpr ByteAction pair(TokenType type, char second, TokenType pairType) {
+  return {Action::Operator, type, second, pairType, nullptr};
+}
+
+constexpr ByteAction pairOnly(char second, TokenType pairType,
+                              const char* error) {
+  return {Action::Operator, TokenType::ERROR, second, pairType, error};
+}
+
+constexpr std::array<ByteAction, 256> makeDispatch() {
+  std::array<ByteAction, 256> table{};
+
+  for (int c = 0; c < 256; c++) {
+    if (kCharClasses[c] & kIdentifierStart) table[c].action = Action::Identifier;
+    if (kCharClasses[c] & kDigit) table[c].action = Action::Number;
   }
 
-  return current;
+  table['('] = single(TokenType::LPAREN);
+  table[')'] = single(TokenType::RPAREN);
+  table['{'] = single(TokenType::LBRACE);
+  table['}'] = single(TokenType::RBRACE);
+  table['['] = single(TokenType::LBRACKET);
+  table[']'] = single(TokenType::RBRACKET);
+  table['.'] = single(TokenType::DOT);
+  table[','] = single(TokenType::COMMA);
+  table[';'] = single(TokenType::SEMICOLON);
+
+  // Операторы
+  table['+'] = single(TokenType::PLUS);
+  table['-'] = {Action::Minus, TokenType::MINUS};
+  table['*'] = single(TokenType::MULTIPLY);
+  table['/'] = single(TokenType::DIVIDE);
+  table['%'] = single(TokenType::MODULO);
+
+  table['!'] = pair(TokenType::NOT, '=', TokenType::NOT_EQUAL);
+  table['='] = pair(TokenType::ASSIGN, '=', TokenType::EQUAL);
+  table['<'] = pair(TokenType::LESS, '=', TokenType::LESS_EQUAL);
+  table['>'] = pair(TokenType::GREATER, '=', TokenType::GREATER_EQUAL);
+  table['&'] = pairOnly('&', TokenType::AND, "Ожидалось '&' после '&'");
+  table['|'] = pairOnly('|', TokenType::OR, "Ожидалось '|' после '|'");
+
+  return table;
 }
 
+constexpr std::array<ByteAction, 256> kDispatch = makeDispatch();
+
+// Токены, которыми может заканчиваться операнд. Минус после них -
+// бинарный оператор, в остальных местах минус перед цифрой - знак литерала
+constexpr bool endsOperand(TokenType type) {
+  switch (type) {
+    case TokenType::IDENTIFIER:
+    case TokenType::INTEGER_LITERAL:
+    case TokenType::RPAREN:
+    case TokenType::RBRACKET:
+    case TokenType::THIS:
+    case TokenType::TRUE:
+    case TokenType::FALSE:
+    case TokenType::LENGTH:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+Lexer::Lexer(std::string_view source) : source(source) {}
+
+Lexer::Lexer(const SourceBuffer& buffer) : Lexer(buffer.text()) {}
+
 bool Lexer::isAtEnd() const { return position >= source.length(); }
 
 bool Lexer::match(char expected) {
@@ -55,43 +185,27 @@ bool Lexer::match(char expected) {
   }
 
   position++;
-  currentColumn++;
   return true;
 }
 
-Token Lexer::makeToken(TokenType type, const std::string& lexeme) {
-  return Token(type, lexeme, currentLine, currentColumn - lexeme.length());
-}
-
-Token Lexer::errorToken(const std::string& message) {
-  return Token(TokenType::ERROR, message, currentLine, currentColumn);
+TokenType Lexer::errorToken(const char* message) {
+  errorMessage = message;
+  return TokenType::ERROR;
 }
 
 void Lexer::skipWhitespace() {
   while (true) {
-    char c = peek();
-
-    switch (c) {
-      case ' ':
-      case '\t':
-      case '\r':
-      case '\n':
-        advance();
-        break;
-
-      case '/':
-        if (position + 1 < source.length()) {
-          if (source[position + 1] == '/') {
-            if (skipLineComment()) continue;
-          } else if (source[position + 1] == '*') {
-            if (skipBlockComment()) continue;
-          }
-        }
-        return;
-
-      default:
-        return;
+    // Пробелы и переводы строк пропускаются блоками
+    position = scan::skipWhitespace(source.data(), position, source.length());
+
+    if (position + 1 < source.length() && source[position] == '/') {
+      if (source[position + 1] == '/') {
+        if (skipLineComment()) continue;
+      } else if (source[position + 1] == '*') {
+        if (skipBlockComment()) continue;
+      }
     }
+    return;
   }
 }
 
@@ -101,18 +215,18 @@ bool Lexer::skipLineComment() {
     return false;
   }
 
-  // Пропускаем //
-  advance();
-  advance();
-
-  // Пропускаем все символы до конца строки
-  while (!isAtEnd() && peek() != '\n') {
-    advance();
-  }
+  // Пропускаем // и все символы до конца строки
+  position += 2;
+  skipLineCommentBody();
 
   return true;
 }
 
+void Lexer::skipLineCommentBody() {
+  position = scan::findLineEnd(source.data(), position, source.length());
+  openLineComment = isAtEnd();
+}
+
 bool Lexer::skipBlockComment() {
   if (!(position + 1 < source.length() && source[position] == '/' &&
         source[position + 1] == '*')) {
@@ -120,197 +234,447 @@ bool Lexer::skipBlockComment() {
   }
 
   // Пропускаем /*
-  advance();
-  advance();
+  position += 2;
+  skipBlockCommentBody(1);
 
-  int nestingLevel = 1;
+  return true;
+}
+
+void Lexer::skipBlockCommentBody(int nestingLevel) {
+  while (nestingLevel > 0) {
+    // Внутри комментария интересны только '*' и '/', остальное
+    // пропускается блоками
+    position = scan::findCommentDelimiter(source.data(), position,
+                                          source.length());
+    if (isAtEnd()) break;
 
-  while (!isAtEnd() && nestingLevel > 0) {
     if (position + 1 < source.length()) {
       if (source[position] == '/' && source[position + 1] == '*') {
-        advance();  // /
-        advance();  // *
+        position += 2;
         nestingLevel++;
         continue;
       } else if (source[position] == '*' && source[position + 1] == '/') {
-        advance();  // *
-        advance();  // /
+        position += 2;
         nestingLevel--;
         continue;
       }
     }
 
-    advance();
+    position++;
   }
 
-  return true;
+  openBlockComments = nestingLevel;
 }
 
-Token Lexer::identifier() {
-  size_t start = position;
+TokenType Lexer::identifier() {
+  // Первый символ уже проверен по таблице; последующие могут быть
+  // буквами, цифрами или подчеркиваниями
+  position = scan::skipIdentifierChars(source.data(), position + 1,
+                                       source.length());
 
-  // Первый символ должен быть буквой
-  if (std::isalpha(peek()) || peek() == '_') {
-    advance();
+  std::string_view text(source.data() + start, position - start);
 
-    // Последующие символы могут быть буквами, цифрами или подчеркиваниями
-    while (std::isalnum(peek()) || peek() == '_') {
-      advance();
-    }
-
-    std::string text = source.substr(start, position - start);
+  // Проверка, является ли идентификатор ключевым словом
+  return keywordType(text);
+}
 
-    // Проверка, является ли идентификатор ключевым словом
-    auto it = keywords.find(text);
-    if (it != keywords.end()) {
-      return makeToken(it->second, text);
-    }
+// Цифры разбираются сразу в значение. Диапазон - как у int в Java:
+// 2147483648 допустимо только со знаком минус
+TokenType Lexer::number() {
+  constexpr uint64_t kLimit = uint64_t{1} << 31;
+  bool negative = source[start] == '-';
+
+  // Модуль насыщается на kLimit + 1, чтобы длинные числа не переполняли
+  // uint64_t, а результат всё равно оказался вне диапазона
+  uint64_t magnitude = 0;
+  while (position < source.length() && isDigit(source[position])) {
+    magnitude = std::min<uint64_t>(
+        magnitude * 10 + static_cast<uint64_t>(source[position] - '0'),
+        kLimit + 1);
+    position++;
+  }
 
-    return makeToken(TokenType::IDENTIFIER, text);
+  if (magnitude > (negative ? kLimit : kLimit - 1)) {
+    return errorToken("Целое число вне диапазона int");
   }
+  literalValue = static_cast<int32_t>(negative ? -static_cast<int64_t>(magnitude)
+                                               : static_cast<int64_t>(magnitude));
+  return TokenType::INTEGER_LITERAL;
+}
+
+// Распознаёт следующий токен: его тип, границы [start, position) и, для
+// ERROR, сообщение. Строки и столбцы здесь не отслеживаются
+TokenType Lexer::scanToken() {
+  skipWhitespace();
+  start = position;
 
-  return errorToken("Ожидался идентификатор");
+  TokenType type = isAtEnd() ? TokenType::EOF_TOKEN : dispatchToken();
+  afterOperand = endsOperand(type);
+  return type;
 }
 
-Token Lexer::number() {
-  size_t start = position;
+// Выбор ветки по первому байту токена через таблицу kDispatch
+TokenType Lexer::dispatchToken() {
+  const ByteAction& entry =
+      kDispatch[static_cast<unsigned char>(source[position])];
 
-  while (std::isdigit(peek())) {
-    advance();
+  switch (entry.action) {
+    case Action::Identifier:
+      return identifier();
+
+    case Action::Number:
+      return number();
+
+    case Action::Minus:
+      position++;
+      // Отрицательный литерал: минус перед цифрой там, где не может
+      // стоять бинарный минус. Лексема - один срез с минусом и цифрами
+      if (!afterOperand && !isAtEnd() && isDigit(source[position])) {
+        return number();
+      }
+      return TokenType::MINUS;
+
+    case Action::Operator:
+      position++;
+      if (entry.second != '\0' && match(entry.second)) return entry.pairType;
+      if (entry.error) return errorToken(entry.error);
+      return entry.type;
+
+    case Action::Unknown:
+      break;
   }
 
-  std::string text = source.substr(start, position - start);
-  return makeToken(TokenType::INTEGER_LITERAL, text);
+  position++;
+  return errorToken("Неизвестный символ");
 }
 
 Token Lexer::getNextToken() {
-  skipWhitespace();
+  TokenType type = scanToken();
+
+  // Номер строки нужен только здесь: переводы строк досчитываются
+  // от конца предыдущего токена до начала текущего
+  scan::advanceLines(source.data(), start, lines);
+
+  // Лексема токена - срез исходного текста [start, position), без копирования
+  std::string_view lexeme = type == TokenType::ERROR
+                                ? std::string_view(errorMessage)
+                                : source.substr(start, position - start);
+  Token token(type, lexeme, static_cast<int>(lines.line),
+              static_cast<int>(start - lines.lineStart + 1),
+              static_cast<uint32_t>(start));
+  if (type == TokenType::IDENTIFIER) {
+    token.symbol = symbols.intern(lexeme);
+  } else if (type == TokenType::INTEGER_LITERAL) {
+    token.value = literalValue;
+  }
+
+  // Внутри лексем переводов строк не бывает
+  lines.position = position;
+  return token;
+}
+
+void Lexer::pushToken(TokenStream& stream, TokenType type) {
+  uint32_t offset = static_cast<uint32_t>(start);
+  uint32_t length = static_cast<uint32_t>(position - start);
 
-  if (isAtEnd()) {
-    return makeToken(TokenType::EOF_TOKEN, "");
+  switch (type) {
+    case TokenType::ERROR:
+      stream.pushError(offset, length, errorMessage);
+      break;
+    case TokenType::IDENTIFIER:
+      stream.push(type, offset, length,
+                  symbols.intern(source.substr(start, length)).id());
+      break;
+    case TokenType::INTEGER_LITERAL:
+      stream.push(type, offset, length, static_cast<uint32_t>(literalValue));
+      break;
+    default:
+      stream.push(type, offset, length);
+      break;
   }
+}
 
-  char c = peek();
+TokenStream Lexer::tokenizeCompact() {
+  TokenStream stream(source);
 
-  // Обработка отрицательных чисел
-  if (c == '-' && position + 1 < source.length() &&
-      std::isdigit(source[position + 1])) {
-    // Проверяем, что это может быть отрицательное число (не бинарный минус)
-    bool canBeNegative = false;
+  while (true) {
+    TokenType type = scanToken();
+    pushToken(stream, type);
+    if (type == TokenType::EOF_TOKEN) break;
+  }
 
-    if (position == 0) {
-      // В начале строки
-      canBeNegative = true;
-    } else {
-      // Проверяем предыдущий символ
-      char prev = source[position - 1];
-
-      // Если перед минусом оператор или открывающая скобка, то это может быть
-      // унарный минус
-      canBeNegative =
-          (prev == '(' || prev == '=' || prev == '<' || prev == '>' ||
-           prev == '+' || prev == '-' || prev == '*' || prev == '/' ||
-           prev == '%' || prev == '!' || prev == '&' || prev == '|' ||
-           prev == ',' || prev == ' ' || prev == '\t' || prev == '\n' ||
-           prev == '\r');
-    }
+  return stream;
+}
 
-    if (canBeNegative) {
-      advance();  // Пропускаем минус
-      size_t start = position;
+std::vector<Token> Lexer::tokenize() {
+  std::vector<Token> tokens;
 
-      while (std::isdigit(peek())) {
-        advance();
-      }
+  while (true) {
+    Token token = getNextToken();
+    tokens.push_back(token);
 
-      std::string text = "-" + source.substr(start, position - start);
-      return makeToken(TokenType::INTEGER_LITERAL, text);
+    if (token.type == TokenType::EOF_TOKEN) {
+      break;
     }
   }
 
-  // Идентификаторы и ключевые слова
-  if (std::isalpha(c) || c == '_') {
-    return identifier();
+  return tokens;
+}
+// Параллельный разбор.
+// Текст делится на фрагменты, границы ставятся сразу после пробельного
+// символа. Токены и пары "/*", "*/", "//" не содержат пробелов, поэтому
+// граница никогда не приходится на середину токена или разделителя
+// комментария, и лексер целого текста проходит через неё в одном из
+// состояний State: вне комментария, внутри строчного или внутри блочного
+// комментария глубины N - с тем или иным значением afterOperand.
+//
+// Каждый фрагмент разбирается параллельно в предположении, что он
+// начинается вне комментария после оператора (State{}). Затем фрагменты
+// сшиваются слева направо: истинное начальное состояние фрагмента - это
+// конечное состояние предыдущего. Если оно отличается от предположенного,
+// фрагмент разбирается заново, но только до первого токена, совпавшего
+// с предположением по позиции и afterOperand: начиная с него разбор
+// детерминирован и совпадает с уже полученным.
+
+struct Lexer::Chunk {
+  size_t begin;
+  size_t end;
+  // Токены фрагмента - repaired, а за ними tokens начиная с discarded.
+  // Строки и столбцы отсчитаны от begin
+  std::vector<Token> tokens;
+  std::vector<Token> repaired;  // Повторно разобранное начало фрагмента
+  size_t discarded = 0;         // Отброшенные токены предположения
+  State exit;                 // Состояние лексера в конце фрагмента
+  scan::LineCursor lines;     // Переводы строк внутри фрагмента
+};
+
+namespace {
+
+// Граница не раньше target: позиция после ближайшего пробельного символа.
+// Возвращает end, если такого символа нет
+size_t chunkBoundary(std::string_view source, size_t target, size_t end) {
+  for (size_t pos = target; pos < end; pos++) {
+    char c = source[pos];
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') return pos + 1;
   }
+  return end;
+}
 
-  // Числа
-  if (std::isdigit(c)) {
-    return number();
-  }
+}  // namespace
 
-  advance();
-
-  switch (c) {
-    case '(':
-      return makeToken(TokenType::LPAREN, "(");
-    case ')':
-      return makeToken(TokenType::RPAREN, ")");
-    case '{':
-      return makeToken(TokenType::LBRACE, "{");
-    case '}':
-      return makeToken(TokenType::RBRACE, "}");
-    case '[':
-      return makeToken(TokenType::LBRACKET, "[");
-    case ']':
-      return makeToken(TokenType::RBRACKET, "]");
-    case '.':
-      return makeToken(TokenType::DOT, ".");
-    case ',':
-      return makeToken(TokenType::COMMA, ",");
-    case ';':
-      return makeToken(TokenType::SEMICOLON, ";");
-
-    // Операторы
-    case '+':
-      return makeToken(TokenType::PLUS, "+");
-    case '-':
-      return makeToken(TokenType::MINUS, "-");
-    case '*':
-      return makeToken(TokenType::MULTIPLY, "*");
-    case '/':
-      return makeToken(TokenType::DIVIDE, "/");
-    case '%':
-      return makeToken(TokenType::MODULO, "%");
-
-    case '!':
-      if (match('=')) return makeToken(TokenType::NOT_EQUAL, "!=");
-      return makeToken(TokenType::NOT, "!");
-
-    case '=':
-      if (match('=')) return makeToken(TokenType::EQUAL, "==");
-      return makeToken(TokenType::ASSIGN, "=");
-
-    case '<':
-      if (match('=')) return makeToken(TokenType::LESS_EQUAL, "<=");
-      return makeToken(TokenType::LESS, "<");
-
-    case '>':
-      if (match('=')) return makeToken(TokenType::GREATER_EQUAL, ">=");
-      return makeToken(TokenType::GREATER, ">");
-
-    case '&':
-      if (match('&')) return makeToken(TokenType::AND, "&&");
-      return errorToken("Ожидалось '&' после '&'");
-
-    case '|':
-      if (match('|')) return makeToken(TokenType::OR, "||");
-      return errorToken("Ожидалось '|' после '|'");
-  }
+Lexer::Lexer(std::string_view source, size_t begin, const State& entry)
+    : source(source), start(begin), position(begin),
+      afterOperand(entry.afterOperand) {
+  lines.lineStart = begin;
+  lines.position = begin;
 
-  return errorToken("Неизвестный символ");
+  if (entry.lineComment) {
+    skipLineCommentBody();
+  } else if (entry.blockDepth > 0) {
+    skipBlockCommentBody(entry.blockDepth);
+  }
 }
 
-std::vector<Token> Lexer::tokenize() {
+std::vector<Token> Lexer::lexChunk(bool keepEof, State& exit) {
   std::vector<Token> tokens;
-
   while (true) {
+    bool before = afterOperand;
     Token token = getNextToken();
+    if (token.type == TokenType::EOF_TOKEN) {
+      if (keepEof) tokens.push_back(token);
+      exit = State{openBlockComments, openLineComment, before};
+      break;
+    }
     tokens.push_back(token);
+  }
+
+  scan::advanceLines(source.data(), source.size(), lines);
+  return tokens;
+}
+
+void Lexer::repairChunk(Chunk& chunk, const State& entry, bool last) const {
+  Lexer lexer(source.substr(0, chunk.end), chunk.begin, entry);
+  std::vector<Token>& repaired = chunk.repaired;
 
+  // Значение afterOperand перед токеном index предположительного разбора
+  auto speculativeBefore = [&chunk](size_t index) {
+    return index > 0 && endsOperand(chunk.tokens[index - 1].type);
+  };
+
+  size_t next = 0;  // Первый токен предположения, не левее текущего
+  while (true) {
+    bool before = lexer.afterOperand;
+    Token token = lexer.getNextToken();
     if (token.type == TokenType::EOF_TOKEN) {
-      break;
+      // Совпадения не нашлось: разбор заново заменяет весь фрагмент
+      if (last) repaired.push_back(token);
+      chunk.discarded = chunk.tokens.size();
+      chunk.exit = State{lexer.openBlockComments, lexer.openLineComment, before};
+      return;
+    }
+
+    while (next < chunk.tokens.size() &&
+           chunk.tokens[next].offset < token.offset) {
+      next++;
     }
+    if (next < chunk.tokens.size() &&
+        chunk.tokens[next].offset == token.offset &&
+        speculativeBefore(next) == before) {
+      // Дальше оба разбора совпадают, конечное состояние тоже
+      chunk.discarded = next;
+      return;
+    }
+    repaired.push_back(token);
+  }
+}
+
+std::vector<Token> Lexer::tokenizeParallel(unsigned threads,
+                                           size_t minChunkSize) {
+  threads = resolveThreads(threads);
+  size_t chunkSize = std::max<size_t>(
+      std::max<size_t>(minChunkSize, 1), (source.size() + threads - 1) / threads);
+
+  std::vector<Chunk> chunks;
+  for (size_t begin = 0; begin < source.size() || chunks.empty();) {
+    size_t end = begin + chunkSize < source.size()
+                     ? chunkBoundary(source, begin + chunkSize, source.size())
+                     : source.size();
+    chunks.push_back(Chunk{begin, end, {}, {}, 0, State{}, {}});
+    begin = end;
+  }
+
+  if (chunks.size() == 1) {
+    Lexer lexer(source);
+    return lexer.tokenize();
   }
 
+  // Предположительный разбор всех фрагментов
+  runParallel(chunks.size(), [this, &chunks](size_t i) {
+    Chunk& chunk = chunks[i];
+    Lexer lexer(source.substr(0, chunk.end), chunk.begin, State{});
+    chunk.tokens = lexer.lexChunk(i + 1 == chunks.size(), chunk.exit);
+    chunk.lines = lexer.lines;
+  });
+
+  // Сшивка: истинное состояние на входе известно только слева направо
+  State entry;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (!(entry == State{})) {
+      repairChunk(chunks[i], entry, i + 1 == chunks.size());
+    }
+    entry = chunks[i].exit;
+  }
+
+  // Перевод строк и столбцов из отсчёта от начала фрагмента в абсолютные
+  std::vector<scan::LineCursor> bases(chunks.size());
+  size_t total = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    total += chunks[i].repaired.size() + chunks[i].tokens.size() -
+             chunks[i].discarded;
+    if (i == 0) continue;
+
+    const scan::LineCursor& previous = chunks[i - 1].lines;
+    bases[i].line = bases[i - 1].line + previous.line - 1;
+    bases[i].lineStart =
+        previous.line > 1 ? previous.lineStart : bases[i - 1].lineStart;
+  }
+
+  runParallel(chunks.size(), [&chunks, &bases](size_t i) {
+    Chunk& chunk = chunks[i];
+    size_t shift = chunk.begin - bases[i].lineStart;
+    auto place = [&](Token& token) {
+      if (token.line == 1) token.column += static_cast<int>(shift);
+      token.line += static_cast<int>(bases[i].line) - 1;
+    };
+    std::for_each(chunk.repaired.begin(), chunk.repaired.end(), place);
+    std::for_each(chunk.tokens.begin() + chunk.discarded, chunk.tokens.end(),
+                  place);
+  });
+
+  std::vector<Token> tokens;
+  tokens.reserve(total);
+  for (const Chunk& chunk : chunks) {
+    tokens.insert(tokens.end(), chunk.repaired.begin(), chunk.repaired.end());
+    tokens.insert(tokens.end(), chunk.tokens.begin() + chunk.discarded,
+                  chunk.tokens.end());
+  }
   return tokens;
-}
\ No newline at end of file
+}
+
+// Повторный разбор после правки.
+// Токены, закончившиеся до правки, не меняются: решение о конце токена
+// зависит от символа сразу за ним, который тоже лежит до правки. Разбор
+// начинается с конца последнего такого токена - в этой точке лексер вне
+// комментария, а afterOperand определяется этим токеном. Он продолжается,
+// пока очередной токен после правки не совпадёт со старым по (сдвинутому)
+// смещению и afterOperand: дальше текст и состояние те же, что и раньше.
+// Так блочный комментарий, задетый правкой, разбирается заново целиком
+Lexer::Relexed Lexer::relex(TokenStream& tokens, const TextEdit& edit) {
+  std::string_view old = tokens.text();
+  size_t editEnd = edit.offset + edit.insertedText.size();
+  if (tokens.size() == 0 ||
+      tokens.type(tokens.size() - 1) != TokenType::EOF_TOKEN ||
+      edit.offset + edit.removedLength > old.size() ||
+      old.size() - edit.removedLength + edit.insertedText.size() !=
+          source.size() ||
+      source.substr(edit.offset, edit.insertedText.size()) !=
+          edit.insertedText) {
+    throw std::runtime_error("Правка не соответствует потоку токенов");
+  }
+  int64_t delta = static_cast<int64_t>(edit.insertedText.size()) -
+                  static_cast<int64_t>(edit.removedLength);
+
+  // Первый токен, который правка могла задеть: его конец не левее её начала
+  auto tokenEnd = [&tokens](size_t index) {
+    return size_t{tokens.offset(index)} + tokens.length(index);
+  };
+  size_t first = 0;
+  size_t high = tokens.size();
+  while (first < high) {
+    size_t middle = (first + high) / 2;
+    if (tokenEnd(middle) < edit.offset) {
+      first = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  auto oldBefore = [&tokens](size_t index) {
+    return index > 0 && endsOperand(tokens.type(index - 1));
+  };
+  State entry;
+  entry.afterOperand = oldBefore(first);
+  Lexer lexer(source, first > 0 ? tokenEnd(first - 1) : 0, entry);
+
+  TokenStream replacement(source);
+  size_t next = first;  // Первый старый токен, не левее текущего нового
+  size_t last = tokens.size();
+  while (true) {
+    bool before = lexer.afterOperand;
+    TokenType type = lexer.scanToken();
+    size_t start = lexer.start;
+
+    if (start >= editEnd && type != TokenType::EOF_TOKEN) {
+      // Старый токен, стоявший после правки на том же месте
+      while (next < tokens.size() &&
+             (tokens.offset(next) < edit.offset + edit.removedLength ||
+              static_cast<int64_t>(tokens.offset(next)) + delta <
+                  static_cast<int64_t>(start))) {
+        next++;
+      }
+      if (next < tokens.size() &&
+          static_cast<int64_t>(tokens.offset(next)) + delta ==
+              static_cast<int64_t>(start) &&
+          oldBefore(next) == before) {
+        last = next;
+        break;
+      }
+    }
+
+    lexer.pushToken(replacement, type);
+    if (type == TokenType::EOF_TOKEN) break;
+  }
+
+  tokens.splice(first, last, replacement, edit);
+  return {first, last - first, replacement.size()};
+}
@@ -1,62 +1,215 @@
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include "lexer.h"
-#include "parser.h"
-#include "ast_printer.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include "batch.h"
+#include "compile_cache.h"
+#include "driver.h"
+#include "server.h"
+#include "source_buffer.h"
 
-// Функция для чтения файла
-std::string readFile(const std::string& path) {
-    std::ifstream file(path);
-    std::stringstream buffer;
+int main(int argc, char* argv[]) {
+    // Разбор аргументов: ключи идут перед именем файла
+    // --jobs=N - параллельные лексер и парсер в N потоках (0 - по числу ядер);
+    //            в пакетном режиме - число файлов, разбираемых одновременно
+    // --emit-ast=bin - записать дерево в двоичный файл (по умолчанию
+    //                  <файл>.ast, путь задаётся ключом --output=PATH)
+    // --dump-ast=tree|json|sexpr - формат вывода дерева (по умолчанию tree)
+    // --cache-dir=DIR - кэш результатов разбора (или MINIJAVA_CACHE_DIR)
+    // --cache-size=MB - предел размера кэша (или MINIJAVA_CACHE_SIZE)
+    // --cache-stats - вывести счётчики кэша; без файла - только их
+    // --server=SOCKET - сервер компиляции на сокете; --jobs=N - потоков,
+    //                   --idle-timeout=SEC - остановка после простоя (0 - нет)
+    // --connect=SOCKET - клиент: файл компилирует сервер (или MINIJAVA_SERVER);
+    //                    --server-stats и --server-stop - запросы без файла
+    bool parallel = false;
+    unsigned jobs = 0;
+    bool emitBinary = false;
+    std::string output;
+    AstFormat format = AstFormat::Tree;
+    std::string serverSocket;
+    double idleTimeout = 300;
+    std::string connectSocket;
+    CompileServer::RequestType requestType = CompileServer::RequestType::Compile;
+    std::string cacheDir;
+    uint64_t cacheSize = CompileCache::kDefaultMaxBytes;
+    bool cacheStats = false;
+    if (const char* value = std::getenv("MINIJAVA_CACHE_DIR")) cacheDir = value;
+    if (const char* value = std::getenv("MINIJAVA_CACHE_SIZE")) {
+        cacheSize = std::strtoull(value, nullptr, 10) << 20;
+    }
+    if (const char* value = std::getenv("MINIJAVA_SERVER")) connectSocket = value;
+    int argument = 1;
+    for (; argument < argc && std::strncmp(argv[argument], "--", 2) == 0; argument++) {
+        const char* option = argv[argument];
+        if (std::strncmp(option, "--jobs=", 7) == 0) {
+            parallel = true;
+            jobs = static_cast<unsigned>(std::strtoul(option + 7, nullptr, 10));
+        } else if (std::strcmp(option, "--emit-ast=bin") == 0) {
+            emitBinary = true;
+        } else if (std::strncmp(option, "--dump-ast=", 11) == 0) {
+            if (!parseAstFormat(option + 11, format)) {
+                std::cerr << "Неизвестный формат дерева: " << option + 11 << std::endl;
+                return 1;
+            }
+        } else if (std::strncmp(option, "--output=", 9) == 0) {
+            output = option + 9;
+        } else if (std::strncmp(option, "--cache-dir=", 12) == 0) {
+            cacheDir = option + 12;
+        } else if (std::strncmp(option, "--cache-size=", 13) == 0) {
+            cacheSize = std::strtoull(option + 13, nullptr, 10) << 20;
+        } else if (std::strcmp(option, "--cache-stats") == 0) {
+            cacheStats = true;
+        } else if (std::strncmp(option, "--server=", 9) == 0) {
+            serverSocket = option + 9;
+        } else if (std::strncmp(option, "--idle-timeout=", 15) == 0) {
+            idleTimeout = std::strtod(option + 15, nullptr);
+        } else if (std::strncmp(option, "--connect=", 10) == 0) {
+            connectSocket = option + 10;
+        } else if (std::strcmp(option, "--server-stats") == 0) {
+            requestType = CompileServer::RequestType::Stats;
+        } else if (std::strcmp(option, "--server-stop") == 0) {
+            requestType = CompileServer::RequestType::Shutdown;
+        } else {
+            std::cerr << "Неизвестный ключ: " << option << std::endl;
+            return 1;
+        }
+    }
     
-    if (file.is_open()) {
-        buffer << file.rdbuf();
-        file.close();
-    } else {
-        std::cerr << "Не удалось открыть файл: " << path << std::endl;
+    // Кэш не обязателен: если каталог недоступен, компиляция идёт без него
+    std::unique_ptr<CompileCache> cache;
+    auto disableCache = [&cache](const std::exception& e) {
+        std::cerr << "Предупреждение: " << e.what() << ", кэш отключён" << std::endl;
+        cache.reset();
+    };
+    if (!cacheDir.empty()) {
+        try {
+            cache = std::make_unique<CompileCache>(cacheDir, cacheSize);
+        } catch (const std::exception& e) {
+            disableCache(e);
+        }
     }
+    auto printCacheStats = [&cache, cacheStats]() {
+        if (!cacheStats || !cache) return;
+        CompileCache::Stats stats = cache->stats();
+        std::cerr << "Кэш " << cache->directory() << ": попаданий " << stats.hits
+                  << ", промахов " << stats.misses << ", записано " << stats.stores
+                  << ", вытеснено " << stats.evictions << ", занято байт " << stats.bytes << std::endl;
+    };
     
-    return buffer.str();
-}
-
-int main(int argc, char* argv[]) {
-    std::string source;
+    // Сервер: процесс остаётся жить и компилирует файлы по запросам
+    // клиентов; при остановке печатает гистограмму задержек
+    if (!serverSocket.empty()) {
+        CompileServer::Options options;
+        options.socketPath = serverSocket;
+        options.threads = jobs;
+        options.idleSeconds = idleTimeout;
+        options.cache = cache.get();
+        try {
+            CompileServer server(options);
+            server.listen();
+            std::cerr << "Сервер компиляции слушает " << serverSocket << std::endl;
+            server.run();
+            std::cerr << server.latencyReport();
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
     
-    // Проверка аргументов командной строки
-    if (argc < 2) {
-        std::cerr << "Использование: " << argv[0] << " <файл с исходным кодом>" << std::endl;
-        return 1;
+    // Клиент: файл читает сервер, поэтому путь передаётся абсолютным;
+    // стандартный ввод пересылается текстом
+    if (!connectSocket.empty() &&
+        (argument < argc || requestType != CompileServer::RequestType::Compile)) {
+        CompileServer::Request request;
+        request.type = requestType;
+        request.options.parallel = parallel;
+        request.options.jobs = jobs;
+        request.options.emitBinary = emitBinary;
+        request.options.output = output;
+        request.options.format = format;
+        try {
+            if (requestType == CompileServer::RequestType::Compile) {
+                if (argc - argument > 1) {
+                    std::cerr << "В режиме клиента компилируется один файл" << std::endl;
+                    return 1;
+                }
+                request.path = argv[argument];
+                if (request.path == "-") {
+                    request.inlineSource = true;
+                    request.source = std::string(SourceBuffer::fromDescriptor(STDIN_FILENO).text());
+                }
+                char cwd[4096];
+                if (getcwd(cwd, sizeof(cwd)) != nullptr) {
+                    if (!request.inlineSource && request.path[0] != '/') {
+                        request.path = std::string(cwd) + "/" + request.path;
+                    }
+                    if (!output.empty() && output[0] != '/') {
+                        request.options.output = std::string(cwd) + "/" + output;
+                    }
+                }
+            }
+            return CompileServer::send(connectSocket, request, std::cout, std::cerr);
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            return 1;
+        }
     }
     
-    // Чтение исходного файла
-    source = readFile(argv[1]);
-    if (source.empty()) {
-        std::cerr << "Файл пуст или не может быть прочитан." << std::endl;
+    // Проверка аргументов командной строки
+    if (argument >= argc) {
+        if (cacheStats && cache) {
+            printCacheStats();
+            return 0;
+        }
+        std::cerr << "Использование: " << argv[0]
+                  << " [--jobs=N] [--dump-ast=tree|json|sexpr] [--emit-ast=bin [--output=PATH]]"
+                  << " [--cache-dir=DIR [--cache-size=MB] [--cache-stats]]"
+                  << " [--connect=SOCKET]"
+                  << " <файл с исходным кодом | файл .ast | ->" << std::endl;
+        std::cerr << "Пакетный режим: " << argv[0]
+                  << " [ключи] <файлы, каталоги с файлами .java, @список>" << std::endl;
+        std::cerr << "Сервер: " << argv[0]
+                  << " --server=SOCKET [--jobs=N] [--idle-timeout=SEC] [--cache-dir=DIR]" << std::endl;
         return 1;
     }
     
-    try {
-        // Лексический анализ
-        Lexer lexer(source);
-        std::vector<Token> tokens = lexer.tokenize();
-        
-        std::cout << "Лексический анализ завершен. Найдено токенов: " << tokens.size() << std::endl;
-        
-        // Синтаксический анализ
-        Parser parser(tokens);
-        auto program = parser.parseProgram();
-        
-        std::cout << "Синтаксический анализ завершен. AST дерево:" << std::endl;
-        
-        // Вывод AST
-        ASTPrinter printer;
-        program->accept(printer);
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Ошибка: " << e.what() << std::endl;
-        return 1;
+    // Несколько файлов, каталог или список: пакетная компиляция без
+    // вывода AST, в конце - итоги
+    std::vector<std::string> inputs(argv + argument, argv + argc);
+    if (BatchCompiler::needsBatch(inputs)) {
+        if (!output.empty()) {
+            std::cerr << "Ключ --output нельзя использовать в пакетном режиме" << std::endl;
+            return 1;
+        }
+        try {
+            std::vector<std::string> files = BatchCompiler::expandInputs(inputs);
+            BatchCompiler::Options options;
+            options.jobs = jobs;
+            options.emitBinary = emitBinary;
+            options.cache = cache.get();
+            BatchCompiler::Summary summary = BatchCompiler(options).run(files, std::cerr);
+            BatchCompiler::printSummary(summary, std::cout);
+            printCacheStats();
+            return summary.failed == 0 ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            return 1;
+        }
     }
     
-    return 0;
-}
\ No newline at end of file
+    // Один файл: вывод AST
+    CompileDriver::Options options;
+    options.parallel = parallel;
+    options.jobs = jobs;
+    options.emitBinary = emitBinary;
+    options.output = output;
+    options.format = format;
+    int status = CompileDriver(options, cache.get()).compile(argv[argument], std::cout, std::cerr);
+    printCacheStats();
+    return status;
+}
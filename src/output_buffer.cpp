@@ -0,0 +1,59 @@
+#include "output_buffer.h"
+
+#include <algorithm>
+
+namespace {
+
+// Блок пробелов для отступов: глубже него отступ пишется в несколько
+// приёмов
+constexpr size_t kSpaceBlock = 256;
+
+struct SpaceBlock {
+  char text[kSpaceBlock];
+  SpaceBlock() { std::memset(text, ' ', sizeof(text)); }
+};
+
+const SpaceBlock spaceBlock;
+
+}  // namespace
+
+OutputBuffer& OutputBuffer::operator<<(int32_t value) {
+  // Цифры пишутся с конца во временный массив; модуль берётся
+  // в беззнаковом типе, чтобы INT32_MIN не переполнялся
+  char digits[12];
+  char* end = digits + sizeof(digits);
+  char* begin = end;
+  uint32_t magnitude = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+  do {
+    *--begin = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) *--begin = '-';
+  return *this << std::string_view(begin, static_cast<size_t>(end - begin));
+}
+
+void OutputBuffer::spaces(size_t count) {
+  while (count > 0) {
+    size_t chunk = std::min(count, kSpaceBlock);
+    *this << std::string_view(spaceBlock.text, chunk);
+    count -= chunk;
+  }
+}
+
+void OutputBuffer::flush() {
+  if (used == 0) return;
+  out.write(buffer.get(), static_cast<std::streamsize>(used));
+  out.flush();
+  used = 0;
+}
+
+OutputBuffer& OutputBuffer::writeSlow(std::string_view text) {
+  flush();
+  if (text.size() >= kCapacity) {
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+  } else {
+    std::memcpy(buffer.get(), text.data(), text.size());
+    used = text.size();
+  }
+  return *this;
+}
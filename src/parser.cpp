@@ -1,58 +1,311 @@
 #include "parser.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <atomic>
+#include <exception>
 #include <iostream>
 
-#include "token.h"
+#include "lexer.h"
+#include "parallel.h"
+
+namespace {
+
+// Токен за концом вектора без завершающего EOF
+const Token kEndOfInput(TokenType::EOF_TOKEN, "", 0, 0, 0);
+
+// Приоритеты бинарных операторов как в Java; 0 - токен не оператор
+struct BinaryRule {
+  int precedence;
+  BinaryOperator op;
+};
+
+constexpr size_t kTokenTypeCount = static_cast<size_t>(TokenType::ERROR) + 1;
+
+constexpr std::array<BinaryRule, kTokenTypeCount> makeBinaryRules() {
+  std::array<BinaryRule, kTokenTypeCount> rules{};
+  auto set = [&rules](TokenType type, int precedence, BinaryOperator op) {
+    rules[static_cast<size_t>(type)] = BinaryRule{precedence, op};
+  };
+  set(TokenType::OR, 1, BinaryOperator::OR);
+  set(TokenType::AND, 2, BinaryOperator::AND);
+  set(TokenType::EQUAL, 3, BinaryOperator::EQUAL);
+  set(TokenType::NOT_EQUAL, 3, BinaryOperator::NOT_EQUAL);
+  set(TokenType::LESS, 4, BinaryOperator::LESS);
+  set(TokenType::GREATER, 4, BinaryOperator::GREATER);
+  set(TokenType::LESS_EQUAL, 4, BinaryOperator::LESS_EQUAL);
+  set(TokenType::GREATER_EQUAL, 4, BinaryOperator::GREATER_EQUAL);
+  set(TokenType::PLUS, 5, BinaryOperator::PLUS);
+  set(TokenType::MINUS, 5, BinaryOperator::MINUS);
+  set(TokenType::MULTIPLY, 6, BinaryOperator::MULTIPLY);
+  set(TokenType::DIVIDE, 6, BinaryOperator::DIVIDE);
+  set(TokenType::MODULO, 6, BinaryOperator::MODULO);
+  return rules;
+}
+
+constexpr std::array<BinaryRule, kTokenTypeCount> kBinaryRules =
+    makeBinaryRules();
+
+const BinaryRule& binaryRule(TokenType type) {
+  return kBinaryRules[static_cast<size_t>(type)];
+}
+
+// +1 для открывающей скобки, -1 для закрывающей, 0 для остальных
+int bracketDelta(TokenType type) {
+  switch (type) {
+    case TokenType::LBRACE:
+    case TokenType::LPAREN:
+    case TokenType::LBRACKET:
+      return 1;
+    case TokenType::RBRACE:
+    case TokenType::RPAREN:
+    case TokenType::RBRACKET:
+      return -1;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+// Глубина вложенности выражений и операторов ограничена, чтобы
+// враждебный ввод давал ошибку разбора, а не переполнение стека.
+// После ошибки восстановление продолжает разбор внутри той же слишком
+// глубокой конструкции, и она снова упирается в предел: об этом
+// сообщается один раз на тело метода, а повторные срабатывания только
+// переводят парсер в панику, и токены пропускаются до границы.
+// Скобочная группа, на которой сработал предел, пропускается целиком:
+// разбор продолжается с её закрывающей скобки, а не изнутри
+bool Parser::NestingScope::exceeded() {
+  if (parser.nesting <= kMaxNesting) return false;
+  if (parser.nestingReported) {
+    parser.panicking = true;
+  } else {
+    parser.nestingReported = true;
+    parser.report(parser.peek(), "Слишком глубокая вложенность (больше " +
+                                     std::to_string(kMaxNesting) + " уровней)");
+  }
+  parser.skipGroup();
+  return true;
+}
+
+// Пропускает скобочную группу, которая начинается с текущего токена,
+// вместе с закрывающей скобкой; с другого токена не пропускает ничего
+void Parser::skipGroup() {
+  if (bracketDelta(peek().type) <= 0) return;
+  int open = 0;
+  while (!isAtEnd()) {
+    open += bracketDelta(advance().type);
+    if (open == 0) return;
+  }
+}
+
+Parser::Parser(const std::vector<Token>& tokens) : tokens(&tokens) {}
+
+Parser::Parser(Lexer& lexer) : lexer(&lexer) {
+  window.reserve(kWindowSize);
+  fetch();
+}
+
+Parser::Parser(const TokenStream& stream) : stream(&stream) {
+  window.reserve(kWindowSize);
+  fetch();
+}
+
+size_t Parser::tokenCount() const {
+  if (lexer) return fetched;
+  return stream ? stream->size() : tokens->size();
+}
+
+// Доступ к токену по абсолютному индексу во всех режимах
+const Token& Parser::tokenAt(size_t index) const {
+  if (tokens) return (*tokens)[index];
+
+  assert(index < fetched && index + kWindowSize >= fetched);
+  return window[index % kWindowSize];
+}
+
+// В потоковом режиме дочитывает токены из лексера (или компактного
+// потока) так, чтобы текущий токен всегда был в окне
+void Parser::fetch() {
+  if (tokens) return;
+
+  while (fetched <= current) {
+    Token token = lexer ? lexer->getNextToken()
+                        : stream->token(std::min(fetched, stream->size() - 1));
+    if (window.size() < kWindowSize) {
+      window.push_back(token);
+    } else {
+      window[fetched % kWindowSize] = token;
+    }
+    fetched++;
+  }
+}
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), current(0) {}
+// Вспомогательные методы для навигации. Токены возвращаются по ссылке
+// на вектор или окно; ссылка на окно живёт, пока парсер не продвинется
+// на kWindowSize токенов, поэтому надолго сохраняемые токены копируются
 
-// Вспомогательные методы для навигации
-Token Parser::peek() const {
-  if (isAtEnd()) return Token(TokenType::EOF_TOKEN, "", 0, 0);
-  return tokens[current];
+const Token& Parser::peek() const {
+  if (tokens && current >= tokens->size()) return kEndOfInput;
+  return tokenAt(current);
 }
 
-Token Parser::previous() const { return tokens[current - 1]; }
+const Token& Parser::previous() const { return tokenAt(current - 1); }
 
 bool Parser::isAtEnd() const {
-  return current >= tokens.size() ||
-         tokens[current].type == TokenType::EOF_TOKEN;
+  return peek().type == TokenType::EOF_TOKEN;
 }
 
-Token Parser::advance() {
-  if (!isAtEnd()) current++;
+const Token& Parser::advance() {
+  if (!isAtEnd()) {
+    current++;
+    fetch();
+  }
   return previous();
 }
 
 bool Parser::check(TokenType type) const {
-  if (isAtEnd()) return false;
-  return peek().type == type;
+  TokenType next = peek().type;
+  return next == type && next != TokenType::EOF_TOKEN;
 }
 
 bool Parser::match(TokenType type) {
   if (check(type)) {
-    advance();
+    current++;
+    fetch();
     return true;
   }
   return false;
 }
 
-Token Parser::consume(TokenType type, const std::string& message) {
+// Сообщение передаётся как const char*: строка ошибки собирается,
+// только если она действительно нужна
+// В режиме восстановления при несовпадении токен не потребляется
+const Token& Parser::consume(TokenType type, const char* message) {
   if (check(type)) return advance();
-  throw error(peek(), message);
+  report(peek(), message);
+  return peek();
 }
 
-Parser::ParseError Parser::error(const Token& token,
-                                 const std::string& message) {
+Parser::Diagnostic Parser::describe(const Token& token,
+                                    const std::string& message) const {
+  // У токенов компактного потока позиция вычисляется только здесь
+  int line = token.line;
+  int column = token.column;
+  if (line == 0 && stream) {
+    LineIndex::Location location = stream->lines().locate(token.offset);
+    line = location.line;
+    column = location.column;
+  }
+
   std::string errorMsg;
   if (token.type == TokenType::EOF_TOKEN) {
     errorMsg = "Ошибка в конце файла: " + message;
   } else {
-    errorMsg = "Ошибка в строке " + std::to_string(token.line) + ", столбец " +
-               std::to_string(token.column) + ": " + message + " (найдено '" +
-               token.lexeme + "')";
+    errorMsg = "Ошибка в строке " + std::to_string(line) + ", столбец " +
+               std::to_string(column) + ": " + message + " (найдено '" +
+               std::string(token.lexeme) + "')";
+  }
+  return Diagnostic{line, column, errorMsg};
+}
+
+Parser::ParseError Parser::error(const Token& token,
+                                 const std::string& message) {
+  return ParseError(describe(token, message).message);
+}
+
+// Без режима восстановления ошибка сразу бросается. Иначе записывается
+// первая ошибка конструкции, а до восстановления на границе списка
+// парсер находится в состоянии паники: следующие ошибки - как правило,
+// следствия первой - не записываются, consume() не продвигается
+void Parser::report(const Token& token, const std::string& message) {
+  if (!recovery) throw error(token, message);
+  if (panicking) return;
+  panicking = true;
+
+  if (errors.size() < kMaxDiagnostics) {
+    errors.push_back(describe(token, message));
+  } else if (errors.size() == kMaxDiagnostics) {
+    errors.push_back(Diagnostic{0, 0, "Слишком много ошибок, разбор остановлен"});
+  }
+}
+
+namespace {
+
+bool isStatementBoundary(TokenType type) {
+  switch (type) {
+    case TokenType::LBRACE:
+    case TokenType::RBRACE:
+    case TokenType::IF:
+    case TokenType::WHILE:
+    case TokenType::ASSERT:
+    case TokenType::SYSTEM:
+    case TokenType::RETURN:
+    case TokenType::INT_TYPE:
+    case TokenType::BOOLEAN_TYPE:
+    case TokenType::PUBLIC:
+    case TokenType::CLASS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool isDeclarationBoundary(TokenType type) {
+  switch (type) {
+    case TokenType::RBRACE:
+    case TokenType::PUBLIC:
+    case TokenType::CLASS:
+    case TokenType::INT_TYPE:
+    case TokenType::BOOLEAN_TYPE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+// Выход из паники после ошибки в элементе списка, начавшемся с токена
+// start: токены пропускаются до границы уровня boundary (для операторов
+// и объявлений ещё и до конца ';'). Возвращает false, если список
+// на этом уровне закончился и разбор продолжается уровнем выше
+bool Parser::recover(Boundary boundary, size_t start) {
+  if (errors.size() > kMaxDiagnostics) {
+    while (!isAtEnd()) advance();
+    return false;
+  }
+  panicking = false;
+
+  // Элемент не потребил ни одного токена: без пропуска цикл списка
+  // снова остановился бы на том же токене
+  if (current == start && !isAtEnd()) advance();
+
+  while (!isAtEnd()) {
+    TokenType next = peek().type;
+    switch (boundary) {
+      case Boundary::Statement:
+        if (previous().type == TokenType::SEMICOLON ||
+            isStatementBoundary(next)) {
+          return next != TokenType::PUBLIC && next != TokenType::CLASS;
+        }
+        break;
+      case Boundary::Declaration:
+        if (previous().type == TokenType::SEMICOLON ||
+            isDeclarationBoundary(next)) {
+          return next != TokenType::CLASS;
+        }
+        break;
+      case Boundary::Class:
+        if (next == TokenType::CLASS) return true;
+        break;
+    }
+    advance();
   }
-  return ParseError(errorMsg);
+  return false;
 }
 
 void Parser::synchronize() {
@@ -76,17 +329,45 @@ void Parser::synchronize() {
   }
 }
 
+template <typename T>
+AstList<T> Parser::takeList(size_t base) {
+  size_t count = scratch.size() - base;
+  T** items = arena.allocateArray<T*>(count);
+  for (size_t i = 0; i < count; i++) {
+    items[i] = static_cast<T*>(scratch[base + i]);
+  }
+  scratch.resize(base);
+  return AstList<T>(items, count);
+}
+
+void Parser::resetState() {
+  scratch.clear();
+  nesting = 0;
+  panicking = false;
+  errors.clear();
+}
+
+AstList<ClassDeclaration> Parser::parseClasses(size_t end) {
+  size_t base = scratch.size();
+  while (current < end && !isAtEnd()) {
+    size_t start = current;
+    scratch.push_back(parseClassDeclaration());
+    if (panicking) recover(Boundary::Class, start);
+  }
+  return takeList<ClassDeclaration>(base);
+}
+
 // Основной метод парсинга программы
 std::unique_ptr<Program> Parser::parseProgram() {
   try {
+    resetState();
+
     auto mainClass = parseMainClass();
-    std::vector<std::unique_ptr<ClassDeclaration>> classes;
+    if (panicking) recover(Boundary::Class, 0);
 
-    while (!isAtEnd() && check(TokenType::CLASS)) {
-      classes.push_back(parseClassDeclaration());
-    }
+    auto classes = parseClasses(SIZE_MAX);
 
-    return std::make_unique<Program>(std::move(mainClass), std::move(classes));
+    return std::make_unique<Program>(std::move(arena), mainClass, classes);
   } catch (const ParseError& e) {
     std::cerr << e.what() << std::endl;
     synchronize();
@@ -94,8 +375,105 @@ std::unique_ptr<Program> Parser::parseProgram() {
   }
 }
 
+namespace {
+
+// Группы меньше этого числа токенов не окупают передачу другому потоку
+constexpr size_t kMinGroupTokens = 8192;
+
+// Групп в несколько раз больше, чем потоков, чтобы потоки,
+// закончившие раньше, забирали оставшиеся группы
+constexpr size_t kGroupsPerThread = 4;
+
+}  // namespace
+
+// 'class' - зарезервированное слово и встречается только в начале
+// объявления класса. Поэтому каждый токен CLASS - граница класса
+// верхнего уровня, и подсчёт скобок не нужен: на этих же токенах
+// останавливаются списки объявлений и операторов при обычном разборе,
+// в том числе после незакрытой '{'. Группа разбирается до начала
+// следующей группы, и ошибки в ней те же, что при обычном разборе
+std::unique_ptr<Program> Parser::parseProgramParallel(unsigned threads) {
+  threads = resolveThreads(threads);
+  if (!tokens || threads == 1) return parseProgram();
+
+  try {
+    resetState();
+
+    auto mainClass = parseMainClass();
+    if (panicking) recover(Boundary::Class, 0);
+
+    size_t end = tokens->size();
+    size_t groupTokens = std::max(
+        kMinGroupTokens, (end - current) / (threads * kGroupsPerThread));
+    std::vector<size_t> bounds{current};
+    for (size_t i = current; i < end; i++) {
+      if ((*tokens)[i].type == TokenType::CLASS &&
+          i - bounds.back() >= groupTokens) {
+        bounds.push_back(i);
+      }
+    }
+    bounds.push_back(end);
+
+    struct Group {
+      AstArena arena;
+      AstList<ClassDeclaration> classes;
+      std::vector<Diagnostic> errors;
+      std::exception_ptr failure;
+    };
+    std::vector<Group> groups(bounds.size() - 1);
+
+    // Потоки забирают группы по одной, пока они не кончатся
+    std::atomic<size_t> nextGroup{0};
+    auto worker = [&](size_t) {
+      for (size_t index; (index = nextGroup.fetch_add(1)) < groups.size();) {
+        Group& group = groups[index];
+        Parser parser(*tokens);
+        parser.current = bounds[index];
+        parser.recovery = recovery;
+        try {
+          group.classes = parser.parseClasses(bounds[index + 1]);
+        } catch (...) {
+          group.failure = std::current_exception();
+        }
+        group.arena = std::move(parser.arena);
+        group.errors = std::move(parser.errors);
+      }
+    };
+    runParallel(std::min<size_t>(threads, groups.size()), worker);
+
+    // Сборка в порядке исходного текста: первой бросается самая ранняя
+    // ошибка, а после превышения лимита диагностик, как и при обычном
+    // разборе, следующие классы в дерево не попадают
+    size_t base = scratch.size();
+    for (Group& group : groups) {
+      if (errors.size() > kMaxDiagnostics) break;
+      if (group.failure) std::rethrow_exception(group.failure);
+
+      arena.adopt(std::move(group.arena));
+      for (ClassDeclaration* declaration : group.classes) {
+        scratch.push_back(declaration);
+      }
+      for (Diagnostic& diagnostic : group.errors) {
+        if (errors.size() < kMaxDiagnostics) {
+          errors.push_back(std::move(diagnostic));
+        } else {
+          errors.push_back(
+              Diagnostic{0, 0, "Слишком много ошибок, разбор остановлен"});
+          break;
+        }
+      }
+    }
+    auto classes = takeList<ClassDeclaration>(base);
+
+    return std::make_unique<Program>(std::move(arena), mainClass, classes);
+  } catch (const ParseError& e) {
+    std::cerr << e.what() << std::endl;
+    throw;
+  }
+}
+
 // Парсинг главного класса
-std::unique_ptr<MainClass> Parser::parseMainClass() {
+MainClass* Parser::parseMainClass() {
   consume(TokenType::CLASS, "Ожидалось ключевое слово 'class'");
   Token className =
       consume(TokenType::IDENTIFIER, "Ожидался идентификатор имени класса");
@@ -107,46 +485,51 @@ std::unique_ptr<MainClass> Parser::parseMainClass() {
   consume(TokenType::LPAREN, "Ожидалась '('");
   consume(TokenType::RPAREN, "Ожидалась ')'");
   consume(TokenType::LBRACE, "Ожидалась '{'");
+  if (panicking) return make<MainClass>(className.symbol, AstList<Statement>());
 
-  std::vector<std::unique_ptr<Statement>> statements;
-  while (!check(TokenType::RBRACE) && !isAtEnd()) {
-    statements.push_back(parseStatement());
-  }
+  auto statements = parseStatements();
 
   consume(TokenType::RBRACE, "Ожидалась '}' для закрытия блока main");
   consume(TokenType::RBRACE, "Ожидалась '}' для закрытия класса");
 
-  return std::make_unique<MainClass>(className.lexeme, std::move(statements));
+  return make<MainClass>(className.symbol, statements);
 }
 
 // Парсинг объявления класса
-std::unique_ptr<ClassDeclaration> Parser::parseClassDeclaration() {
+ClassDeclaration* Parser::parseClassDeclaration() {
   consume(TokenType::CLASS, "Ожидалось ключевое слово 'class'");
   Token className =
       consume(TokenType::IDENTIFIER, "Ожидался идентификатор имени класса");
 
-  std::string baseClassName = "";
+  Symbol baseClassName;
   if (match(TokenType::EXTENDS)) {
     Token baseClass = consume(TokenType::IDENTIFIER,
                               "Ожидался идентификатор родительского класса");
-    baseClassName = baseClass.lexeme;
+    baseClassName = baseClass.symbol;
   }
 
   consume(TokenType::LBRACE, "Ожидалась '{'");
+  if (panicking) {
+    return make<ClassDeclaration>(className.symbol, baseClassName,
+                                  AstList<Declaration>());
+  }
 
-  std::vector<std::unique_ptr<Declaration>> declarations;
-  while (!check(TokenType::RBRACE) && !isAtEnd()) {
-    declarations.push_back(parseDeclaration());
+  size_t base = scratch.size();
+  while (!check(TokenType::RBRACE) && !check(TokenType::CLASS) && !isAtEnd()) {
+    size_t start = current;
+    scratch.push_back(parseDeclaration());
+    if (panicking && !recover(Boundary::Declaration, start)) break;
   }
+  auto declarations = takeList<Declaration>(base);
 
   consume(TokenType::RBRACE, "Ожидалась '}'");
 
-  return std::make_unique<ClassDeclaration>(className.lexeme, baseClassName,
-                                            std::move(declarations));
+  return make<ClassDeclaration>(className.symbol, baseClassName,
+                                declarations);
 }
 
 // Парсинг объявления (переменной или метода)
-std::unique_ptr<Declaration> Parser::parseDeclaration() {
+Declaration* Parser::parseDeclaration() {
   if (match(TokenType::PUBLIC)) {
     return parseMethodDeclaration();
   } else {
@@ -157,95 +540,114 @@ std::unique_ptr<Declaration> Parser::parseDeclaration() {
 }
 
 // Парсинг объявления метода
-std::unique_ptr<MethodDeclaration> Parser::parseMethodDeclaration() {
+MethodDeclaration* Parser::parseMethodDeclaration() {
   auto returnType = parseType();
   Token methodName =
       consume(TokenType::IDENTIFIER, "Ожидался идентификатор метода");
   consume(TokenType::LPAREN, "Ожидалась '('");
 
-  std::vector<std::unique_ptr<VariableDeclaration>> parameters;
-  if (!check(TokenType::RPAREN)) {
+  AstList<VariableDeclaration> parameters;
+  if (!panicking && !check(TokenType::RPAREN)) {
     parameters = parseFormals();
   }
 
   consume(TokenType::RPAREN, "Ожидалась ')'");
   consume(TokenType::LBRACE, "Ожидалась '{'");
-
-  std::vector<std::unique_ptr<Statement>> statements;
-  while (!check(TokenType::RBRACE) && !isAtEnd()) {
-    statements.push_back(parseStatement());
+  if (panicking) {
+    return make<MethodDeclaration>(returnType, methodName.symbol, parameters,
+                                   AstList<Statement>());
   }
 
+  auto statements = parseStatements();
+
   consume(TokenType::RBRACE, "Ожидалась '}'");
 
-  return std::make_unique<MethodDeclaration>(
-      std::move(returnType), methodName.lexeme, std::move(parameters),
-      std::move(statements));
+  return make<MethodDeclaration>(returnType, methodName.symbol, parameters,
+                                 statements);
 }
 
 // Парсинг объявления переменной
-std::unique_ptr<VariableDeclaration> Parser::parseVariableDeclaration() {
+VariableDeclaration* Parser::parseVariableDeclaration() {
   auto type = parseType();
   Token varName =
       consume(TokenType::IDENTIFIER, "Ожидался идентификатор переменной");
   consume(TokenType::SEMICOLON, "Ожидалась ';'");
 
-  return std::make_unique<VariableDeclaration>(std::move(type), varName.lexeme);
+  return make<VariableDeclaration>(type,
+                                               varName.symbol);
 }
 
 // Парсинг формальных параметров
-std::vector<std::unique_ptr<VariableDeclaration>> Parser::parseFormals() {
-  std::vector<std::unique_ptr<VariableDeclaration>> parameters;
+AstList<VariableDeclaration> Parser::parseFormals() {
+  size_t base = scratch.size();
 
   auto type = parseType();
   Token paramName =
       consume(TokenType::IDENTIFIER, "Ожидался идентификатор параметра");
-  parameters.push_back(
-      std::make_unique<VariableDeclaration>(std::move(type), paramName.lexeme));
+  scratch.push_back(make<VariableDeclaration>(type, paramName.symbol));
 
   while (match(TokenType::COMMA)) {
     type = parseType();
     paramName =
         consume(TokenType::IDENTIFIER, "Ожидался идентификатор параметра");
-    parameters.push_back(std::make_unique<VariableDeclaration>(
-        std::move(type), paramName.lexeme));
+    scratch.push_back(make<VariableDeclaration>(type, paramName.symbol));
   }
 
-  return parameters;
+  return takeList<VariableDeclaration>(base);
 }
 
 // Парсинг типа
-std::unique_ptr<Type> Parser::parseType() {
+Type* Parser::parseType() {
   auto baseType = parseSimpleType();
 
   if (match(TokenType::LBRACKET)) {
     consume(TokenType::RBRACKET, "Ожидалась ']'");
-    return std::make_unique<ArrayType>(std::unique_ptr<SimpleType>(
-        static_cast<SimpleType*>(baseType.release())));
+    return make<ArrayType>(baseType);
   }
 
   return baseType;
 }
 
 // Парсинг простого типа
-std::unique_ptr<Type> Parser::parseSimpleType() {
+SimpleType* Parser::parseSimpleType() {
   if (match(TokenType::INT_TYPE)) {
-    return std::make_unique<IntType>();
+    return make<IntType>();
   } else if (match(TokenType::BOOLEAN_TYPE)) {
-    return std::make_unique<BooleanType>();
+    return make<BooleanType>();
   } else if (match(TokenType::VOID_TYPE)) {
-    return std::make_unique<VoidType>();
+    return make<VoidType>();
   } else if (check(TokenType::IDENTIFIER)) {
     Token typeName =
         consume(TokenType::IDENTIFIER, "Ожидался идентификатор типа");
-    return std::make_unique<IdentifierType>(typeName.lexeme);
+    return make<IdentifierType>(typeName.symbol);
   } else {
-    throw error(peek(), "Ожидался тип");
+    // Вместо отсутствующего типа - тип с пустым именем
+    report(peek(), "Ожидался тип");
+    return make<IdentifierType>(Symbol());
+  }
+}
+
+// Операторы до закрывающей '}' (она не потребляется). С 'public'
+// и 'class' оператор начаться не может: на них список тоже заканчивается,
+// и отсутствующая '}' даёт одну ошибку. После ошибки в операторе разбор
+// продолжается со следующего
+AstList<Statement> Parser::parseStatements() {
+  if (nesting == 0) nestingReported = false;  // тело метода
+  size_t base = scratch.size();
+  while (!check(TokenType::RBRACE) && !check(TokenType::PUBLIC) &&
+         !check(TokenType::CLASS) && !isAtEnd()) {
+    size_t start = current;
+    scratch.push_back(parseStatement());
+    if (panicking && !recover(Boundary::Statement, start)) break;
   }
+  return takeList<Statement>(base);
 }
 
 // Парсинг оператора
-std::unique_ptr<Statement> Parser::parseStatement() {
+Statement* Parser::parseStatement() {
+  NestingScope scope(*this);
+  if (scope.exceeded()) return make<ErrorStatement>();
+
   if (match(TokenType::ASSERT)) {
     return parseAssertStatement();
   } else if (check(TokenType::INT_TYPE) || check(TokenType::BOOLEAN_TYPE) ||
@@ -260,21 +662,22 @@ std::unique_ptr<Statement> Parser::parseStatement() {
       
       if (match(TokenType::ASSIGN)) {
         // Это оператор присваивания
-        auto lvalue = std::make_unique<IdentifierLValue>(identToken.lexeme);
+        auto lvalue =
+            make<IdentifierLValue>(identToken.symbol);
         auto value = parseExpression();
         consume(TokenType::SEMICOLON, "Ожидалась ';'");
         
-        return std::make_unique<AssignStatement>(std::move(lvalue), std::move(value));
+        return make<AssignStatement>(lvalue, value);
       } else {
         // Это не присваивание, возвращаемся назад
         current = savePoint;
         
         // Локальное объявление переменной
-        return std::make_unique<LocalVarDeclStatement>(parseVariableDeclaration());
+        return make<LocalVarDeclStatement>(parseVariableDeclaration());
       }
     } else {
       // Локальное объявление переменной
-      return std::make_unique<LocalVarDeclStatement>(parseVariableDeclaration());
+      return make<LocalVarDeclStatement>(parseVariableDeclaration());
     }
   } else if (match(TokenType::LBRACE)) {
     return parseBlockStatement();
@@ -286,64 +689,61 @@ std::unique_ptr<Statement> Parser::parseStatement() {
     return parsePrintStatement();
   } else if (match(TokenType::RETURN)) {
     return parseReturnStatement();
-  } else {
-    // Остальная логика parseStatement...
   }
+
+  report(peek(), "Ожидался оператор");
+  return make<ErrorStatement>();
 }
 // Парсинг оператора assert
-std::unique_ptr<Statement> Parser::parseAssertStatement() {
+Statement* Parser::parseAssertStatement() {
   consume(TokenType::LPAREN, "Ожидалась '(' после 'assert'");
   auto condition = parseExpression();
   consume(TokenType::RPAREN, "Ожидалась ')'");
   consume(TokenType::SEMICOLON, "Ожидалась ';'");
 
-  return std::make_unique<AssertStatement>(std::move(condition));
+  return make<AssertStatement>(condition);
 }
 
 // Парсинг блока операторов
-std::unique_ptr<Statement> Parser::parseBlockStatement() {
-  std::vector<std::unique_ptr<Statement>> statements;
-
-  while (!check(TokenType::RBRACE) && !isAtEnd()) {
-    statements.push_back(parseStatement());
-  }
+Statement* Parser::parseBlockStatement() {
+  auto statements = parseStatements();
 
   consume(TokenType::RBRACE, "Ожидалась '}'");
 
-  return std::make_unique<BlockStatement>(std::move(statements));
+  return make<BlockStatement>(statements);
 }
 
 // Парсинг оператора if
-std::unique_ptr<Statement> Parser::parseIfStatement() {
+Statement* Parser::parseIfStatement() {
   consume(TokenType::LPAREN, "Ожидалась '(' после 'if'");
   auto condition = parseExpression();
   consume(TokenType::RPAREN, "Ожидалась ')'");
 
   auto thenStatement = parseStatement();
 
-  std::unique_ptr<Statement> elseStatement = nullptr;
+  Statement* elseStatement = nullptr;
   if (match(TokenType::ELSE)) {
     elseStatement = parseStatement();
   }
 
-  return std::make_unique<IfStatement>(
-      std::move(condition), std::move(thenStatement), std::move(elseStatement));
+  return make<IfStatement>(
+      condition, thenStatement, elseStatement);
 }
 
 // Парсинг оператора while
-std::unique_ptr<Statement> Parser::parseWhileStatement() {
+Statement* Parser::parseWhileStatement() {
   consume(TokenType::LPAREN, "Ожидалась '(' после 'while'");
   auto condition = parseExpression();
   consume(TokenType::RPAREN, "Ожидалась ')'");
 
   auto body = parseStatement();
 
-  return std::make_unique<WhileStatement>(std::move(condition),
-                                          std::move(body));
+  return make<WhileStatement>(condition,
+                                          body);
 }
 
 // Парсинг оператора вывода System.out.println
-std::unique_ptr<Statement> Parser::parsePrintStatement() {
+Statement* Parser::parsePrintStatement() {
   consume(TokenType::DOT, "Ожидалась '.' после 'System'");
   consume(TokenType::OUT, "Ожидалось 'out' после 'System.'");
   consume(TokenType::DOT, "Ожидалась '.' после 'out'");
@@ -355,155 +755,108 @@ std::unique_ptr<Statement> Parser::parsePrintStatement() {
   consume(TokenType::RPAREN, "Ожидалась ')'");
   consume(TokenType::SEMICOLON, "Ожидалась ';'");
 
-  return std::make_unique<PrintStatement>(std::move(expression));
+  return make<PrintStatement>(expression);
 }
 
 // Парсинг оператора return
-std::unique_ptr<Statement> Parser::parseReturnStatement() {
+Statement* Parser::parseReturnStatement() {
   auto expression = parseExpression();
   consume(TokenType::SEMICOLON, "Ожидалась ';' после return");
 
-  return std::make_unique<ReturnStatement>(std::move(expression));
+  return make<ReturnStatement>(expression);
 }
 
 // Парсинг выражения
-std::unique_ptr<Expression> Parser::parseExpression() {
-  return parseLogicalOr();
-}
-
-// Парсинг логического "ИЛИ"
-std::unique_ptr<Expression> Parser::parseLogicalOr() {
-  auto expr = parseLogicalAnd();
-
-  while (match(TokenType::OR)) {
-    auto right = parseLogicalAnd();
-    expr = std::make_unique<BinaryOperation>(
-        std::move(expr), BinaryOperator::OR, std::move(right));
-  }
-
-  return expr;
-}
-
-// Парсинг логического "И"
-std::unique_ptr<Expression> Parser::parseLogicalAnd() {
-  auto expr = parseEquality();
-
-  while (match(TokenType::AND)) {
-    auto right = parseEquality();
-    expr = std::make_unique<BinaryOperation>(
-        std::move(expr), BinaryOperator::AND, std::move(right));
-  }
-
-  return expr;
-}
-
-// Парсинг операций равенства
-std::unique_ptr<Expression> Parser::parseEquality() {
-  auto expr = parseRelational();
-
-  while (match(TokenType::EQUAL)) {
-    auto right = parseRelational();
-    expr = std::make_unique<BinaryOperation>(
-        std::move(expr), BinaryOperator::EQUAL, std::move(right));
-  }
-
-  return expr;
-}
-
-// Парсинг операций отношения
-std::unique_ptr<Expression> Parser::parseRelational() {
-  auto expr = parseAdditive();
-
-  while (true) {
-    if (match(TokenType::LESS)) {
-      auto right = parseAdditive();
-      expr = std::make_unique<BinaryOperation>(
-          std::move(expr), BinaryOperator::LESS, std::move(right));
-    } else if (match(TokenType::GREATER)) {
-      auto right = parseAdditive();
-      expr = std::make_unique<BinaryOperation>(
-          std::move(expr), BinaryOperator::GREATER, std::move(right));
-    } else {
-      break;
-    }
-  }
-
-  return expr;
-}
-
-// Парсинг аддитивных операций
-std::unique_ptr<Expression> Parser::parseAdditive() {
-  auto expr = parseMultiplicative();
+Expression* Parser::parseExpression() {
+  NestingScope scope(*this);
+  if (scope.exceeded()) {
+    depth = 1;
+    return make<ErrorExpression>();
+  }
+  return parseBinary(1);
+}
+
+// Узел над поддеревом глубины childDepth. Цепочки a + b + ... и
+// a.f().g()... разбираются циклом, без вложенности, но строят дерево
+// глубиной в длину цепочки, а обходы дерева рекурсивны. Поэтому
+// глубина дерева выражения ограничена отдельно от вложенности:
+// true - предел превышен, вместо узла строится ErrorExpression
+bool Parser::tooDeep(int childDepth) {
+  depth = childDepth + 1;
+  if (depth <= kMaxExpressionDepth) return false;
+  report(peek(), "Слишком глубокая вложенность (больше " +
+                     std::to_string(kMaxExpressionDepth) + " уровней в выражении)");
+  depth = 1;
+  return true;
+}
+
+// Бинарные операторы методом повышения приоритета: левый операнд
+// накапливается в цикле, правый разбирается рекурсивно только
+// с операторами строго более высокого приоритета (все операторы
+// левоассоциативны). Неоператор имеет приоритет 0 и завершает цикл.
+// После превышения глубины остаток цепочки разбирается, но не строится
+Expression* Parser::parseBinary(int minPrecedence) {
+  Expression* left = parseUnary();
+  int leftDepth = depth;
+  bool overflow = false;
 
   while (true) {
-    if (match(TokenType::PLUS)) {
-      auto right = parseMultiplicative();
-      expr = std::make_unique<BinaryOperation>(
-          std::move(expr), BinaryOperator::PLUS, std::move(right));
-    } else if (match(TokenType::MINUS)) {
-      auto right = parseMultiplicative();
-      expr = std::make_unique<BinaryOperation>(
-          std::move(expr), BinaryOperator::MINUS, std::move(right));
-    } else {
-      break;
-    }
-  }
-
-  return expr;
-}
-
-// Парсинг мультипликативных операций
-std::unique_ptr<Expression> Parser::parseMultiplicative() {
-  auto expr = parseUnary();
+    const BinaryRule& rule = binaryRule(peek().type);
+    if (rule.precedence < minPrecedence) break;
+    advance();
 
-  while (true) {
-    if (match(TokenType::MULTIPLY)) {
-      auto right = parseUnary();
-      expr = std::make_unique<BinaryOperation>(
-          std::move(expr), BinaryOperator::MULTIPLY, std::move(right));
-    } else if (match(TokenType::DIVIDE)) {
-      auto right = parseUnary();
-      expr = std::make_unique<BinaryOperation>(
-          std::move(expr), BinaryOperator::DIVIDE, std::move(right));
-    } else if (match(TokenType::MODULO)) {
-      auto right = parseUnary();
-      expr = std::make_unique<BinaryOperation>(
-          std::move(expr), BinaryOperator::MODULO, std::move(right));
+    Expression* right = parseBinary(rule.precedence + 1);
+    if (overflow) continue;
+    if (tooDeep(std::max(leftDepth, depth))) {
+      left = make<ErrorExpression>();
+      overflow = true;
     } else {
-      break;
+      left = make<BinaryOperation>(left, rule.op, right);
     }
+    leftDepth = depth;
   }
 
-  return expr;
+  depth = leftDepth;
+  return left;
 }
 
 // Парсинг унарных операций
-std::unique_ptr<Expression> Parser::parseUnary() {
+Expression* Parser::parseUnary() {
   if (match(TokenType::NOT)) {
+    NestingScope scope(*this);
+    if (scope.exceeded()) {
+      depth = 1;
+      return make<ErrorExpression>();
+    }
     auto right = parseUnary();
-    return std::make_unique<UnaryOperation>(UnaryOperator::NOT,
-                                            std::move(right));
+    if (tooDeep(depth)) return make<ErrorExpression>();
+    return make<UnaryOperation>(UnaryOperator::NOT, right);
   }
 
   return parsePostfix();
 }
 
 // Парсинг постфиксных выражений (доступ к массивам, полям, вызовы методов)
-std::unique_ptr<Expression> Parser::parsePostfix() {
+Expression* Parser::parsePostfix() {
   auto expr = parsePrimary();
+  int exprDepth = depth;
+  bool overflow = false;
 
   while (true) {
+    Expression* next;
+    int childDepth = exprDepth;
     if (match(TokenType::LBRACKET)) {
       // Индексация массива
       auto index = parseExpression();
       consume(TokenType::RBRACKET, "Ожидалась ']'");
 
-      expr = std::make_unique<ArrayIndexing>(std::move(expr), std::move(index));
+      childDepth = std::max(childDepth, depth);
+      next = overflow ? nullptr : make<ArrayIndexing>(expr, index);
     } else if (match(TokenType::DOT)) {
       // Обращение к члену через точку
       if (match(TokenType::LENGTH)) {
         // Доступ к длине массива
-        expr = std::make_unique<ArrayLength>(std::move(expr));
+        next = overflow ? nullptr : make<ArrayLength>(expr);
       } else {
         // Вызов метода или доступ к полю
         Token memberName =
@@ -511,55 +864,66 @@ std::unique_ptr<Expression> Parser::parsePostfix() {
 
         if (match(TokenType::LPAREN)) {
           // Вызов метода
-          std::vector<std::unique_ptr<Expression>> arguments;
+          size_t base = scratch.size();
 
           if (!check(TokenType::RPAREN)) {
-            arguments.push_back(parseExpression());
+            scratch.push_back(parseExpression());
+            childDepth = std::max(childDepth, depth);
 
             while (match(TokenType::COMMA)) {
-              arguments.push_back(parseExpression());
+              scratch.push_back(parseExpression());
+              childDepth = std::max(childDepth, depth);
             }
           }
-
+          auto arguments = takeList<Expression>(base);
           consume(TokenType::RPAREN, "Ожидалась ')'");
 
-          expr = std::make_unique<MethodInvocation>(
-              std::move(expr), memberName.lexeme, std::move(arguments));
+          next = overflow ? nullptr : make<MethodInvocation>(expr, memberName.symbol, arguments);
         } else {
           // Доступ к полю
-          expr =
-              std::make_unique<FieldAccess>(std::move(expr), memberName.lexeme);
+          next = overflow ? nullptr : make<FieldAccess>(expr, memberName.symbol);
         }
       }
     } else {
       break;
     }
+
+    if (overflow) continue;
+    if (tooDeep(childDepth)) {
+      expr = make<ErrorExpression>();
+      overflow = true;
+    } else {
+      expr = next;
+    }
+    exprDepth = depth;
   }
 
+  depth = exprDepth;
   return expr;
 }
 
 // Парсинг первичных выражений
-std::unique_ptr<Expression> Parser::parsePrimary() {
+Expression* Parser::parsePrimary() {
+  depth = 1;
   if (match(TokenType::INTEGER_LITERAL)) {
-    int value = std::stoi(previous().lexeme);
-    return std::make_unique<IntegerLiteral>(value);
+    return make<IntegerLiteral>(previous().value);
   }
 
   if (match(TokenType::TRUE)) {
-    return std::make_unique<BooleanLiteral>(true);
+    return make<BooleanLiteral>(true);
   }
 
   if (match(TokenType::FALSE)) {
-    return std::make_unique<BooleanLiteral>(false);
+    return make<BooleanLiteral>(false);
   }
 
   if (match(TokenType::THIS)) {
-    return std::make_unique<ThisExpression>();
+    return make<ThisExpression>();
   }
 
   if (match(TokenType::IDENTIFIER)) {
-    return std::make_unique<IdentifierExpression>(previous().lexeme);
+    return make<IdentifierExpression>(
+        previous().symbol);
   }
 
   if (match(TokenType::LPAREN)) {
@@ -577,55 +941,49 @@ std::unique_ptr<Expression> Parser::parsePrimary() {
             consume(TokenType::IDENTIFIER, "Ожидался идентификатор класса");
         consume(TokenType::LPAREN, "Ожидалась '('");
         consume(TokenType::RPAREN, "Ожидалась ')'");
-        return std::make_unique<NewObject>(className.lexeme);
+        return make<NewObject>(className.symbol);
       } else {
         // Создание массива
         auto type = parseSimpleType();
-        
-        // Проверяем, что тип действительно SimpleType
-        SimpleType* simpleTypePtr = dynamic_cast<SimpleType*>(type.get());
-        if (!simpleTypePtr) {
-          throw error(peek(), "Ожидался простой тип для создания массива");
-        }
-        
+
         consume(TokenType::LBRACKET, "Ожидалась '['");
         auto size = parseExpression();
         consume(TokenType::RBRACKET, "Ожидалась ']'");
-        
-        // Безопасно преобразуем тип
-        return std::make_unique<NewArray>(
-            std::unique_ptr<SimpleType>(static_cast<SimpleType*>(type.release())),
-            std::move(size)
-        );
+
+        if (tooDeep(depth)) return make<ErrorExpression>();
+        return make<NewArray>(type, size);
       }
     }
   }
 
-  throw error(peek(), "Ожидалось выражение");
+  report(peek(), "Ожидалось выражение");
+  depth = 1;
+  return make<ErrorExpression>();
 }
 
 // Парсинг lvalue
-std::unique_ptr<LValue> Parser::parseLValue() {
+LValue* Parser::parseLValue() {
   if (match(TokenType::IDENTIFIER)) {
-    std::string name = previous().lexeme;
+    Symbol name = previous().symbol;
 
     if (match(TokenType::LBRACKET)) {
       auto index = parseExpression();
       consume(TokenType::RBRACKET, "Ожидалась ']'");
 
-      return std::make_unique<ArrayAccess>(name, std::move(index));
+      return make<ArrayAccess>(name, index);
     }
 
-    return std::make_unique<IdentifierLValue>(name);
+    return make<IdentifierLValue>(name);
   } else if (match(TokenType::THIS)) {
     return parseFieldInvocation();
   }
 
-  throw error(peek(), "Ожидался идентификатор или 'this'");
+  report(peek(), "Ожидался идентификатор или 'this'");
+  return make<IdentifierLValue>(Symbol());
 }
 
 // Парсинг обращения к полю
-std::unique_ptr<FieldInvocation> Parser::parseFieldInvocation() {
+FieldInvocation* Parser::parseFieldInvocation() {
   consume(TokenType::DOT, "Ожидалась '.' после 'this'");
   Token fieldName =
       consume(TokenType::IDENTIFIER, "Ожидался идентификатор поля");
@@ -634,9 +992,10 @@ std::unique_ptr<FieldInvocation> Parser::parseFieldInvocation() {
     auto index = parseExpression();
     consume(TokenType::RBRACKET, "Ожидалась ']'");
 
-    return std::make_unique<FieldArrayInvocation>(fieldName.lexeme,
-                                                  std::move(index));
+    return make<FieldArrayInvocation>(fieldName.symbol,
+                                                  index);
   }
 
-  return std::make_unique<SimpleFieldInvocation>(fieldName.lexeme);
+  return make<SimpleFieldInvocation>(
+      fieldName.symbol);
 }
\ No newline at end of file
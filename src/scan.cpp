@@ -0,0 +1,341 @@
+#include "scan.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MINIJAVA_SCAN_X86 1
+#endif
+
+namespace scan {
+namespace {
+
+inline bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isIdentifierChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+// Учёт переводов строк по маске блока, начинающегося с base
+inline void countLines(uint32_t newlines, size_t base, LineCursor& lines) {
+  if (newlines != 0) {
+    lines.line += __builtin_popcount(newlines);
+    lines.lineStart = base + (31 - __builtin_clz(newlines)) + 1;
+  }
+}
+
+// Скалярные версии. Векторные ядра дорабатывают ими хвосты короче блока
+
+size_t skipWhitespaceScalar(const char* text, size_t pos, size_t end) {
+  while (pos < end && isSpace(text[pos])) pos++;
+  return pos;
+}
+
+size_t skipIdentifierCharsScalar(const char* text, size_t pos, size_t end) {
+  while (pos < end && isIdentifierChar(text[pos])) pos++;
+  return pos;
+}
+
+size_t findLineEndScalar(const char* text, size_t pos, size_t end) {
+  while (pos < end && text[pos] != '\n') pos++;
+  return pos;
+}
+
+size_t findCommentDelimiterScalar(const char* text, size_t pos, size_t end) {
+  while (pos < end && text[pos] != '*' && text[pos] != '/') pos++;
+  return pos;
+}
+
+void advanceLinesScalar(const char* text, size_t target, LineCursor& lines) {
+  for (size_t pos = lines.position; pos < target; pos++) {
+    if (text[pos] == '\n') {
+      lines.line++;
+      lines.lineStart = pos + 1;
+    }
+  }
+  lines.position = target;
+}
+
+#ifdef MINIJAVA_SCAN_X86
+
+// SSE2: 16 байт за шаг
+
+inline __m128i inRange16(__m128i chunk, char lo, char hi) {
+  // Байты >= 0x80 отрицательны и в ASCII-диапазоны не попадают
+  return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(chunk, _mm_set1_epi8(hi + 1)));
+}
+
+size_t skipWhitespaceSSE2(const char* text, size_t pos, size_t end) {
+  while (pos + 16 <= end) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+    __m128i space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+
+    uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(space)) & 0xFFFF;
+    if (other != 0) return pos + __builtin_ctz(other);
+    pos += 16;
+  }
+  return skipWhitespaceScalar(text, pos, end);
+}
+
+size_t skipIdentifierCharsSSE2(const char* text, size_t pos, size_t end) {
+  while (pos + 16 <= end) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+    __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i ident = _mm_or_si128(
+        _mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(chunk, '0', '9')),
+        _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+
+    uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(ident)) & 0xFFFF;
+    if (other != 0) return pos + __builtin_ctz(other);
+    pos += 16;
+  }
+  return skipIdentifierCharsScalar(text, pos, end);
+}
+
+size_t findLineEndSSE2(const char* text, size_t pos, size_t end) {
+  while (pos + 16 <= end) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+    uint32_t newlines = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+    if (newlines != 0) return pos + __builtin_ctz(newlines);
+    pos += 16;
+  }
+  return findLineEndScalar(text, pos, end);
+}
+
+size_t findCommentDelimiterSSE2(const char* text, size_t pos, size_t end) {
+  while (pos + 16 <= end) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+    uint32_t delimiters = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('*')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/')))));
+    if (delimiters != 0) return pos + __builtin_ctz(delimiters);
+    pos += 16;
+  }
+  return findCommentDelimiterScalar(text, pos, end);
+}
+
+void advanceLinesSSE2(const char* text, size_t target, LineCursor& lines) {
+  size_t pos = lines.position;
+  while (pos + 16 <= target) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+    countLines(static_cast<uint32_t>(_mm_movemask_epi8(
+                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')))),
+               pos, lines);
+    pos += 16;
+  }
+  lines.position = pos;
+  advanceLinesScalar(text, target, lines);
+}
+
+// AVX2: 32 байта за шаг. Код собирается с target("avx2") и вызывается
+// только после проверки процессора
+
+#define MINIJAVA_AVX2 __attribute__((target("avx2")))
+
+MINIJAVA_AVX2 inline __m256i inRange32(__m256i chunk, char lo, char hi) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), chunk));
+}
+
+MINIJAVA_AVX2 size_t skipWhitespaceAVX2(const char* text, size_t pos,
+                                        size_t end) {
+  while (pos + 32 <= end) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+    __m256i space = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))));
+
+    uint32_t other = ~static_cast<uint32_t>(_mm256_movemask_epi8(space));
+    if (other != 0) return pos + __builtin_ctz(other);
+    pos += 32;
+  }
+  return skipWhitespaceSSE2(text, pos, end);
+}
+
+MINIJAVA_AVX2 size_t skipIdentifierCharsAVX2(const char* text, size_t pos,
+                                             size_t end) {
+  while (pos + 32 <= end) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+    __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    __m256i ident = _mm256_or_si256(
+        _mm256_or_si256(inRange32(lower, 'a', 'z'),
+                        inRange32(chunk, '0', '9')),
+        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_')));
+
+    uint32_t other = ~static_cast<uint32_t>(_mm256_movemask_epi8(ident));
+    if (other != 0) return pos + __builtin_ctz(other);
+    pos += 32;
+  }
+  return skipIdentifierCharsSSE2(text, pos, end);
+}
+
+MINIJAVA_AVX2 size_t findLineEndAVX2(const char* text, size_t pos,
+                                     size_t end) {
+  while (pos + 32 <= end) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+    uint32_t newlines = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))));
+    if (newlines != 0) return pos + __builtin_ctz(newlines);
+    pos += 32;
+  }
+  return findLineEndSSE2(text, pos, end);
+}
+
+MINIJAVA_AVX2 size_t findCommentDelimiterAVX2(const char* text, size_t pos,
+                                              size_t end) {
+  while (pos + 32 <= end) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+    uint32_t delimiters = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('*')),
+                        _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('/')))));
+    if (delimiters != 0) return pos + __builtin_ctz(delimiters);
+    pos += 32;
+  }
+  return findCommentDelimiterSSE2(text, pos, end);
+}
+
+MINIJAVA_AVX2 void advanceLinesAVX2(const char* text, size_t target,
+                                    LineCursor& lines) {
+  size_t pos = lines.position;
+  while (pos + 32 <= target) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+    countLines(static_cast<uint32_t>(_mm256_movemask_epi8(
+                   _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')))),
+               pos, lines);
+    pos += 32;
+  }
+  lines.position = pos;
+  advanceLinesSSE2(text, target, lines);
+}
+
+#undef MINIJAVA_AVX2
+
+#endif  // MINIJAVA_SCAN_X86
+
+struct Kernels {
+  Backend backend;
+  size_t (*skipWhitespace)(const char*, size_t, size_t);
+  size_t (*skipIdentifierChars)(const char*, size_t, size_t);
+  size_t (*findLineEnd)(const char*, size_t, size_t);
+  size_t (*findCommentDelimiter)(const char*, size_t, size_t);
+  void (*advanceLines)(const char*, size_t, LineCursor&);
+};
+
+const Kernels scalarKernels = {Backend::Scalar, skipWhitespaceScalar,
+                               skipIdentifierCharsScalar, findLineEndScalar,
+                               findCommentDelimiterScalar, advanceLinesScalar};
+
+#ifdef MINIJAVA_SCAN_X86
+const Kernels sse2Kernels = {Backend::SSE2, skipWhitespaceSSE2,
+                             skipIdentifierCharsSSE2, findLineEndSSE2,
+                             findCommentDelimiterSSE2, advanceLinesSSE2};
+
+const Kernels avx2Kernels = {Backend::AVX2, skipWhitespaceAVX2,
+                             skipIdentifierCharsAVX2, findLineEndAVX2,
+                             findCommentDelimiterAVX2, advanceLinesAVX2};
+#endif
+
+const Kernels* kernelsFor(Backend backend) {
+  switch (backend) {
+    case Backend::Scalar:
+      return &scalarKernels;
+#ifdef MINIJAVA_SCAN_X86
+    case Backend::SSE2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2") ? &sse2Kernels : nullptr;
+    case Backend::AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") ? &avx2Kernels : nullptr;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+const Kernels* detectKernels() {
+  if (const Kernels* kernels = kernelsFor(Backend::AVX2)) return kernels;
+  if (const Kernels* kernels = kernelsFor(Backend::SSE2)) return kernels;
+  return &scalarKernels;
+}
+
+// Выбранная реализация. Статическая переменная функции инициализируется
+// при первом обращении (и потокобезопасно), а не в порядке
+// инициализации глобальных объектов, так что лексер в конструкторе
+// другого глобального объекта тоже получает готовые ядра. setBackend
+// может вызываться, пока другие потоки лексируют: указатель атомарный,
+// а сами наборы ядер - константы, поэтому хватает relaxed
+std::atomic<const Kernels*>& activeSlot() {
+  static std::atomic<const Kernels*> slot(detectKernels());
+  return slot;
+}
+
+const Kernels* active() { return activeSlot().load(std::memory_order_relaxed); }
+
+}  // namespace
+
+size_t skipWhitespace(const char* text, size_t pos, size_t end) {
+  return active()->skipWhitespace(text, pos, end);
+}
+
+size_t skipIdentifierChars(const char* text, size_t pos, size_t end) {
+  return active()->skipIdentifierChars(text, pos, end);
+}
+
+size_t findLineEnd(const char* text, size_t pos, size_t end) {
+  return active()->findLineEnd(text, pos, end);
+}
+
+size_t findCommentDelimiter(const char* text, size_t pos, size_t end) {
+  return active()->findCommentDelimiter(text, pos, end);
+}
+
+void advanceLinesBlocks(const char* text, size_t target, LineCursor& lines) {
+  active()->advanceLines(text, target, lines);
+}
+
+Backend bestBackend() { return detectKernels()->backend; }
+
+Backend activeBackend() { return active()->backend; }
+
+const char* backendName(Backend backend) {
+  switch (backend) {
+    case Backend::Scalar:
+      return "scalar";
+    case Backend::SSE2:
+      return "sse2";
+    case Backend::AVX2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+bool setBackend(Backend backend) {
+  const Kernels* kernels = kernelsFor(backend);
+  if (!kernels) return false;
+  activeSlot().store(kernels, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace scan
@@ -0,0 +1,749 @@
+#include "semantic.h"
+
+#include <algorithm>
+
+#include "static_visitor.h"
+
+using Kind = ValueType::Kind;
+
+std::string typeName(const ValueType& type) {
+  std::string name;
+  switch (type.kind) {
+    case Kind::Unknown: name = "?"; break;
+    case Kind::Int: name = "int"; break;
+    case Kind::Boolean: name = "boolean"; break;
+    case Kind::Void: name = "void"; break;
+    case Kind::Class: name = std::string(type.className.str()); break;
+  }
+  if (type.array) name += "[]";
+  return name;
+}
+
+uint32_t ClassTable::add(Symbol name, ClassDeclaration* declaration, bool* duplicate) {
+  uint32_t index = static_cast<uint32_t>(classes.size());
+  classes.emplace_back();
+  classes.back().name = name;
+  classes.back().declaration = declaration;
+  bool added = byName.insert(name, index).second;
+  if (duplicate) *duplicate = !added;
+  return index;
+}
+
+VariableDeclaration* ClassTable::findField(uint32_t index, Symbol name, uint32_t* owner) const {
+  for (uint32_t current = index; current != kNoClass; current = classes[current].base) {
+    if (VariableDeclaration* const* field = classes[current].fields.find(name)) {
+      if (owner) *owner = current;
+      return *field;
+    }
+  }
+  return nullptr;
+}
+
+MethodDeclaration* ClassTable::findMethod(uint32_t index, Symbol name, uint32_t* owner) const {
+  for (uint32_t current = index; current != kNoClass; current = classes[current].base) {
+    if (MethodDeclaration* const* method = classes[current].methods.find(name)) {
+      if (owner) *owner = current;
+      return *method;
+    }
+  }
+  return nullptr;
+}
+
+bool ClassTable::isSubclass(uint32_t derived, uint32_t base) const {
+  for (uint32_t current = derived; current != kNoClass; current = classes[current].base) {
+    if (current == base) return true;
+  }
+  return false;
+}
+
+void ClassTable::clear() {
+  classes.clear();
+  byName.clear();
+}
+
+// Весь анализ: объявления классов и членов, затем тела методов.
+// Операторы и выражения обходятся через StaticVisitor; visit выражения
+// записывает тип в узел и возвращает его, visit оператора возвращает
+// Unknown. Выражение неизвестного типа (после ошибки) проверки
+// пропускают, чтобы одна ошибка не порождала цепочку следующих
+class SemanticAnalyzer::Checker : public StaticVisitor<Checker, ValueType> {
+ public:
+  explicit Checker(SemanticAnalyzer& analyzer)
+      : analyzer(analyzer), table(analyzer.table), mainName(Symbol::intern("main")) {}
+
+  void run(Program& program) {
+    declareClasses(program);
+    for (uint32_t index = 1; index < table.size(); index++) declareMembers(index);
+    for (uint32_t index = 1; index < table.size(); index++) checkOverrides(index);
+
+    enterClass(0);
+    checkMain(*program.mainClass);
+    for (uint32_t index = 1; index < table.size(); index++) {
+      enterClass(index);
+      for (Declaration* declaration : table[index].declaration->declarations) {
+        if (declaration->kind == NodeKind::MethodDeclaration) {
+          checkMethod(static_cast<MethodDeclaration&>(*declaration));
+        }
+      }
+    }
+  }
+
+  // Операторы
+
+  ValueType visit(AssertStatement& node) {
+    expect(dispatch(*node.condition), Kind::Boolean, "Условие assert");
+    return ValueType();
+  }
+
+  ValueType visit(LocalVarDeclStatement& node) {
+    declareLocal(*node.declaration, VariableScope::Local);
+    return ValueType();
+  }
+
+  ValueType visit(BlockStatement& node) {
+    size_t mark = analyzer.localStack.size();
+    for (Statement* statement : node.statements) dispatch(*statement);
+    leaveScope(mark);
+    return ValueType();
+  }
+
+  ValueType visit(IfStatement& node) {
+    expect(dispatch(*node.condition), Kind::Boolean, "Условие if");
+    nested(node.thenStatement);
+    nested(node.elseStatement);
+    return ValueType();
+  }
+
+  ValueType visit(WhileStatement& node) {
+    expect(dispatch(*node.condition), Kind::Boolean, "Условие while");
+    nested(node.body);
+    return ValueType();
+  }
+
+  ValueType visit(PrintStatement& node) {
+    expect(dispatch(*node.expression), Kind::Int, "Аргумент System.out.println");
+    return ValueType();
+  }
+
+  ValueType visit(AssignStatement& node) {
+    ValueType target = dispatch(*node.lvalue);
+    ValueType value = dispatch(*node.expression);
+    if (!assignable(target, value)) {
+      report("Нельзя присвоить значение типа " + typeName(value) +
+             " переменной типа " + typeName(target));
+    }
+    return ValueType();
+  }
+
+  ValueType visit(ReturnStatement& node) {
+    ValueType value = dispatch(*node.expression);
+    if (returnType.is(Kind::Void)) {
+      report("Метод " + std::string(methodName.str()) + " не возвращает значения");
+    } else if (!assignable(returnType, value)) {
+      report("Метод " + std::string(methodName.str()) + " возвращает " +
+             typeName(returnType) + ", а не " + typeName(value));
+    }
+    return ValueType();
+  }
+
+  ValueType visit(MethodInvocationStatement& node) {
+    dispatch(*node.invocation);
+    return ValueType();
+  }
+
+  ValueType visit(ErrorStatement&) { return ValueType(); }
+
+  // Выражения
+
+  // Цепочка a + b + ... + z - это левое поддерево глубиной в число
+  // операторов, и её длину парсер не ограничивает. Левый край цепочки
+  // собирается в стек, и операции проверяются снизу вверх циклом;
+  // рекурсия остаётся только для правых операндов
+  ValueType visit(BinaryOperation& node) {
+    size_t mark = analyzer.spine.size();
+    Expression* leftmost = &node;
+    while (leftmost->kind == NodeKind::BinaryOperation) {
+      analyzer.spine.push_back(leftmost);
+      leftmost = static_cast<BinaryOperation*>(leftmost)->left;
+    }
+
+    ValueType left = dispatch(*leftmost);
+    while (analyzer.spine.size() > mark) {
+      auto& operation = static_cast<BinaryOperation&>(*analyzer.spine.back());
+      analyzer.spine.pop_back();
+      left = binary(operation, left, dispatch(*operation.right));
+    }
+    return left;
+  }
+
+  // Цепочка !!...!x проверяется так же: операнд, затем операции
+  // изнутри наружу
+  ValueType visit(UnaryOperation& node) {
+    size_t mark = analyzer.spine.size();
+    Expression* operand = &node;
+    while (operand->kind == NodeKind::UnaryOperation) {
+      analyzer.spine.push_back(operand);
+      operand = static_cast<UnaryOperation*>(operand)->expression;
+    }
+
+    ValueType value = dispatch(*operand);
+    while (analyzer.spine.size() > mark) {
+      value = unary(static_cast<UnaryOperation&>(*analyzer.spine.back()), value);
+      analyzer.spine.pop_back();
+    }
+    return value;
+  }
+
+  ValueType visit(ArrayIndexing& node) {
+    ValueType array = dispatch(*node.array);
+    if (!node.index) return set(node, length(array));
+    expect(dispatch(*node.index), Kind::Int, "Индекс массива");
+    return set(node, element(array));
+  }
+
+  ValueType visit(ArrayLength& node) { return set(node, length(dispatch(*node.array))); }
+
+  // Проверки вызова вынесены из visit: рекурсия по цепочке a.f().g()...
+  // идёт через dispatch, и кадр на каждый уровень остаётся маленьким
+  ValueType visit(MethodInvocation& node) {
+    ValueType object = dispatch(*node.object);
+    for (Expression* argument : node.arguments) dispatch(*argument);
+    return invocation(node, object);
+  }
+
+  ValueType visit(FieldAccess& node) {
+    ValueType object = dispatch(*node.object);
+    node.declaration = nullptr;
+    uint32_t index = classOf(object, "Обращение к полю ", node.fieldName, "");
+    if (index == ClassTable::kNoClass) return set(node, ValueType());
+    node.declaration = field(index, node.fieldName);
+    return set(node, variableType(node.declaration));
+  }
+
+  ValueType visit(NewArray& node) {
+    ValueType element = resolveType(*node.elementType, false);
+    expect(dispatch(*node.size), Kind::Int, "Размер массива");
+    if (!element.known()) return set(node, ValueType());
+    element.array = true;
+    return set(node, element);
+  }
+
+  ValueType visit(NewObject& node) {
+    uint32_t index = table.find(node.className);
+    if (index == ClassTable::kNoClass) {
+      node.declaration = nullptr;
+      report("Неизвестный класс " + std::string(node.className.str()));
+      return set(node, ValueType());
+    }
+    node.declaration = table[index].declaration;
+    return set(node, ValueType::ofClass(node.className));
+  }
+
+  ValueType visit(IntegerLiteral& node) { return set(node, ValueType::of(Kind::Int)); }
+  ValueType visit(BooleanLiteral& node) { return set(node, ValueType::of(Kind::Boolean)); }
+
+  ValueType visit(ThisExpression& node) {
+    if (isStatic) {
+      report("this недоступен в статическом методе main");
+      return set(node, ValueType());
+    }
+    return set(node, ValueType::ofClass(className));
+  }
+
+  ValueType visit(IdentifierExpression& node) {
+    node.declaration = variable(node.name);
+    return set(node, variableType(node.declaration));
+  }
+
+  ValueType visit(ErrorExpression& node) { return set(node, ValueType()); }
+
+  ValueType visit(IdentifierLValue& node) {
+    node.declaration = variable(node.name);
+    return set(node, variableType(node.declaration));
+  }
+
+  ValueType visit(ArrayAccess& node) {
+    node.declaration = variable(node.arrayName);
+    ValueType array = variableType(node.declaration);
+    expect(dispatch(*node.index), Kind::Int, "Индекс массива");
+    return set(node, element(array));
+  }
+
+  ValueType visit(SimpleFieldInvocation& node) {
+    node.declaration = thisField(node.fieldName);
+    return set(node, variableType(node.declaration));
+  }
+
+  ValueType visit(FieldArrayInvocation& node) {
+    node.declaration = thisField(node.fieldName);
+    ValueType array = variableType(node.declaration);
+    expect(dispatch(*node.index), Kind::Int, "Индекс массива");
+    return set(node, element(array));
+  }
+
+  // Классы, типы и объявления обходятся не через dispatch, а явно
+  // (run, declareMembers, resolveType)
+  template <typename Node>
+  ValueType visit(Node&) {
+    return ValueType();
+  }
+
+ private:
+  SemanticAnalyzer& analyzer;
+  ClassTable& table;
+  Symbol mainName;
+
+  // Контекст: класс и метод, тела которых проверяются
+  uint32_t currentClass = 0;
+  Symbol className;
+  Symbol methodName;
+  ValueType returnType;
+  bool isStatic = false;
+
+  void report(std::string message) {
+    std::string text = "Ошибка в классе " + std::string(className.str());
+    if (!methodName.empty()) text += ", метод " + std::string(methodName.str());
+    analyzer.errors.push_back(Diagnostic{className, methodName, text + ": " + message});
+  }
+
+  void enterClass(uint32_t index) {
+    currentClass = index;
+    className = table[index].name;
+    methodName = Symbol();
+    isStatic = false;
+  }
+
+  // Объявления
+
+  void declareClasses(Program& program) {
+    table.add(program.mainClass->className, nullptr);
+    enterClass(0);
+    for (ClassDeclaration* declaration : program.classes) {
+      bool duplicate = false;
+      className = declaration->className;
+      table.add(className, declaration, &duplicate);
+      declaration->baseClass = nullptr;
+      if (duplicate) report("Класс " + std::string(className.str()) + " уже объявлен");
+    }
+
+    for (uint32_t index = 1; index < table.size(); index++) {
+      ClassDeclaration* declaration = table[index].declaration;
+      if (declaration->baseClassName.empty()) continue;
+      enterClass(index);
+      uint32_t base = table.find(declaration->baseClassName);
+      if (base == ClassTable::kNoClass) {
+        report("Неизвестный базовый класс " + std::string(declaration->baseClassName.str()));
+        continue;
+      }
+      table[index].base = base;
+      declaration->baseClass = table[base].declaration;
+    }
+    breakCycles();
+  }
+
+  // Цикл наследования разрывается на классе, который его замыкает:
+  // дальше поиск членов по цепочке base всегда завершается
+  void breakCycles() {
+    enum : uint8_t { kNew, kOnPath, kDone };
+    std::vector<uint8_t> state(table.size(), kNew);
+    for (uint32_t start = 0; start < table.size(); start++) {
+      uint32_t current = start;
+      while (current != ClassTable::kNoClass && state[current] == kNew) {
+        state[current] = kOnPath;
+        uint32_t base = table[current].base;
+        if (base != ClassTable::kNoClass && state[base] == kOnPath) {
+          enterClass(current);
+          report("Циклическое наследование через класс " + std::string(table[base].name.str()));
+          table[current].base = ClassTable::kNoClass;
+          table[current].declaration->baseClass = nullptr;
+          break;
+        }
+        current = base;
+      }
+      for (current = start; current != ClassTable::kNoClass && state[current] == kOnPath;
+           current = table[current].base) {
+        state[current] = kDone;
+      }
+    }
+  }
+
+  void declareMembers(uint32_t index) {
+    enterClass(index);
+    ClassTable::ClassInfo& info = table[index];
+    for (Declaration* declaration : info.declaration->declarations) {
+      if (declaration->kind == NodeKind::VariableDeclaration) {
+        auto& field = static_cast<VariableDeclaration&>(*declaration);
+        field.scope = VariableScope::Field;
+        resolveType(*field.type, false);
+        if (!info.fields.insert(field.name, &field).second) {
+          report("Поле " + std::string(field.name.str()) + " уже объявлено");
+        }
+      } else {
+        auto& method = static_cast<MethodDeclaration&>(*declaration);
+        methodName = method.name;
+        resolveType(*method.returnType, true);
+        for (VariableDeclaration* parameter : method.parameters) {
+          parameter->scope = VariableScope::Parameter;
+          resolveType(*parameter->type, false);
+        }
+        if (!info.methods.insert(method.name, &method).second) {
+          report("Метод уже объявлен (перегрузка методов не поддерживается)");
+        }
+        methodName = Symbol();
+      }
+    }
+  }
+
+  // Метод наследника с именем метода предка должен иметь те же
+  // параметры и тот же или более узкий тип результата
+  void checkOverrides(uint32_t index) {
+    ClassTable::ClassInfo& info = table[index];
+    if (info.base == ClassTable::kNoClass) return;
+    enterClass(index);
+    for (Declaration* declaration : info.declaration->declarations) {
+      if (declaration->kind != NodeKind::MethodDeclaration) continue;
+      auto& method = static_cast<MethodDeclaration&>(*declaration);
+      if (*info.methods.find(method.name) != &method) continue;  // повторное объявление
+      uint32_t owner = ClassTable::kNoClass;
+      MethodDeclaration* overridden = table.findMethod(info.base, method.name, &owner);
+      if (!overridden) continue;
+
+      bool same = overridden->parameters.size() == method.parameters.size() &&
+                  returnsSubtype(declaredType(method.returnType), declaredType(overridden->returnType));
+      for (size_t i = 0; same && i < method.parameters.size(); i++) {
+        same = declaredType(method.parameters[i]->type) == declaredType(overridden->parameters[i]->type);
+      }
+      if (!same) {
+        methodName = method.name;
+        report("Сигнатура отличается от метода " + std::string(method.name.str()) +
+               " класса " + std::string(table[owner].name.str()));
+        methodName = Symbol();
+      }
+    }
+  }
+
+  bool returnsSubtype(const ValueType& derived, const ValueType& base) {
+    if (derived == base) return true;
+    return derived.isObject() && base.isObject() && subclass(derived.className, base.className);
+  }
+
+  // Тип из объявления с проверкой: неизвестный класс и void не на месте
+  // типа результата - ошибки. Аннотирует IdentifierType
+  ValueType resolveType(Type& type, bool allowVoid) {
+    switch (type.kind) {
+      case NodeKind::IntType: return ValueType::of(Kind::Int);
+      case NodeKind::BooleanType: return ValueType::of(Kind::Boolean);
+      case NodeKind::VoidType:
+        if (allowVoid) return ValueType::of(Kind::Void);
+        report("Тип void допустим только как тип результата метода");
+        return ValueType();
+      case NodeKind::IdentifierType: {
+        auto& identifier = static_cast<IdentifierType&>(type);
+        uint32_t index = table.find(identifier.typeName);
+        if (index == ClassTable::kNoClass) {
+          identifier.declaration = nullptr;
+          report("Неизвестный класс " + std::string(identifier.typeName.str()));
+          return ValueType();
+        }
+        identifier.declaration = table[index].declaration;
+        return ValueType::ofClass(identifier.typeName);
+      }
+      case NodeKind::ArrayType: {
+        ValueType element = resolveType(*static_cast<ArrayType&>(type).elementType, false);
+        if (element.known()) element.array = true;
+        return element;
+      }
+      default:
+        return ValueType();
+    }
+  }
+
+  // Тип из уже проверенного объявления, без сообщений
+  ValueType declaredType(Type* type) const {
+    switch (type->kind) {
+      case NodeKind::IntType: return ValueType::of(Kind::Int);
+      case NodeKind::BooleanType: return ValueType::of(Kind::Boolean);
+      case NodeKind::VoidType: return ValueType::of(Kind::Void);
+      case NodeKind::IdentifierType: {
+        Symbol name = static_cast<IdentifierType*>(type)->typeName;
+        if (table.find(name) == ClassTable::kNoClass) return ValueType();
+        return ValueType::ofClass(name);
+      }
+      case NodeKind::ArrayType: {
+        ValueType element = declaredType(static_cast<ArrayType*>(type)->elementType);
+        if (element.is(Kind::Void)) return ValueType();
+        if (element.known()) element.array = true;
+        return element;
+      }
+      default:
+        return ValueType();
+    }
+  }
+
+  // Тела методов
+
+  void checkMain(MainClass& main) {
+    methodName = mainName;
+    returnType = ValueType::of(Kind::Void);
+    isStatic = true;
+    for (Statement* statement : main.statements) dispatch(*statement);
+    leaveScope(0);
+    isStatic = false;
+    methodName = Symbol();
+  }
+
+  void checkMethod(MethodDeclaration& method) {
+    methodName = method.name;
+    returnType = declaredType(method.returnType);
+    for (VariableDeclaration* parameter : method.parameters) {
+      declareParameter(*parameter);
+    }
+    for (Statement* statement : method.statements) dispatch(*statement);
+    leaveScope(0);
+    methodName = Symbol();
+  }
+
+  // Ветка if или тело while - отдельная область видимости, даже если
+  // это не блок
+  void nested(Statement* statement) {
+    if (!statement) return;
+    size_t mark = analyzer.localStack.size();
+    dispatch(*statement);
+    leaveScope(mark);
+  }
+
+  void declareParameter(VariableDeclaration& parameter) {
+    // Тип параметра уже проверен в declareMembers
+    bind(parameter, "параметра ");
+  }
+
+  void declareLocal(VariableDeclaration& local, VariableScope scope) {
+    local.scope = scope;
+    resolveType(*local.type, false);
+    bind(local, "переменной ");
+  }
+
+  void bind(VariableDeclaration& variable, const char* what) {
+    std::vector<VariableDeclaration*>& locals = analyzer.locals;
+    uint32_t id = variable.name.id();
+    if (id >= locals.size()) locals.resize(std::max<size_t>(id + 1, Symbol::tableSize()), nullptr);
+    if (locals[id]) {
+      report(std::string("Повторное объявление ") + what + std::string(variable.name.str()));
+      return;
+    }
+    locals[id] = &variable;
+    analyzer.localStack.push_back(variable.name);
+  }
+
+  void leaveScope(size_t mark) {
+    std::vector<Symbol>& stack = analyzer.localStack;
+    while (stack.size() > mark) {
+      analyzer.locals[stack.back().id()] = nullptr;
+      stack.pop_back();
+    }
+  }
+
+  VariableDeclaration* local(Symbol name) const {
+    uint32_t id = name.id();
+    return id < analyzer.locals.size() ? analyzer.locals[id] : nullptr;
+  }
+
+  // Имя в выражении: локальная переменная или параметр, затем поле
+  VariableDeclaration* variable(Symbol name) {
+    if (VariableDeclaration* found = local(name)) return found;
+    if (!isStatic) {
+      uint32_t owner = ClassTable::kNoClass;
+      if (VariableDeclaration* found = table.findField(currentClass, name, &owner)) {
+        checkAccess(name, owner);
+        return found;
+      }
+    }
+    report("Неизвестная переменная " + std::string(name.str()));
+    return nullptr;
+  }
+
+  VariableDeclaration* thisField(Symbol name) {
+    if (isStatic) {
+      report("this недоступен в статическом методе main");
+      return nullptr;
+    }
+    return field(currentClass, name);
+  }
+
+  VariableDeclaration* field(uint32_t index, Symbol name) {
+    uint32_t owner = ClassTable::kNoClass;
+    VariableDeclaration* found = table.findField(index, name, &owner);
+    if (!found) {
+      report("У класса " + std::string(table[index].name.str()) + " нет поля " +
+             std::string(name.str()));
+      return nullptr;
+    }
+    checkAccess(name, owner);
+    return found;
+  }
+
+  // Поля закрыты: доступны только в методах своего класса
+  void checkAccess(Symbol name, uint32_t owner) {
+    if (owner != currentClass) {
+      report("Поле " + std::string(name.str()) + " класса " +
+             std::string(table[owner].name.str()) + " закрыто");
+    }
+  }
+
+  ValueType variableType(VariableDeclaration* declaration) const {
+    return declaration ? declaredType(declaration->type) : ValueType();
+  }
+
+  // Типы выражений
+
+  static ValueType set(Expression& node, ValueType type) {
+    node.type = type;
+    return type;
+  }
+
+  void expect(const ValueType& actual, Kind kind, const char* what) {
+    if (actual.known() && !actual.is(kind)) {
+      report(std::string(what) + ": ожидался тип " + typeName(ValueType::of(kind)) +
+             ", получен " + typeName(actual));
+    }
+  }
+
+  void operand(const ValueType& actual, Kind kind, BinaryOperator op) {
+    if (actual.known() && !actual.is(kind)) {
+      report(std::string("Операнд оператора ") + operatorText(op) + ": ожидался тип " +
+             typeName(ValueType::of(kind)) + ", получен " + typeName(actual));
+    }
+  }
+
+  ValueType element(const ValueType& array) {
+    if (!array.known()) return ValueType();
+    if (!array.array) {
+      report("Индексируется не массив, а значение типа " + typeName(array));
+      return ValueType();
+    }
+    return array.element();
+  }
+
+  ValueType length(const ValueType& array) {
+    if (array.known() && !array.array) {
+      report("length есть только у массивов, а не у значения типа " + typeName(array));
+    }
+    return ValueType::of(Kind::Int);
+  }
+
+  // Класс объекта, у которого вызывается метод или берётся поле.
+  // Сообщение собирается из частей только при ошибке
+  uint32_t classOf(const ValueType& object, const char* prefix, Symbol member, const char* suffix) {
+    if (!object.known()) return ClassTable::kNoClass;
+    if (!object.isObject()) {
+      report(prefix + std::string(member.str()) + suffix + " у значения типа " + typeName(object));
+      return ClassTable::kNoClass;
+    }
+    return table.find(object.className);
+  }
+
+  bool subclass(Symbol derived, Symbol base) const {
+    uint32_t from = table.find(derived);
+    uint32_t to = table.find(base);
+    return from != ClassTable::kNoClass && to != ClassTable::kNoClass && table.isSubclass(from, to);
+  }
+
+  // Тип вызова по уже проверенным объекту и аргументам
+  ValueType invocation(MethodInvocation& node, const ValueType& object) {
+    node.declaration = nullptr;
+
+    uint32_t index = classOf(object, "Метод ", node.methodName, " вызывается");
+    if (index == ClassTable::kNoClass) return set(node, ValueType());
+    MethodDeclaration* method = table.findMethod(index, node.methodName);
+    if (!method) {
+      report("У класса " + std::string(object.className.str()) + " нет метода " +
+             std::string(node.methodName.str()));
+      return set(node, ValueType());
+    }
+    node.declaration = method;
+
+    if (method->parameters.size() != node.arguments.size()) {
+      report("Метод " + std::string(node.methodName.str()) + " ожидает " +
+             std::to_string(method->parameters.size()) + " аргумент(ов), передано " +
+             std::to_string(node.arguments.size()));
+    } else {
+      for (size_t i = 0; i < node.arguments.size(); i++) {
+        ValueType expected = declaredType(method->parameters[i]->type);
+        ValueType actual = node.arguments[i]->type;
+        if (!assignable(expected, actual)) {
+          report("Аргумент " + std::to_string(i + 1) + " метода " +
+                 std::string(node.methodName.str()) + ": ожидался " + typeName(expected) +
+                 ", получен " + typeName(actual));
+        }
+      }
+    }
+    return set(node, declaredType(method->returnType));
+  }
+
+  // Тип бинарной операции по уже проверенным операндам
+  ValueType binary(BinaryOperation& node, const ValueType& left, const ValueType& right) {
+    switch (node.op) {
+      case BinaryOperator::AND:
+      case BinaryOperator::OR:
+        operand(left, Kind::Boolean, node.op);
+        operand(right, Kind::Boolean, node.op);
+        return set(node, ValueType::of(Kind::Boolean));
+      case BinaryOperator::LESS:
+      case BinaryOperator::GREATER:
+      case BinaryOperator::LESS_EQUAL:
+      case BinaryOperator::GREATER_EQUAL:
+        operand(left, Kind::Int, node.op);
+        operand(right, Kind::Int, node.op);
+        return set(node, ValueType::of(Kind::Boolean));
+      case BinaryOperator::EQUAL:
+      case BinaryOperator::NOT_EQUAL:
+        if (left.is(Kind::Void) || right.is(Kind::Void) ||
+            (!assignable(left, right) && !assignable(right, left))) {
+          report("Нельзя сравнить " + typeName(left) + " и " + typeName(right) +
+                 " оператором " + operatorText(node.op));
+        }
+        return set(node, ValueType::of(Kind::Boolean));
+      case BinaryOperator::PLUS:
+      case BinaryOperator::MINUS:
+      case BinaryOperator::MULTIPLY:
+      case BinaryOperator::DIVIDE:
+      case BinaryOperator::MODULO:
+        break;
+    }
+    operand(left, Kind::Int, node.op);
+    operand(right, Kind::Int, node.op);
+    return set(node, ValueType::of(Kind::Int));
+  }
+
+  // Тип унарной операции по уже проверенному операнду
+  ValueType unary(UnaryOperation& node, const ValueType& value) {
+    if (value.known() && !value.is(Kind::Boolean)) {
+      report(std::string("Операнд оператора ") + operatorText(node.op) +
+             ": ожидался тип boolean, получен " + typeName(value));
+    }
+    return set(node, ValueType::of(Kind::Boolean));
+  }
+
+  // Значение source можно присвоить переменной типа target; неизвестные
+  // типы совместимы со всем. Массивы совместимы только с массивами того
+  // же типа элементов, объекты - с объектами базовых классов
+  bool assignable(const ValueType& target, const ValueType& source) const {
+    if (!target.known() || !source.known()) return true;
+    if (target.is(Kind::Void) || source.is(Kind::Void)) return false;
+    if (target == source) return true;
+    return target.isObject() && source.isObject() && subclass(source.className, target.className);
+  }
+};
+
+SemanticAnalyzer& SemanticAnalyzer::forThread() {
+  thread_local SemanticAnalyzer analyzer;
+  return analyzer;
+}
+
+bool SemanticAnalyzer::analyze(Program& program) {
+  table.clear();
+  errors.clear();
+  localStack.clear();
+  Checker(*this).run(program);
+  return errors.empty();
+}
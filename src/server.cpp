@@ -0,0 +1,424 @@
+#include "server.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+
+#include "parallel.h"
+#include "source_buffer.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'M', 'J', 'R', 'Q'};
+constexpr uint32_t kProtocolVersion = 1;
+
+// Как часто свободный поток проверяет остановку и простой
+constexpr int kPollMillis = 100;
+
+// Клиент, который перестал отвечать, не держит поток дольше этого
+constexpr int kClientTimeoutSeconds = 30;
+
+// Предел длины пути: защита от мусора вместо заголовка
+constexpr uint32_t kMaxPathLength = 1 << 16;
+
+// Текст запроса читается частями такого размера
+constexpr size_t kReadChunk = 1 << 20;
+
+constexpr uint32_t kInlineSource = 1;
+constexpr uint32_t kParallel = 2;
+constexpr uint32_t kEmitBinary = 4;
+
+// Заголовок запроса; за ним путь, путь .ast и (для kInlineSource) текст
+struct RequestHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t type;
+  uint32_t flags;
+  uint32_t jobs;
+  uint32_t pathLength;
+  uint32_t outputLength;
+  uint32_t format;  // AstFormat
+  uint64_t sourceLength;
+};
+
+// Ответ - последовательность кадров: вывод, ошибки и последним - код
+// завершения (4 байта)
+enum Channel : uint32_t { kOut = 1, kErr = 2, kExit = 3 };
+
+struct Frame {
+  uint32_t channel;
+  uint32_t length;
+};
+
+std::runtime_error systemError(const std::string& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+bool readAll(int fd, void* data, size_t size) {
+  char* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t result = recv(fd, bytes, size, 0);
+    if (result < 0 && errno == EINTR) continue;
+    if (result <= 0) return false;
+    bytes += result;
+    size -= static_cast<size_t>(result);
+  }
+  return true;
+}
+
+// Память под текст растёт по мере прихода байтов, а не выделяется
+// сразу по длине из заголовка
+bool readString(int fd, std::string& out, uint64_t size) {
+  out.clear();
+  while (out.size() < size) {
+    size_t used = out.size();
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(kReadChunk, size - used));
+    out.resize(used + chunk);
+    if (!readAll(fd, &out[used], chunk)) return false;
+  }
+  return true;
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    // MSG_NOSIGNAL: ушедший клиент даёт ошибку, а не SIGPIPE
+    ssize_t result = ::send(fd, bytes, size, MSG_NOSIGNAL);
+    if (result < 0 && errno == EINTR) continue;
+    if (result <= 0) return false;
+    bytes += result;
+    size -= static_cast<size_t>(result);
+  }
+  return true;
+}
+
+bool writeFrame(int fd, uint32_t channel, const char* data, size_t size) {
+  Frame frame{channel, static_cast<uint32_t>(size)};
+  return writeAll(fd, &frame, sizeof(frame)) && writeAll(fd, data, size);
+}
+
+// Отказ в запросе: сообщение и код завершения 2
+void reject(int fd, const std::string& message) {
+  std::string text = message + "\n";
+  int32_t status = 2;
+  writeFrame(fd, kErr, text.data(), text.size());
+  writeFrame(fd, kExit, reinterpret_cast<const char*>(&status), sizeof(status));
+}
+
+// Поток вывода в кадры одного канала. Кадр отправляется, когда буфер
+// полон, и в finish(); std::endl (sync) кадр не отправляет, иначе
+// построчный вывод ASTPrinter давал бы кадр на строку
+class FrameBuffer : public std::streambuf {
+ public:
+  FrameBuffer(int fd, uint32_t channel) : fd(fd), channel(channel) {
+    setp(buffer, buffer + sizeof(buffer));
+  }
+
+  bool finish() { return send(); }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!send()) return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  int sync() override { return 0; }
+
+ private:
+  int fd;
+  uint32_t channel;
+  bool failed = false;
+  char buffer[64 * 1024];
+
+  bool send() {
+    size_t size = static_cast<size_t>(pptr() - pbase());
+    if (size > 0 && !failed) failed = !writeFrame(fd, channel, pbase(), size);
+    setp(buffer, buffer + sizeof(buffer));
+    return !failed;
+  }
+};
+
+sockaddr_un socketAddress(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Слишком длинный путь к сокету: " + path);
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+int connectTo(const std::string& path) {
+  sockaddr_un address = socketAddress(path);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) throw systemError("Не удалось создать сокет");
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return -1;
+  }
+  return fd;
+}
+
+int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+CompileServer::CompileServer(Options options) : options(std::move(options)) { touch(); }
+
+CompileServer::~CompileServer() {
+  if (listenFd >= 0) {
+    close(listenFd);
+    unlink(options.socketPath.c_str());
+  }
+}
+
+void CompileServer::touch() { lastActivity = now(); }
+
+void CompileServer::listen() {
+  sockaddr_un address = socketAddress(options.socketPath);
+
+  // Файл сокета без сервера за ним остаётся после падения: его можно
+  // удалить, а живой сервер отвечает на соединение
+  struct stat info;
+  if (lstat(options.socketPath.c_str(), &info) == 0) {
+    if (!S_ISSOCK(info.st_mode)) {
+      throw std::runtime_error("Путь занят файлом, а не сокетом: " + options.socketPath);
+    }
+    int probe = connectTo(options.socketPath);
+    if (probe >= 0) {
+      close(probe);
+      throw std::runtime_error("Сервер уже запущен: " + options.socketPath);
+    }
+    unlink(options.socketPath.c_str());
+  }
+
+  // Неблокирующий сокет: соединение принимает один из ждущих потоков,
+  // остальные получают EAGAIN и ждут дальше
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (fd < 0) throw systemError("Не удалось создать сокет");
+  // Права выставляются до listen: до него соединиться нельзя, и чужой
+  // пользователь не успеет подключиться к сокету с правами по umask
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      chmod(options.socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+      ::listen(fd, SOMAXCONN) != 0) {
+    std::runtime_error error = systemError("Не удалось открыть сокет " + options.socketPath);
+    close(fd);
+    throw error;
+  }
+  listenFd = fd;
+}
+
+void CompileServer::run() {
+  if (listenFd < 0) listen();
+  touch();
+
+  runParallel(resolveThreads(options.threads), [this](size_t) {
+    while (!stopping) {
+      pollfd ready{listenFd, POLLIN, 0};
+      if (poll(&ready, 1, kPollMillis) > 0) {
+        int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client >= 0) {
+          active++;
+          serve(client);
+          close(client);
+          touch();
+          active--;
+          continue;
+        }
+      }
+      if (options.idleSeconds > 0 && active == 0 &&
+          now() - lastActivity > static_cast<int64_t>(options.idleSeconds * 1e9)) {
+        stopping = true;
+      }
+    }
+  });
+
+  // Новые клиенты сразу получают ошибку соединения, а не ждут в очереди
+  close(listenFd);
+  unlink(options.socketPath.c_str());
+  listenFd = -1;
+}
+
+void CompileServer::serve(int fd) {
+  int64_t start = now();
+  timeval timeout{kClientTimeoutSeconds, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  // Сервер читает файлы и пишет .ast с правами своего пользователя,
+  // поэтому запросы других пользователей не обслуживаются
+  ucred peer{};
+  socklen_t peerLength = sizeof(peer);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &peerLength) != 0 || peer.uid != geteuid()) {
+    reject(fd, "Сервер компиляции принимает запросы только от своего пользователя");
+    return;
+  }
+
+  // Нехватка памяти на одном запросе - ошибка этого клиента, а не
+  // исключение в потоке пула, которое завершило бы сервер
+  try {
+    serveRequest(fd, start);
+  } catch (const std::bad_alloc&) {
+    reject(fd, "Недостаточно памяти для обработки запроса");
+  }
+}
+
+void CompileServer::serveRequest(int fd, int64_t start) {
+  RequestHeader header;
+  if (!readAll(fd, &header, sizeof(header))) return;
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kProtocolVersion || header.pathLength > kMaxPathLength ||
+      header.outputLength > kMaxPathLength || header.sourceLength > kMaxSourceLength ||
+      header.format > static_cast<uint32_t>(AstFormat::Sexpr)) {
+    reject(fd, "Неверный запрос к серверу компиляции");
+    return;
+  }
+
+  Request request;
+  request.type = static_cast<RequestType>(header.type);
+  request.path.resize(header.pathLength);
+  request.options.output.resize(header.outputLength);
+  request.inlineSource = header.flags & kInlineSource;
+  request.options.parallel = header.flags & kParallel;
+  request.options.emitBinary = header.flags & kEmitBinary;
+  request.options.jobs = header.jobs;
+  request.options.format = static_cast<AstFormat>(header.format);
+  if (!readAll(fd, &request.path[0], request.path.size()) ||
+      !readAll(fd, &request.options.output[0], request.options.output.size()) ||
+      (request.inlineSource && !readString(fd, request.source, header.sourceLength))) {
+    return;
+  }
+
+  int32_t status = 0;
+  FrameBuffer outBuffer(fd, kOut);
+  FrameBuffer errBuffer(fd, kErr);
+  std::ostream out(&outBuffer);
+  std::ostream err(&errBuffer);
+  switch (request.type) {
+    case RequestType::Compile: {
+      CompileDriver driver(request.options, options.cache);
+      if (request.inlineSource) {
+        status = driver.compile(request.path, SourceBuffer::fromString(std::move(request.source)),
+                                out, err);
+      } else {
+        status = driver.compile(request.path, out, err);
+      }
+      break;
+    }
+    case RequestType::Stats:
+      out << latencyReport();
+      break;
+    case RequestType::Shutdown:
+      stopping = true;
+      break;
+    default:
+      reject(fd, "Неизвестный тип запроса");
+      return;
+  }
+  errBuffer.finish();
+  outBuffer.finish();
+
+  // Бакет i - задержки от 2^i до 2^(i+1) мкс. Запрос учитывается до
+  // кода завершения, чтобы следующий запрос клиента его уже видел
+  uint64_t micros = static_cast<uint64_t>(now() - start) / 1000;
+  size_t bucket = 0;
+  while (bucket + 1 < kBuckets && (micros >> (bucket + 1)) != 0) bucket++;
+  latency[bucket]++;
+  writeFrame(fd, kExit, reinterpret_cast<const char*>(&status), sizeof(status));
+}
+
+std::string CompileServer::latencyReport() const {
+  uint64_t counts[kBuckets];
+  uint64_t total = 0;
+  for (size_t i = 0; i < kBuckets; i++) {
+    counts[i] = latency[i];
+    total += counts[i];
+  }
+
+  std::ostringstream report;
+  report << "Запросов: " << total << std::endl;
+  if (total == 0) return report.str();
+
+  // Процентили - по верхней границе бакета
+  auto percentile = [&](double fraction) {
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+      seen += counts[i];
+      if (seen >= fraction * total) return uint64_t(2) << i;
+    }
+    return uint64_t(2) << (kBuckets - 1);
+  };
+  report << "Задержка: p50 < " << percentile(0.5) << " мкс, p90 < " << percentile(0.9)
+         << " мкс, p99 < " << percentile(0.99) << " мкс" << std::endl;
+  for (size_t i = 0; i < kBuckets; i++) {
+    if (counts[i] == 0) continue;
+    report << "  " << (i == 0 ? 0 : uint64_t(1) << i) << "-" << (uint64_t(2) << i)
+           << " мкс: " << counts[i] << std::endl;
+  }
+  return report.str();
+}
+
+int CompileServer::send(const std::string& socketPath, const Request& request,
+                        std::ostream& out, std::ostream& err) {
+  if (request.inlineSource && request.source.size() > kMaxSourceLength) {
+    throw std::runtime_error("Текст слишком велик для сервера компиляции: " + request.path);
+  }
+  int fd = connectTo(socketPath);
+  if (fd < 0) throw systemError("Не удалось подключиться к серверу " + socketPath);
+
+  RequestHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kProtocolVersion;
+  header.type = static_cast<uint32_t>(request.type);
+  header.flags = (request.inlineSource ? kInlineSource : 0) |
+                 (request.options.parallel ? kParallel : 0) |
+                 (request.options.emitBinary ? kEmitBinary : 0);
+  header.jobs = request.options.jobs;
+  header.format = static_cast<uint32_t>(request.options.format);
+  header.pathLength = static_cast<uint32_t>(request.path.size());
+  header.outputLength = static_cast<uint32_t>(request.options.output.size());
+  header.sourceLength = request.inlineSource ? request.source.size() : 0;
+
+  bool sent = writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, request.path.data(), request.path.size()) &&
+              writeAll(fd, request.options.output.data(), request.options.output.size()) &&
+              (!request.inlineSource || writeAll(fd, request.source.data(), request.source.size()));
+
+  std::string data;
+  Frame frame;
+  while (sent && readAll(fd, &frame, sizeof(frame))) {
+    data.resize(frame.length);
+    if (!readAll(fd, &data[0], data.size())) break;
+    if (frame.channel == kExit && data.size() == sizeof(int32_t)) {
+      int32_t status;
+      std::memcpy(&status, data.data(), sizeof(status));
+      close(fd);
+      return status;
+    }
+    (frame.channel == kErr ? err : out).write(data.data(), static_cast<std::streamsize>(data.size()));
+  }
+  close(fd);
+  throw std::runtime_error("Сервер компиляции закрыл соединение, не завершив ответ");
+}
@@ -0,0 +1,133 @@
+#include "source_buffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// Дескриптор, который закрывается при выходе из области видимости,
+// в том числе при исключении
+class Descriptor {
+ public:
+  explicit Descriptor(int fd) : fd(fd) {}
+  ~Descriptor() {
+    if (fd >= 0) close(fd);
+  }
+  Descriptor(const Descriptor&) = delete;
+  Descriptor& operator=(const Descriptor&) = delete;
+  int get() const { return fd; }
+
+ private:
+  int fd;
+};
+
+}  // namespace
+
+SourceBuffer::~SourceBuffer() { release(); }
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+    : mappedBytes(other.mappedBytes),
+      mappedSize(other.mappedSize),
+      mapped(other.mapped),
+      storage(std::move(other.storage)) {
+  other.mappedBytes = nullptr;
+  other.mappedSize = 0;
+  other.mapped = false;
+}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+  if (this != &other) {
+    release();
+    mappedBytes = other.mappedBytes;
+    mappedSize = other.mappedSize;
+    mapped = other.mapped;
+    storage = std::move(other.storage);
+    other.mappedBytes = nullptr;
+    other.mappedSize = 0;
+    other.mapped = false;
+  }
+  return *this;
+}
+
+void SourceBuffer::release() {
+  if (mapped) {
+    munmap(const_cast<char*>(mappedBytes), mappedSize);
+    mappedBytes = nullptr;
+    mappedSize = 0;
+    mapped = false;
+  }
+  storage.clear();
+}
+
+SourceBuffer SourceBuffer::fromFile(const std::string& path) {
+  if (path == "-") {
+    return fromDescriptor(STDIN_FILENO);
+  }
+
+  Descriptor fd(open(path.c_str(), O_RDONLY));
+  if (fd.get() < 0) {
+    throw std::runtime_error("Не удалось открыть файл: " + path);
+  }
+
+  struct stat info;
+  if (fstat(fd.get(), &info) != 0) {
+    throw std::runtime_error("Не удалось получить размер файла: " + path);
+  }
+
+  // Каналы, устройства и пустые файлы отображать нечего
+  if (!S_ISREG(info.st_mode) || info.st_size == 0) {
+    return fromDescriptor(fd.get());
+  }
+
+  // Отображение остаётся действительным и после закрытия дескриптора
+  size_t size = static_cast<size_t>(info.st_size);
+  void* bytes = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (bytes == MAP_FAILED) {
+    throw std::runtime_error("Не удалось отобразить файл в память: " + path);
+  }
+
+  // Лексер читает файл строго от начала к концу
+  madvise(bytes, size, MADV_SEQUENTIAL);
+
+  SourceBuffer buffer;
+  buffer.mappedBytes = static_cast<const char*>(bytes);
+  buffer.mappedSize = size;
+  buffer.mapped = true;
+  return buffer;
+}
+
+SourceBuffer SourceBuffer::fromDescriptor(int fd) {
+  SourceBuffer buffer;
+  std::string& data = buffer.storage;
+  size_t used = 0;
+  data.resize(64 * 1024);
+
+  while (true) {
+    if (used == data.size()) {
+      data.resize(data.size() * 2);
+    }
+
+    ssize_t count = read(fd, &data[used], data.size() - used);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("Ошибка чтения исходного кода");
+    }
+    if (count == 0) break;
+    used += static_cast<size_t>(count);
+  }
+
+  data.resize(used);
+  return buffer;
+}
+
+SourceBuffer SourceBuffer::fromString(std::string text) {
+  SourceBuffer buffer;
+  buffer.storage = std::move(text);
+  return buffer;
+}
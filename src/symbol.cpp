@@ -0,0 +1,159 @@
+#include "symbol.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// FNV-1a: имена короткие, и этого достаточно для хеш-таблицы
+uint64_t hashName(std::string_view text) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : text) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+struct Entry {
+  const char* data;
+  uint32_t size;
+};
+
+// Таблица разбита на сегменты по старшим битам хеша, у каждого своя
+// блокировка, хеш-таблица и память под строки. Номера выдаются общим
+// счётчиком, строка по номеру ищется в двухуровневом массиве блоков:
+// уже выделенные блоки не перемещаются, поэтому str() не блокирует
+class SymbolTable {
+public:
+  SymbolTable() {
+    blocks[0].store(new Entry[kBlockSize], std::memory_order_release);
+    blocks[0].load()[0] = Entry{"", 0};
+  }
+
+  uint32_t intern(std::string_view text) {
+    uint64_t hash = hashName(text);
+    Shard& shard = shards[hash >> (64 - kShardBits)];
+    uint32_t shortHash = static_cast<uint32_t>(hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.slots.empty()) shard.slots.resize(kInitialSlots);
+
+    size_t mask = shard.slots.size() - 1;
+    for (size_t index = shortHash & mask;; index = (index + 1) & mask) {
+      Slot& slot = shard.slots[index];
+      if (slot.id == 0) break;
+      if (slot.hash == shortHash && str(slot.id) == text) return slot.id;
+    }
+
+    uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+    publish(id, Entry{shard.store(text), static_cast<uint32_t>(text.size())});
+    shard.insert(Slot{id, shortHash});
+    return id;
+  }
+
+  std::string_view str(uint32_t id) const {
+    const Entry& entry = blocks[id >> kBlockBits].load(
+        std::memory_order_acquire)[id & (kBlockSize - 1)];
+    return std::string_view(entry.data, entry.size);
+  }
+
+  size_t size() const { return next.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr size_t kShardBits = 4;
+  static constexpr size_t kInitialSlots = 256;
+  static constexpr size_t kBlockBits = 16;
+  static constexpr size_t kBlockSize = size_t{1} << kBlockBits;
+  static constexpr size_t kMaxBlocks = size_t{1} << (32 - kBlockBits);
+  static constexpr size_t kArenaChunk = 64 * 1024;
+
+  struct Slot {
+    uint32_t id = 0;  // 0 - свободная ячейка
+    uint32_t hash = 0;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::vector<Slot> slots;
+    size_t used = 0;
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* free = nullptr;
+    size_t available = 0;
+
+    // Копия строки в памяти сегмента; адрес не меняется до конца программы
+    const char* store(std::string_view text) {
+      if (text.size() > available) {
+        size_t size = std::max(kArenaChunk, text.size());
+        chunks.emplace_back(new char[size]);
+        free = chunks.back().get();
+        available = size;
+      }
+      char* copy = free;
+      std::copy(text.begin(), text.end(), copy);
+      free += text.size();
+      available -= text.size();
+      return copy;
+    }
+
+    void insert(Slot slot) {
+      if ((used + 1) * 2 > slots.size()) {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        used = 0;
+        for (const Slot& entry : old) {
+          if (entry.id != 0) insert(entry);
+        }
+      }
+      size_t mask = slots.size() - 1;
+      size_t index = slot.hash & mask;
+      while (slots[index].id != 0) index = (index + 1) & mask;
+      slots[index] = slot;
+      used++;
+    }
+  };
+
+  void publish(uint32_t id, Entry entry) {
+    std::atomic<Entry*>& block = blocks[id >> kBlockBits];
+    Entry* entries = block.load(std::memory_order_acquire);
+    if (entries == nullptr) {
+      std::lock_guard<std::mutex> lock(blocksMutex);
+      entries = block.load(std::memory_order_acquire);
+      if (entries == nullptr) {
+        entries = new Entry[kBlockSize];
+        block.store(entries, std::memory_order_release);
+      }
+    }
+    entries[id & (kBlockSize - 1)] = entry;
+  }
+
+  Shard shards[size_t{1} << kShardBits];
+  std::atomic<uint32_t> next{1};
+  std::mutex blocksMutex;
+  std::atomic<Entry*> blocks[kMaxBlocks] = {};
+};
+
+// Таблица не уничтожается: имена могут понадобиться
+// деструкторам других статических объектов
+SymbolTable& table() {
+  static SymbolTable* instance = new SymbolTable();
+  return *instance;
+}
+
+}  // namespace
+
+Symbol Symbol::intern(std::string_view text) {
+  if (text.empty()) return Symbol();
+  return Symbol(table().intern(text));
+}
+
+size_t Symbol::tableSize() { return table().size(); }
+
+std::string_view Symbol::str() const { return table().str(value); }
+
+std::ostream& operator<<(std::ostream& out, Symbol symbol) {
+  return out << symbol.str();
+}
@@ -0,0 +1,261 @@
+#include "token_stream.h"
+
+#include <algorithm>
+
+#include "scan.h"
+
+namespace {
+
+// Заменяет элементы [first, last) вектора на [begin, end): общая часть
+// перезаписывается, сдвигается только хвост при разнице длин
+template <typename T, typename Iterator>
+void replaceRange(std::vector<T>& values, size_t first, size_t last,
+                  Iterator begin, Iterator end) {
+  size_t count = static_cast<size_t>(end - begin);
+  size_t common = std::min(count, last - first);
+  std::copy(begin, begin + common, values.begin() + first);
+  if (count > common) {
+    values.insert(values.begin() + last, begin + common, end);
+  } else {
+    values.erase(values.begin() + first + common, values.begin() + last);
+  }
+}
+
+// Разрыв в массиве с разрывом переезжает с from на to: элементы между
+// ними переносятся на другую сторону разрыва длины gapLength
+template <typename T>
+void moveGapIn(std::vector<T>& values, size_t from, size_t to, size_t gapLength) {
+  if (gapLength == 0 || from == to) return;
+  if (to < from) {
+    std::move_backward(values.begin() + to, values.begin() + from,
+                       values.begin() + from + gapLength);
+  } else {
+    std::move(values.begin() + from + gapLength, values.begin() + to + gapLength,
+              values.begin() + from);
+  }
+}
+
+// Смещения физических элементов [begin, end) переводятся между отсчётом
+// от начала и от конца текста длины textSize (перевод сам себе обратен)
+void flipOffsets(std::vector<uint32_t>& values, size_t begin, size_t end,
+                 size_t textSize) {
+  for (size_t i = begin; i < end; i++) {
+    values[i] = static_cast<uint32_t>(textSize) - values[i];
+  }
+}
+
+// Расширение разрыва, которого не хватает на needed элементов: с запасом
+// пропорционально размеру, чтобы перевыделения были редкими
+size_t gapGrowth(size_t needed, size_t gapLength, size_t size) {
+  return needed <= gapLength ? 0 : std::max(needed - gapLength, size / 8 + 16);
+}
+
+}  // namespace
+
+LineIndex::LineIndex(std::string_view source) : textSize(source.size()) {
+  lineStarts.push_back(0);
+
+  size_t pos = 0;
+  while (true) {
+    pos = scan::findLineEnd(source.data(), pos, source.size());
+    if (pos >= source.size()) break;
+    pos++;
+    lineStarts.push_back(static_cast<uint32_t>(pos));
+  }
+}
+
+LineIndex::Location LineIndex::locate(uint32_t offset) const {
+  // Последняя строка, начало которой не правее offset
+  size_t line = 0;
+  size_t high = lineCount();
+  while (line < high) {
+    size_t middle = (line + high) / 2;
+    if (lineStart(middle) <= offset) {
+      line = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return {static_cast<int>(line),
+          static_cast<int>(offset - lineStart(line - 1) + 1)};
+}
+
+void LineIndex::applyEdit(const TextEdit& edit, std::string_view newSource) {
+  size_t inserted = edit.insertedText.size();
+  size_t count = lineCount();
+
+  // Начала строк после '\n' из удалённого участка: [first, last)
+  auto after = [&](size_t from, size_t offset) {
+    size_t high = count;
+    while (from < high) {
+      size_t middle = (from + high) / 2;
+      if (lineStart(middle) <= offset) {
+        from = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return from;
+  };
+  size_t first = after(0, edit.offset);
+  size_t last = after(first, edit.offset + edit.removedLength);
+
+  std::vector<uint32_t> added;
+  for (size_t pos = edit.offset;;) {
+    pos = scan::findLineEnd(newSource.data(), pos, edit.offset + inserted);
+    if (pos >= edit.offset + inserted) break;
+    pos++;
+    added.push_back(static_cast<uint32_t>(pos));
+  }
+
+  // Разрыв переезжает к first и поглощает удалённые начала строк
+  size_t from = gapStart == SIZE_MAX ? count : gapStart;
+  moveGapIn(lineStarts, from, first, gapLength);
+  if (first < from) {
+    flipOffsets(lineStarts, first + gapLength, from + gapLength, textSize);
+  } else {
+    flipOffsets(lineStarts, from, first, textSize);
+  }
+  gapLength += last - first;
+  if (size_t extra = gapGrowth(added.size(), gapLength, count)) {
+    lineStarts.insert(lineStarts.begin() + static_cast<std::ptrdiff_t>(first), extra, 0);
+    gapLength += extra;
+  }
+  std::copy(added.begin(), added.end(), lineStarts.begin() + static_cast<std::ptrdiff_t>(first));
+  gapStart = first + added.size();
+  gapLength -= added.size();
+  // Начала после правки отсчитаны от конца текста и не меняются
+  textSize = newSource.size();
+}
+
+void TokenStream::reserve(size_t count) {
+  types.reserve(count);
+  offsets.reserve(count);
+  lengths.reserve(count);
+  payloads.reserve(count);
+}
+
+void TokenStream::push(TokenType type, uint32_t offset, uint32_t length,
+                       uint32_t payload) {
+  if (gapStart != SIZE_MAX) closeGap();
+  types.push_back(static_cast<uint8_t>(type));
+  offsets.push_back(offset);
+  lengths.push_back(length);
+  payloads.push_back(payload);
+}
+
+void TokenStream::pushError(uint32_t offset, uint32_t length,
+                            const char* message) {
+  push(TokenType::ERROR, offset, length);
+  errors.emplace_back(static_cast<uint32_t>(size() - 1), message);
+}
+
+std::string_view TokenStream::lexeme(size_t index) const {
+  if (type(index) == TokenType::ERROR) {
+    // Ошибки редки, а индексы в errors идут по возрастанию
+    auto it = std::lower_bound(
+        errors.begin(), errors.end(), index,
+        [](const std::pair<uint32_t, const char*>& error, size_t i) {
+          return error.first < i;
+        });
+    if (it != errors.end() && it->first == index) return it->second;
+  }
+  return source.substr(offset(index), length(index));
+}
+
+Token TokenStream::token(size_t index) const {
+  Token result(type(index), lexeme(index), 0, 0, offset(index),
+               symbol(index));
+  result.value = value(index);
+  return result;
+}
+
+Token TokenStream::locatedToken(size_t index) const {
+  Token result = token(index);
+  LineIndex::Location location = lines().locate(offset(index));
+  result.line = location.line;
+  result.column = location.column;
+  return result;
+}
+
+const LineIndex& TokenStream::lines() const {
+  if (!lineIndexBuilt) {
+    lineIndex = LineIndex(source);
+    lineIndexBuilt = true;
+  }
+  return lineIndex;
+}
+
+void TokenStream::moveGap(size_t target) {
+  size_t from = gapStart == SIZE_MAX ? size() : gapStart;
+  moveGapIn(types, from, target, gapLength);
+  moveGapIn(offsets, from, target, gapLength);
+  moveGapIn(lengths, from, target, gapLength);
+  moveGapIn(payloads, from, target, gapLength);
+  // Перенесённые через разрыв смещения меняют точку отсчёта
+  if (target < from) {
+    flipOffsets(offsets, target + gapLength, from + gapLength, source.size());
+  } else {
+    flipOffsets(offsets, from, target, source.size());
+  }
+  gapStart = target;
+}
+
+void TokenStream::closeGap() {
+  size_t count = size();
+  moveGap(count);
+  types.resize(count);
+  offsets.resize(count);
+  lengths.resize(count);
+  payloads.resize(count);
+  gapStart = SIZE_MAX;
+  gapLength = 0;
+}
+
+void TokenStream::splice(size_t first, size_t last,
+                         const TokenStream& replacement, const TextEdit& edit) {
+  // Разрыв переезжает к first и поглощает заменяемые токены
+  size_t count = size();
+  moveGap(first);
+  gapLength += last - first;
+  size_t inserted = replacement.size();
+  if (size_t extra = gapGrowth(inserted, gapLength, count)) {
+    auto at = static_cast<std::ptrdiff_t>(first);
+    types.insert(types.begin() + at, extra, 0);
+    offsets.insert(offsets.begin() + at, extra, 0);
+    lengths.insert(lengths.begin() + at, extra, 0);
+    payloads.insert(payloads.begin() + at, extra, 0);
+    gapLength += extra;
+  }
+  for (size_t i = 0; i < inserted; i++) {
+    types[first + i] = static_cast<uint8_t>(replacement.type(i));
+    offsets[first + i] = replacement.offset(i);
+    lengths[first + i] = replacement.length(i);
+    payloads[first + i] = replacement.payloads[replacement.slot(i)];
+  }
+  gapStart = first + inserted;
+  gapLength -= inserted;
+
+  // Сообщения об ошибках: индексы в заменённом участке берутся из
+  // replacement, после него сдвигаются на разницу числа токенов (ошибок
+  // в потоке единицы, поэтому разрыв для них не нужен)
+  int64_t shift = static_cast<int64_t>(replacement.size()) -
+                  static_cast<int64_t>(last - first);
+  auto byIndex = [](const std::pair<uint32_t, const char*>& error,
+                    size_t index) { return error.first < index; };
+  auto begin = std::lower_bound(errors.begin(), errors.end(), first, byIndex);
+  auto end = std::lower_bound(begin, errors.end(), last, byIndex);
+  for (auto it = end; it != errors.end(); ++it) {
+    it->first = static_cast<uint32_t>(it->first + shift);
+  }
+  std::vector<std::pair<uint32_t, const char*>> added;
+  for (const auto& error : replacement.errors) {
+    added.emplace_back(static_cast<uint32_t>(error.first + first), error.second);
+  }
+  replaceRange(errors, static_cast<size_t>(begin - errors.begin()),
+               static_cast<size_t>(end - errors.begin()), added.begin(),
+               added.end());
+
+  source = replacement.source;
+  if (lineIndexBuilt) lineIndex.applyEdit(edit, source);
+}
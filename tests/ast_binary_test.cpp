@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include "ast_binary.h"
+#include "driver.h"
+#include "hash.h"
+#include "test_programs.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+FlatAst parseFlat(const std::string& source, std::string* printed = nullptr) {
+    auto program = parseProgram(source);
+    if (printed) *printed = dump(*program);
+    return FlatAst::fromProgram(*program);
+}
+
+}  // namespace
+
+TEST(AstBinaryTest, Xxh64MatchesReference) {
+    EXPECT_EQ(xxh64(""), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(xxh64("abc"), 0x44BC2CF5AD770999ULL);
+    EXPECT_EQ(xxh64("abc", 1), 0xBEA9CA8199328908ULL);
+    EXPECT_EQ(xxh64(std::string(100, 'a')), 0x375041E8B1DECFB3ULL);
+
+    std::string bytes;
+    for (int repeat = 0; repeat < 3; repeat++) {
+        for (int i = 0; i < 256; i++) bytes += static_cast<char>(i);
+    }
+    EXPECT_EQ(xxh64(bytes), 0x8E03C838C596036FULL);
+}
+
+TEST(AstBinaryTest, RoundTripPreservesTree) {
+    std::string expected;
+    FlatAst flat = parseFlat(kAllNodes, &expected);
+    std::string file = AstBinary::serialize(flat, kAllNodes);
+
+    ASSERT_TRUE(AstBinary::isBinary(file));
+    AstBinary::Header header = AstBinary::readHeader(file);
+    EXPECT_EQ(header.version, AstBinary::kVersion);
+    EXPECT_TRUE(AstBinary::matchesSource(header, kAllNodes));
+    EXPECT_FALSE(AstBinary::matchesSource(header, std::string(kAllNodes) + " "));
+
+    FlatAst loaded = AstBinary::deserialize(file);
+    EXPECT_EQ(loaded.nodeCount(), flat.nodeCount());
+    EXPECT_EQ(loaded.bytesUsed(), flat.bytesUsed());
+    EXPECT_EQ(dump(*loaded.toProgram()), expected);
+
+    // Раскладка не зависит от адреса: файл читается и со сдвигом,
+    // без выравнивания
+    std::string shifted = "x" + file;
+    EXPECT_EQ(dump(*AstBinary::deserialize(std::string_view(shifted).substr(1)).toProgram()),
+              expected);
+
+    // Повторная запись даёт тот же файл
+    EXPECT_EQ(AstBinary::serialize(loaded, kAllNodes), file);
+}
+
+TEST(AstBinaryTest, RejectsForeignAndDamagedFiles) {
+    FlatAst flat = parseFlat(kAllNodes);
+    std::string file = AstBinary::serialize(flat, kAllNodes);
+
+    EXPECT_THROW(AstBinary::deserialize(kAllNodes), AstBinary::FormatError);
+    EXPECT_THROW(AstBinary::deserialize(file.substr(0, file.size() / 2)), AstBinary::FormatError);
+    EXPECT_THROW(AstBinary::deserialize(file.substr(0, 20)), AstBinary::FormatError);
+
+    std::string otherVersion = file;
+    uint32_t version = AstBinary::kVersion + 1;
+    std::memcpy(&otherVersion[offsetof(AstBinary::Header, version)], &version, sizeof(version));
+    EXPECT_THROW(AstBinary::deserialize(otherVersion), AstBinary::FormatError);
+
+    // Главный класс за пределами дерева
+    std::string badRoot = file;
+    uint32_t root = static_cast<uint32_t>(flat.nodeCount());
+    std::memcpy(&badRoot[offsetof(AstBinary::Header, mainClass)], &root, sizeof(root));
+    EXPECT_THROW(AstBinary::deserialize(badRoot), AstBinary::FormatError);
+
+    // Испорченный номер ребёнка в секции списков: ссылка назад, на корень
+    FlatAst cyclic = flat;
+    ASSERT_FALSE(cyclic.lists.empty());
+    cyclic.lists.front() = 0;
+    EXPECT_THROW(AstBinary::deserialize(AstBinary::serialize(cyclic, kAllNodes)),
+                 AstBinary::FormatError);
+}
+
+// Номера в границах и после родителя, но вид ребёнка не подходит полю:
+// без проверки видов toProgram привёл бы узел к чужому классу
+TEST(AstBinaryTest, RejectsMismatchedChildKinds) {
+    FlatAst flat = parseFlat(kAllNodes);
+    auto rejected = [](const FlatAst& damaged) {
+        std::string file = AstBinary::serialize(damaged, kAllNodes);
+        try {
+            AstBinary::deserialize(file);
+        } catch (const AstBinary::FormatError&) {
+            return true;
+        }
+        return false;
+    };
+    EXPECT_FALSE(rejected(flat));
+
+    // i = 0;  на месте lvalue - литерал правой части
+    FlatAst literalLValue = flat;
+    ASSERT_FALSE(literalLValue.assignStatements.lvalue.empty());
+    literalLValue.assignStatements.lvalue[0] = literalLValue.assignStatements.expression[0];
+    EXPECT_TRUE(rejected(literalLValue));
+
+    // В списке классов - объявление метода класса
+    FlatAst methodAsClass = flat;
+    ASSERT_FALSE(methodAsClass.methods.name.empty());
+    FlatAst::NodeId method = 0;
+    while (methodAsClass.kinds[method] != NodeKind::MethodDeclaration) method++;
+    methodAsClass.lists[methodAsClass.classes.begin] = method;
+    EXPECT_TRUE(rejected(methodAsClass));
+
+    // Элемент типа массива - не простой тип
+    FlatAst arrayOfStatements = flat;
+    ASSERT_FALSE(arrayOfStatements.arrayTypes.elementType.empty());
+    auto statement = static_cast<FlatAst::NodeId>(arrayOfStatements.nodeCount() - 1);
+    while (arrayOfStatements.kinds[statement] != NodeKind::ReturnStatement) statement--;
+    arrayOfStatements.arrayTypes.elementType[0] = statement;
+    EXPECT_TRUE(rejected(arrayOfStatements));
+
+    // Нет обязательного условия у if
+    FlatAst noCondition = flat;
+    ASSERT_FALSE(noCondition.ifStatements.condition.empty());
+    noCondition.ifStatements.condition[0] = FlatAst::kNone;
+    EXPECT_TRUE(rejected(noCondition));
+
+    // Значения перечислений вне диапазона
+    FlatAst badOperator = flat;
+    badOperator.binaryOperations.op[0] = static_cast<BinaryOperator>(200);
+    EXPECT_TRUE(rejected(badOperator));
+    FlatAst badUnary = flat;
+    ASSERT_FALSE(badUnary.unaryOperations.op.empty());
+    badUnary.unaryOperations.op[0] = static_cast<UnaryOperator>(7);
+    EXPECT_TRUE(rejected(badUnary));
+}
+
+TEST(AstBinaryTest, RejectsSharedAndDeepTrees) {
+    auto rejected = [](const FlatAst& damaged, const char* reason) {
+        std::string file = AstBinary::serialize(damaged, "");
+        try {
+            AstBinary::deserialize(file);
+        } catch (const AstBinary::FormatError& e) {
+            EXPECT_NE(std::string(e.what()).find(reason), std::string::npos) << e.what();
+            return true;
+        }
+        return false;
+    };
+
+    // Правый операнд каждой операции - её же левый операнд: граф из 60
+    // узлов, который toProgram развернул бы в 2^60 узлов
+    std::string chain = "1";
+    for (int i = 0; i < 60; i++) chain += " + 1";
+    std::string source = "class Main { public static void main() { System.out.println(" + chain + "); } }";
+    FlatAst shared = parseFlat(source);
+    for (size_t i = 0; i < shared.binaryOperations.op.size(); i++) {
+        shared.binaryOperations.right[i] = shared.binaryOperations.left[i];
+    }
+    EXPECT_TRUE(rejected(shared, "несколько родителей"));
+
+    // Ветка else, на которую никто не ссылается
+    FlatAst orphan = parseFlat(kAllNodes);
+    ASSERT_FALSE(orphan.ifStatements.elseStatement.empty());
+    orphan.ifStatements.elseStatement[0] = FlatAst::kNone;
+    EXPECT_TRUE(rejected(orphan, "узел вне дерева"));
+
+    // Дерево глубже предела; парсер такого не строит, поэтому цепочка
+    // наращивается прямо в арене
+    auto program = parseProgram("class Main { public static void main() { System.out.println(1); } }");
+    auto* print = static_cast<PrintStatement*>(program->mainClass->statements[0]);
+    for (uint32_t i = 0; i < FlatAst::kMaxDepth; i++) {
+        print->expression = program->arena.make<BinaryOperation>(
+            print->expression, BinaryOperator::PLUS, program->arena.make<IntegerLiteral>(1));
+    }
+    EXPECT_TRUE(rejected(FlatAst::fromProgram(*program), "глубина больше"));
+}
+
+TEST(AstBinaryTest, WriteFileAndLoad) {
+    std::string expected;
+    FlatAst flat = parseFlat(kAllNodes, &expected);
+    std::string path = testing::TempDir() + "ast_binary_test_" + std::to_string(getpid()) + ".ast";
+
+    AstBinary::writeFile(path, AstBinary::serialize(flat, kAllNodes));
+    EXPECT_EQ(dump(*AstBinary::load(path).toProgram()), expected);
+    std::remove(path.c_str());
+
+    EXPECT_THROW(AstBinary::writeFile("/nonexistent-dir/file.ast", "x"), std::runtime_error);
+}
+
+// Файл <исходник>.ast, исходник которого изменился, печатается
+// с предупреждением
+TEST(AstBinaryTest, DriverWarnsAboutStaleFile) {
+    std::string sourcePath =
+        testing::TempDir() + "ast_binary_stale_" + std::to_string(getpid()) + ".java";
+    std::string astPath = sourcePath + ".ast";
+    auto writeSource = [&sourcePath](const std::string& text) {
+        FILE* file = std::fopen(sourcePath.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        std::fputs(text.c_str(), file);
+        std::fclose(file);
+    };
+    auto compileAst = [&astPath]() {
+        std::ostringstream out;
+        std::ostringstream err;
+        EXPECT_EQ(CompileDriver(CompileDriver::Options(), nullptr).compile(astPath, out, err), 0);
+        return err.str();
+    };
+
+    writeSource(kAllNodes);
+    AstBinary::writeFile(astPath, AstBinary::serialize(parseFlat(kAllNodes), kAllNodes));
+    EXPECT_EQ(compileAst(), "");
+
+    writeSource(std::string(kAllNodes) + "\n");
+    EXPECT_NE(compileAst().find("построен не по текущему тексту"), std::string::npos);
+
+    std::remove(sourcePath.c_str());
+    EXPECT_EQ(compileAst(), "");
+    std::remove(astPath.c_str());
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <sstream>
+#include "ast_dump.h"
+#include "ast_printer.h"
+#include "lexer.h"
+#include "output_buffer.h"
+#include "parser.h"
+#include "test_programs.h"
+
+namespace {
+
+const char* kProgram = R"(
+    class Main {
+      public static void main() {
+        System.out.println(new A().f(1));
+      }
+    }
+    class A {
+      int[] a;
+      public int f(int n) {
+        if (!(n < 2)) n = 0; else {}
+        return this.a.length - n;
+      }
+    }
+)";
+
+std::string dump(Program& program, AstFormat format) {
+    std::ostringstream out;
+    dumpAst(program, format, out);
+    return out.str();
+}
+
+}  // namespace
+
+TEST(AstDumpTest, ParseFormatName) {
+    AstFormat format = AstFormat::Tree;
+    EXPECT_TRUE(parseAstFormat("json", format));
+    EXPECT_EQ(format, AstFormat::Json);
+    EXPECT_TRUE(parseAstFormat("sexpr", format));
+    EXPECT_EQ(format, AstFormat::Sexpr);
+    EXPECT_TRUE(parseAstFormat("tree", format));
+    EXPECT_EQ(format, AstFormat::Tree);
+    EXPECT_FALSE(parseAstFormat("xml", format));
+}
+
+TEST(AstDumpTest, Json) {
+    auto program = parseProgram(kProgram);
+    EXPECT_EQ(dump(*program, AstFormat::Json),
+              "{\"node\":\"Program\",\"mainClass\":{\"node\":\"MainClass\",\"name\":\"Main\","
+              "\"statements\":[{\"node\":\"PrintStatement\",\"expression\":"
+              "{\"node\":\"MethodInvocation\",\"object\":{\"node\":\"NewObject\",\"name\":\"A\"},"
+              "\"name\":\"f\",\"arguments\":[{\"node\":\"IntegerLiteral\",\"value\":1}]}}]},"
+              "\"classes\":[{\"node\":\"ClassDeclaration\",\"name\":\"A\",\"base\":null,"
+              "\"declarations\":[{\"node\":\"VariableDeclaration\",\"type\":{\"node\":\"ArrayType\","
+              "\"elementType\":{\"node\":\"IntType\"}},\"name\":\"a\"},"
+              "{\"node\":\"MethodDeclaration\",\"returnType\":{\"node\":\"IntType\"},\"name\":\"f\","
+              "\"parameters\":[{\"node\":\"VariableDeclaration\",\"type\":{\"node\":\"IntType\"},"
+              "\"name\":\"n\"}],\"statements\":[{\"node\":\"IfStatement\",\"condition\":"
+              "{\"node\":\"UnaryOperation\",\"op\":\"!\",\"operand\":{\"node\":\"BinaryOperation\","
+              "\"op\":\"<\",\"left\":{\"node\":\"IdentifierExpression\",\"name\":\"n\"},"
+              "\"right\":{\"node\":\"IntegerLiteral\",\"value\":2}}},"
+              "\"then\":{\"node\":\"AssignStatement\",\"lvalue\":{\"node\":\"IdentifierLValue\","
+              "\"name\":\"n\"},\"expression\":{\"node\":\"IntegerLiteral\",\"value\":0}},"
+              "\"else\":{\"node\":\"BlockStatement\",\"statements\":[]}},"
+              "{\"node\":\"ReturnStatement\",\"expression\":{\"node\":\"BinaryOperation\","
+              "\"op\":\"-\",\"left\":{\"node\":\"ArrayLength\",\"array\":{\"node\":\"FieldAccess\","
+              "\"object\":{\"node\":\"ThisExpression\"},\"name\":\"a\"}},"
+              "\"right\":{\"node\":\"IdentifierExpression\",\"name\":\"n\"}}}]}]}]}\n");
+}
+
+TEST(AstDumpTest, Sexpr) {
+    auto program = parseProgram(kProgram);
+    EXPECT_EQ(dump(*program, AstFormat::Sexpr),
+              "(Program (MainClass Main ((PrintStatement (MethodInvocation (NewObject A) f "
+              "((IntegerLiteral 1)))))) ((ClassDeclaration A nil ((VariableDeclaration "
+              "(ArrayType (IntType)) a) (MethodDeclaration (IntType) f ((VariableDeclaration "
+              "(IntType) n)) ((IfStatement (UnaryOperation ! (BinaryOperation < "
+              "(IdentifierExpression n) (IntegerLiteral 2))) (AssignStatement (IdentifierLValue n) "
+              "(IntegerLiteral 0)) (BlockStatement ())) "
+              "(ReturnStatement (BinaryOperation - (ArrayLength (FieldAccess (ThisExpression) a)) "
+              "(IdentifierExpression n)))))))))\n");
+}
+
+TEST(AstDumpTest, TreeMatchesPrinter) {
+    auto program = parseProgram(kProgram);
+    EXPECT_EQ(dump(*program, AstFormat::Tree), dump(*program));
+}
+
+TEST(AstDumpTest, BufferFormatsIntegers) {
+    std::ostringstream out;
+    {
+        OutputBuffer buffer(out);
+        buffer << 0 << ' ' << 42 << ' ' << -7 << ' ' << INT32_MAX << ' ' << INT32_MIN;
+    }
+    EXPECT_EQ(out.str(), "0 42 -7 2147483647 -2147483648");
+}
+
+TEST(AstDumpTest, BufferWritesLargeOutput) {
+    // Отступ длиннее блока пробелов, текст длиннее буфера и переполнение
+    // по одному символу
+    std::ostringstream out;
+    std::string large(OutputBuffer::kCapacity + 10, 'x');
+    {
+        OutputBuffer buffer(out);
+        buffer << Indent{1000} << '|' << large;
+        for (size_t i = 0; i < OutputBuffer::kCapacity; i++) buffer << 'y';
+        buffer.flush();
+        EXPECT_EQ(out.str().size(), 1001 + large.size() + OutputBuffer::kCapacity);
+        buffer << "end";
+    }
+    std::string text = out.str();
+    EXPECT_EQ(text.substr(0, 1001), std::string(1000, ' ') + "|");
+    EXPECT_EQ(text.substr(1001, large.size()), large);
+    EXPECT_EQ(text.substr(text.size() - 4), "yend");
+}
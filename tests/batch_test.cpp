@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "batch.h"
+#include "parallel.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Временный каталог с файлами; удаляется вместе с содержимым
+class TempTree {
+public:
+    explicit TempTree(const std::string& name)
+        : root(testing::TempDir() + "batch_test_" + std::to_string(getpid()) + "_" + name) {
+        mkdir(root.c_str(), 0755);
+    }
+    ~TempTree() {
+        for (auto it = created.rbegin(); it != created.rend(); ++it) std::remove(it->c_str());
+        std::remove(root.c_str());
+    }
+
+    std::string file(const std::string& name, const std::string& text) {
+        std::string path = root + "/" + name;
+        std::ofstream(path) << text;
+        created.push_back(path);
+        return path;
+    }
+
+    std::string directory(const std::string& name) {
+        std::string path = root + "/" + name;
+        mkdir(path.c_str(), 0755);
+        created.push_back(path);
+        return path;
+    }
+
+    std::string link(const std::string& name, const std::string& target) {
+        std::string path = root + "/" + name;
+        EXPECT_EQ(symlink(target.c_str(), path.c_str()), 0);
+        created.push_back(path);
+        return path;
+    }
+
+    const std::string root;
+
+private:
+    std::vector<std::string> created;
+};
+
+std::string program(int index, bool broken) {
+    std::string source =
+        "class Main { public static void main() { System.out.println(" + std::to_string(index) + "); } }\n";
+    for (int i = 0; i < index % 7; i++) {
+        source += "class C" + std::to_string(i) + " { public int f() { return " +
+                  std::string(broken ? "" : "1") + "; } }\n";
+    }
+    return source;
+}
+
+}  // namespace
+
+TEST(BatchTest, WorkStealingRunsEveryTaskOnce) {
+    for (size_t count : {size_t(0), size_t(1), size_t(3), size_t(1000)}) {
+        std::vector<std::atomic<int>> runs(count);
+        runWorkStealing(count, 4, [&](size_t index) {
+            // Неравные задания: первым потокам достаются длинные
+            volatile size_t spin = 0;
+            for (size_t i = 0; i < (count - index) * 10; i++) spin = spin + i;
+            runs[index]++;
+        });
+        for (size_t i = 0; i < count; i++) EXPECT_EQ(runs[i].load(), 1) << i;
+    }
+}
+
+TEST(BatchTest, NeedsBatch) {
+    TempTree tree("needs");
+    std::string file = tree.file("a.java", "");
+    EXPECT_FALSE(BatchCompiler::needsBatch({file}));
+    EXPECT_FALSE(BatchCompiler::needsBatch({"-"}));
+    EXPECT_TRUE(BatchCompiler::needsBatch({file, file}));
+    EXPECT_TRUE(BatchCompiler::needsBatch({tree.root}));
+    EXPECT_TRUE(BatchCompiler::needsBatch({"@list.txt"}));
+}
+
+TEST(BatchTest, ExpandsDirectoriesAndLists) {
+    TempTree tree("expand");
+    tree.directory("src");
+    tree.directory("src/b");
+    std::string second = tree.file("src/b/z.java", "");
+    std::string first = tree.file("src/a.java", "");
+    std::string third = tree.file("src/c.java", "");
+    tree.file("src/notes.txt", "");
+    std::string other = tree.file("other.java", "");
+    std::string list = tree.file("list.txt", "# список\n\n  " + other + "  \n" + tree.root + "/src\n");
+
+    // Внутри каталога - в порядке имён, аргументы и строки списка -
+    // в исходном порядке
+    std::vector<std::string> expected{other, first, second, third, other};
+    EXPECT_EQ(BatchCompiler::expandInputs({"@" + list, other}), expected);
+
+    EXPECT_THROW(BatchCompiler::expandInputs({"@" + tree.root + "/missing.txt"}), std::runtime_error);
+}
+
+TEST(BatchTest, SkipsLinkedDirectories) {
+    TempTree tree("links");
+    tree.directory("src");
+    std::string file = tree.file("src/a.java", "");
+    tree.link("src/loop", tree.root + "/src");
+    std::string linked = tree.link("src/b.java", file);
+
+    std::vector<std::string> expected{file, linked};
+    EXPECT_EQ(BatchCompiler::expandInputs({tree.root + "/src"}), expected);
+}
+
+TEST(BatchTest, DiagnosticsFollowInputOrder) {
+    TempTree tree("order");
+    std::vector<std::string> files;
+    size_t broken = 0;
+    for (int i = 0; i < 40; i++) {
+        bool error = i % 5 == 3 && i % 7 != 0;
+        broken += error;
+        files.push_back(tree.file("f" + std::to_string(i) + ".java", program(i, error)));
+    }
+    files.push_back(tree.root + "/missing.java");
+    files.push_back(tree.file("empty.java", ""));
+
+    std::string expected;
+    for (unsigned jobs : {1u, 4u}) {
+        BatchCompiler::Options options;
+        options.jobs = jobs;
+        std::ostringstream diagnostics;
+        BatchCompiler::Summary summary = BatchCompiler(options).run(files, diagnostics);
+
+        EXPECT_EQ(summary.files, files.size());
+        EXPECT_EQ(summary.failed, broken + 2);
+        EXPECT_GT(summary.tokens, 0u);
+        if (jobs == 1) {
+            expected = diagnostics.str();
+        } else {
+            EXPECT_EQ(diagnostics.str(), expected);
+        }
+    }
+
+    // Сообщения идут по файлам в порядке списка
+    size_t f3 = expected.find(files[3] + ":");
+    size_t f13 = expected.find(files[13] + ":");
+    size_t missing = expected.find(tree.root + "/missing.java:");
+    ASSERT_NE(f3, std::string::npos);
+    ASSERT_NE(f13, std::string::npos);
+    ASSERT_NE(missing, std::string::npos);
+    EXPECT_LT(f3, f13);
+    EXPECT_LT(f13, missing);
+    EXPECT_NE(expected.find("empty.java: Файл пуст"), std::string::npos);
+
+    // Итоги печатаются в три строки
+    BatchCompiler::Summary summary;
+    summary.files = 3;
+    summary.wallSeconds = 0.5;
+    std::ostringstream out;
+    BatchCompiler::printSummary(summary, out);
+    EXPECT_NE(out.str().find("файлов в секунду: 6"), std::string::npos);
+}
@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include "ast_binary.h"
+#include "compile_cache.h"
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include "test_programs.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+// Каталог кэша для одного теста; удаляется вместе с содержимым
+class CacheDirectory {
+public:
+    explicit CacheDirectory(const std::string& name)
+        : path(testing::TempDir() + "compile_cache_test_" + std::to_string(getpid()) + "_" + name) {
+        clear();
+    }
+    ~CacheDirectory() { clear(); }
+
+    size_t entryCount() const {
+        size_t count = 0;
+        forEachFile([&count](const std::string& file) {
+            if (file.size() > 4 && file.compare(file.size() - 4, 4, ".mjc") == 0) count++;
+        });
+        return count;
+    }
+
+    const std::string path;
+
+private:
+    template <typename F>
+    void forEachFile(F f) const {
+        DIR* dir = opendir(path.c_str());
+        if (dir == nullptr) return;
+        while (struct dirent* item = readdir(dir)) {
+            std::string name = item->d_name;
+            if (name != "." && name != "..") f(name);
+        }
+        closedir(dir);
+    }
+
+    void clear() {
+        forEachFile([this](const std::string& file) { std::remove((path + "/" + file).c_str()); });
+        rmdir(path.c_str());
+    }
+};
+
+CompileCache::Entry compile(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    parser.setRecovery(true);
+    auto program = parser.parseProgram();
+
+    CompileCache::Entry entry;
+    entry.tokenCount = parser.tokenCount();
+    entry.diagnostics = parser.diagnostics();
+    if (entry.diagnostics.empty()) {
+        entry.ast = AstBinary::serialize(FlatAst::fromProgram(*program), source);
+    }
+    return entry;
+}
+
+// Промежуток, заметный во времени изменения файлов
+void waitForClock() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+
+}  // namespace
+
+TEST(CompileCacheTest, KeyDependsOnSourceAndOptions) {
+    uint64_t key = CompileCache::makeKey(kCounter, "recovery");
+    EXPECT_EQ(key, CompileCache::makeKey(kCounter, "recovery"));
+    EXPECT_NE(key, CompileCache::makeKey(std::string(kCounter) + " ", "recovery"));
+    EXPECT_NE(key, CompileCache::makeKey(kCounter, ""));
+}
+
+TEST(CompileCacheTest, MissThenHit) {
+    CacheDirectory directory("hit");
+    CompileCache cache(directory.path);
+    uint64_t key = CompileCache::makeKey(kCounter, "");
+
+    CompileCache::Entry entry;
+    EXPECT_FALSE(cache.lookup(key, kCounter, entry));
+
+    CompileCache::Entry compiled = compile(kCounter);
+    cache.store(key, kCounter, compiled);
+    ASSERT_TRUE(cache.lookup(key, kCounter, entry));
+    EXPECT_EQ(entry.tokenCount, compiled.tokenCount);
+    EXPECT_TRUE(entry.diagnostics.empty());
+    EXPECT_EQ(entry.ast, compiled.ast);
+
+    // Счётчики общие для всех экземпляров, открытых на этом каталоге
+    CompileCache::Stats stats = CompileCache(directory.path).stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.stores, 1u);
+    EXPECT_GT(stats.bytes, compiled.ast.size());
+}
+
+TEST(CompileCacheTest, OverwriteKeepsByteCount) {
+    CacheDirectory directory("overwrite");
+    CompileCache cache(directory.path);
+    uint64_t key = CompileCache::makeKey(kCounter, "");
+    CompileCache::Entry compiled = compile(kCounter);
+
+    cache.store(key, kCounter, compiled);
+    uint64_t once = cache.stats().bytes;
+    for (int i = 0; i < 5; i++) cache.store(key, kCounter, compiled);
+
+    CompileCache::Stats stats = cache.stats();
+    EXPECT_EQ(stats.stores, 6u);
+    EXPECT_EQ(stats.bytes, once);
+}
+
+TEST(CompileCacheTest, KeepsDiagnostics) {
+    CacheDirectory directory("diagnostics");
+    CompileCache cache(directory.path);
+    std::string source = "class Main { public static void main() { x = ; } }";
+    uint64_t key = CompileCache::makeKey(source, "");
+
+    CompileCache::Entry compiled = compile(source);
+    ASSERT_FALSE(compiled.diagnostics.empty());
+    cache.store(key, source, compiled);
+
+    CompileCache::Entry entry;
+    ASSERT_TRUE(cache.lookup(key, source, entry));
+    ASSERT_EQ(entry.diagnostics.size(), compiled.diagnostics.size());
+    for (size_t i = 0; i < entry.diagnostics.size(); i++) {
+        EXPECT_EQ(entry.diagnostics[i].line, compiled.diagnostics[i].line);
+        EXPECT_EQ(entry.diagnostics[i].column, compiled.diagnostics[i].column);
+        EXPECT_EQ(entry.diagnostics[i].message, compiled.diagnostics[i].message);
+    }
+    EXPECT_TRUE(entry.ast.empty());
+}
+
+TEST(CompileCacheTest, RejectsForeignAndDamagedEntries) {
+    CacheDirectory directory("damaged");
+    CompileCache cache(directory.path);
+    uint64_t key = CompileCache::makeKey(kCounter, "");
+    cache.store(key, kCounter, compile(kCounter));
+
+    // Запись, построенная по другому тексту (совпадение ключей)
+    CompileCache::Entry entry;
+    EXPECT_FALSE(cache.lookup(key, std::string(kCounter) + " ", entry));
+    EXPECT_EQ(directory.entryCount(), 0u);
+
+    // Дерево в записи построено по другому тексту, чем сама запись
+    std::string other = std::string(kCounter) + "\n";
+    CompileCache::Entry mixed = compile(kCounter);
+    mixed.ast = compile(other).ast;
+    cache.store(key, kCounter, mixed);
+    EXPECT_FALSE(cache.lookup(key, kCounter, entry));
+
+    // Обрезанная запись удаляется
+    std::string path = cache.pathFor(key);
+    FILE* file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("MJCE", file);
+    std::fclose(file);
+    EXPECT_FALSE(cache.lookup(key, kCounter, entry));
+    EXPECT_EQ(directory.entryCount(), 0u);
+}
+
+TEST(CompileCacheTest, EvictsLeastRecentlyUsed) {
+    CacheDirectory directory("evict");
+    std::vector<std::string> sources;
+    std::vector<CompileCache::Entry> entries;
+    for (int i = 0; i < 4; i++) {
+        sources.push_back(std::string(kCounter) + std::string(i, ' '));
+        entries.push_back(compile(sources.back()));
+    }
+
+    // Предел вмещает три записи, после вытеснения остаются две
+    uint64_t entrySize = entries[0].ast.size() + 64;
+    CompileCache cache(directory.path, entrySize * 3);
+    for (int i = 0; i < 3; i++) {
+        cache.store(CompileCache::makeKey(sources[i], ""), sources[i], entries[i]);
+        waitForClock();
+    }
+
+    // Первая запись использована позже второй и третьей
+    CompileCache::Entry entry;
+    ASSERT_TRUE(cache.lookup(CompileCache::makeKey(sources[0], ""), sources[0], entry));
+    waitForClock();
+
+    cache.store(CompileCache::makeKey(sources[3], ""), sources[3], entries[3]);
+    EXPECT_EQ(directory.entryCount(), 2u);
+    EXPECT_TRUE(cache.lookup(CompileCache::makeKey(sources[0], ""), sources[0], entry));
+    EXPECT_TRUE(cache.lookup(CompileCache::makeKey(sources[3], ""), sources[3], entry));
+    EXPECT_FALSE(cache.lookup(CompileCache::makeKey(sources[1], ""), sources[1], entry));
+    EXPECT_FALSE(cache.lookup(CompileCache::makeKey(sources[2], ""), sources[2], entry));
+
+    CompileCache::Stats stats = cache.stats();
+    EXPECT_EQ(stats.evictions, 2u);
+    EXPECT_LE(stats.bytes, entrySize * 3);
+}
+
+TEST(CompileCacheTest, ConcurrentWritersAndReaders) {
+    // Читатели видят либо отсутствие записи, либо запись целиком
+    CacheDirectory directory("concurrent");
+    CompileCache::Entry compiled = compile(kCounter);
+    uint64_t key = CompileCache::makeKey(kCounter, "");
+
+    std::atomic<int> broken{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            CompileCache cache(directory.path);
+            for (int i = 0; i < 50; i++) {
+                CompileCache::Entry entry;
+                if (cache.lookup(key, kCounter, entry) && entry.ast != compiled.ast) broken++;
+                cache.store(key, kCounter, compiled);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    EXPECT_EQ(broken.load(), 0);
+    EXPECT_EQ(directory.entryCount(), 1u);
+    CompileCache::Stats stats = CompileCache(directory.path).stats();
+    EXPECT_EQ(stats.hits + stats.misses, 200u);
+    EXPECT_EQ(stats.stores, 200u);
+}
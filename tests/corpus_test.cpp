@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "corpus.h"
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+
+// Каждая форма корпуса должна разбираться без ошибок, иначе бенчмарки
+// замеряют обработку ошибок, а не разбор
+TEST(CorpusTest, EveryShapeParses) {
+    for (const std::string& shape : corpusShapes()) {
+        SCOPED_TRACE(shape);
+        std::string source = generateCorpus(corpusShape(shape, 64 * 1024));
+        EXPECT_GE(source.size(), 64u * 1024);
+
+        Lexer lexer(source);
+        std::vector<Token> tokens = lexer.tokenize();
+        for (const Token& token : tokens) {
+            ASSERT_NE(token.type, TokenType::ERROR) << token.lexeme;
+        }
+
+        Parser parser(tokens);
+        std::unique_ptr<Program> program;
+        ASSERT_NO_THROW(program = parser.parseProgram());
+        EXPECT_FALSE(program->classes.empty());
+    }
+}
+
+// Программы корпуса должны быть и семантически верными: бенчмарк
+// анализа иначе замеряет сбор ошибок
+TEST(CorpusTest, EveryShapeAnalyzes) {
+    for (const std::string& shape : corpusShapes()) {
+        SCOPED_TRACE(shape);
+        std::string source = generateCorpus(corpusShape(shape, 64 * 1024));
+        Lexer lexer(source);
+        std::vector<Token> tokens = lexer.tokenize();
+        std::unique_ptr<Program> program = Parser(tokens).parseProgram();
+
+        SemanticAnalyzer analyzer;
+        EXPECT_TRUE(analyzer.analyze(*program));
+        for (size_t i = 0; i < analyzer.diagnostics().size() && i < 5; i++) {
+            ADD_FAILURE() << analyzer.diagnostics()[i].message;
+        }
+    }
+}
+
+TEST(CorpusTest, GenerationIsDeterministic) {
+    CorpusOptions options = corpusShape("mixed", 16 * 1024);
+    std::string first = generateCorpus(options);
+    EXPECT_EQ(first, generateCorpus(options));
+
+    options.seed = 2;
+    EXPECT_NE(first, generateCorpus(options));
+}
+
+TEST(CorpusTest, UnknownShapeThrows) {
+    EXPECT_THROW(corpusShape("unknown", 1024), std::runtime_error);
+}
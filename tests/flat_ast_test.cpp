@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "flat_ast.h"
+#include "test_programs.h"
+
+TEST(FlatAstTest, RoundTripPreservesTree) {
+    auto program = parseProgram(kAllNodes);
+    std::string expected = dump(*program);
+
+    FlatAst flat = FlatAst::fromProgram(*program);
+    EXPECT_NO_THROW(flat.validate());
+    EXPECT_EQ(dump(*flat.toProgram()), expected);
+
+    // Существующий посетитель работает через построенное дерево объектов
+    ASTPrinter printer;
+    testing::internal::CaptureStdout();
+    flat.materializeAndAccept(printer);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), expected);
+}
+
+TEST(FlatAstTest, NodesArePreorderAndPoolsAreDense) {
+    auto program = parseProgram(kAllNodes);
+    FlatAst flat = FlatAst::fromProgram(*program);
+
+    // Дети всегда после родителя, каждый узел - ребёнок ровно одного
+    std::vector<int> parents(flat.nodeCount(), 0);
+    std::vector<bool> seen(kNodeKindCount, false);
+    for (FlatAst::NodeId id = 0; id < flat.nodeCount(); id++) {
+        seen[static_cast<size_t>(flat.kind(id))] = true;
+        flat.forEachChild(id, [&](FlatAst::NodeId child) {
+            EXPECT_GT(child, id);
+            parents[child]++;
+        });
+    }
+    EXPECT_EQ(flat.mainClass, 0u);
+    for (const FlatAst::NodeId* it = flat.begin(flat.classes); it != flat.end(flat.classes); ++it) {
+        parents[*it]++;
+    }
+    parents[flat.mainClass]++;
+    for (FlatAst::NodeId id = 0; id < flat.nodeCount(); id++) EXPECT_EQ(parents[id], 1) << id;
+
+    // Встретились все виды, которые строит парсер для правильной программы
+    for (size_t kind = 0; kind < kNodeKindCount; kind++) {
+        switch (static_cast<NodeKind>(kind)) {
+            case NodeKind::Program:
+            case NodeKind::ErrorStatement:
+            case NodeKind::ErrorExpression:
+            case NodeKind::ArrayAccess:
+            case NodeKind::SimpleFieldInvocation:
+            case NodeKind::FieldArrayInvocation:
+            case NodeKind::MethodInvocationStatement:
+                EXPECT_FALSE(seen[kind]) << kind;
+                break;
+            default:
+                EXPECT_TRUE(seen[kind]) << kind;
+        }
+    }
+
+    // Пул одного вида перебирается линейно, в порядке исходного текста
+    EXPECT_EQ(flat.integerLiterals.value,
+              (std::vector<int32_t>{10, 0, 1, 1, 1, 0, 2, 3, 4, 2}));
+    EXPECT_GT(flat.bytesUsed(), 0u);
+}
+
+TEST(FlatAstTest, RoundTripKeepsErrorNodes) {
+    Lexer lexer("class Main { public static void main() { x = ; ) ) ; } }\n"
+                "class A { public int f() { if (x { return 1; } }");
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    parser.setRecovery(true);
+    auto program = parser.parseProgram();
+    ASSERT_FALSE(parser.diagnostics().empty());
+
+    FlatAst flat = FlatAst::fromProgram(*program);
+    EXPECT_NO_THROW(flat.validate());
+    std::string expected = dump(*program);
+    EXPECT_NE(expected.find("<ошибка>"), std::string::npos);
+    EXPECT_EQ(dump(*flat.toProgram()), expected);
+}
+
+// Виды lvalue и вызов метода как оператор парсер пока не строит,
+// поэтому дерево собирается вручную
+TEST(FlatAstTest, RoundTripHandBuiltNodes) {
+    AstArena arena;
+    auto* call = arena.make<MethodInvocation>(arena.make<ThisExpression>(),
+                                              Symbol::intern("f"), AstList<Expression>());
+    Statement** statements = arena.allocateArray<Statement*>(4);
+    statements[0] = arena.make<AssignStatement>(
+        arena.make<ArrayAccess>(Symbol::intern("a"), arena.make<IntegerLiteral>(1)),
+        arena.make<IntegerLiteral>(2));
+    statements[1] = arena.make<AssignStatement>(
+        arena.make<SimpleFieldInvocation>(Symbol::intern("x")), arena.make<ThisExpression>());
+    statements[2] = arena.make<AssignStatement>(
+        arena.make<FieldArrayInvocation>(Symbol::intern("y"),
+                                         arena.make<IdentifierExpression>(Symbol::intern("i"))),
+        arena.make<BooleanLiteral>(true));
+    statements[3] = arena.make<MethodInvocationStatement>(call);
+    auto* mainClass = arena.make<MainClass>(Symbol::intern("Main"),
+                                            AstList<Statement>(statements, 4));
+    Program program(std::move(arena), mainClass, AstList<ClassDeclaration>());
+
+    FlatAst flat = FlatAst::fromProgram(program);
+    EXPECT_EQ(flat.indexedNames.name.size(), 2u);
+    EXPECT_NO_THROW(flat.validate());
+    EXPECT_EQ(dump(*flat.toProgram()), dump(program));
+}
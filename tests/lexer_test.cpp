@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <random>
 #include "lexer.h"
 
 TEST(LexerTest, SimpleClassTokenize) {
@@ -40,4 +41,221 @@ TEST(LexerTest, NegativeNumberTokenize) {
         }
     }
     EXPECT_TRUE(foundNegative) << "Ожидался токен с лексемой -123";
-}
\ No newline at end of file
+}
+TEST(LexerTest, KeywordsTokenize) {
+    std::string sourceCode =
+        "class public static void main extends return if else while new this "
+        "assert int boolean true false System out println length classy";
+
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+
+    std::vector<TokenType> expected = {
+        TokenType::CLASS, TokenType::PUBLIC, TokenType::STATIC,
+        TokenType::VOID_TYPE, TokenType::MAIN, TokenType::EXTENDS,
+        TokenType::RETURN, TokenType::IF, TokenType::ELSE, TokenType::WHILE,
+        TokenType::NEW, TokenType::THIS, TokenType::ASSERT,
+        TokenType::INT_TYPE, TokenType::BOOLEAN_TYPE, TokenType::TRUE,
+        TokenType::FALSE, TokenType::SYSTEM, TokenType::OUT,
+        TokenType::PRINTLN, TokenType::LENGTH, TokenType::IDENTIFIER,
+        TokenType::EOF_TOKEN};
+
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(tokens[i].type, expected[i]) << "Токен " << tokens[i].lexeme;
+    }
+}
+
+TEST(LexerTest, CompactStreamMatchesTokenize) {
+    std::string sourceCode =
+        "class A {\n"
+        "  /* многострочный\n комментарий */ int x;\n"
+        "  // строчный\n"
+        "  public int f() { return x + -1 # 2; }\n"
+        "}";
+
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+
+    Lexer compactLexer(sourceCode);
+    TokenStream stream = compactLexer.tokenizeCompact();
+
+    ASSERT_EQ(stream.size(), tokens.size());
+    for (size_t i = 0; i < tokens.size(); i++) {
+        Token token = stream.locatedToken(i);
+        EXPECT_EQ(token.type, tokens[i].type);
+        EXPECT_EQ(token.lexeme, tokens[i].lexeme);
+        EXPECT_EQ(token.offset, tokens[i].offset);
+        EXPECT_EQ(token.line, tokens[i].line);
+        EXPECT_EQ(token.column, tokens[i].column);
+    }
+}
+
+TEST(LexerTest, MinusContext) {
+    struct Case {
+        std::string source;
+        std::vector<TokenType> types;
+    };
+    std::vector<Case> cases = {
+        {"x -1", {TokenType::IDENTIFIER, TokenType::MINUS, TokenType::INTEGER_LITERAL}},
+        {"(x)-1", {TokenType::LPAREN, TokenType::IDENTIFIER, TokenType::RPAREN,
+                   TokenType::MINUS, TokenType::INTEGER_LITERAL}},
+        {"f(-1)", {TokenType::IDENTIFIER, TokenType::LPAREN,
+                   TokenType::INTEGER_LITERAL, TokenType::RPAREN}},
+        {"a[-2]", {TokenType::IDENTIFIER, TokenType::LBRACKET,
+                   TokenType::INTEGER_LITERAL, TokenType::RBRACKET}},
+        {"return -3", {TokenType::RETURN, TokenType::INTEGER_LITERAL}},
+        {"-4", {TokenType::INTEGER_LITERAL}},
+        {"5 - - 6", {TokenType::INTEGER_LITERAL, TokenType::MINUS, TokenType::MINUS,
+                     TokenType::INTEGER_LITERAL}},
+    };
+
+    for (const Case& c : cases) {
+        Lexer lexer(c.source);
+        std::vector<Token> tokens = lexer.tokenize();
+        ASSERT_EQ(tokens.size(), c.types.size() + 1) << c.source;
+        for (size_t i = 0; i < c.types.size(); i++) {
+            EXPECT_EQ(tokens[i].type, c.types[i]) << c.source << ": " << tokens[i].lexeme;
+        }
+    }
+}
+
+TEST(LexerTest, NonAsciiBytesAreErrors) {
+    std::string sourceCode = "x \xC3\xA9 y";
+
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 5u);
+    EXPECT_EQ(tokens[0].type, TokenType::IDENTIFIER);
+    EXPECT_EQ(tokens[1].type, TokenType::ERROR);
+    EXPECT_EQ(tokens[2].type, TokenType::ERROR);
+    EXPECT_EQ(tokens[3].type, TokenType::IDENTIFIER);
+}
+
+TEST(LexerTest, ParallelMatchesTokenize) {
+    // Фрагменты, на которых граница может оказаться внутри комментария
+    // (в том числе вложенного) или перед отрицательным литералом
+    static const char* fragments[] = {
+        " ", "\n", "\t", "x", "total", "42", "-7", "- 7", ")", "(", "]", "=",
+        "==", "&&", "&", "#", ";", "*", "/", "this",
+        "// строчный комментарий с /* и */\n",
+        "/* блочный */", "/* много\n строк */",
+        "/* внешний /* вложенный */ всё ещё комментарий */",
+        "/*", "*/", "//",
+    };
+    for (unsigned seed = 1; seed <= 30; seed++) {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<size_t> pick(0, std::size(fragments) - 1);
+        std::string sourceCode;
+        for (int i = 0; i < 300; i++) {
+            sourceCode += fragments[pick(rng)];
+        }
+
+        Lexer lexer(sourceCode);
+        std::vector<Token> expected = lexer.tokenize();
+
+        for (unsigned threads : {2u, 3u, 7u, 16u}) {
+            Lexer parallelLexer(sourceCode);
+            std::vector<Token> tokens = parallelLexer.tokenizeParallel(threads, 1);
+
+            ASSERT_EQ(tokens.size(), expected.size()) << "seed " << seed << ", потоков " << threads;
+            for (size_t i = 0; i < tokens.size(); i++) {
+                EXPECT_EQ(tokens[i].type, expected[i].type);
+                EXPECT_EQ(tokens[i].lexeme, expected[i].lexeme);
+                EXPECT_EQ(tokens[i].offset, expected[i].offset);
+                EXPECT_EQ(tokens[i].line, expected[i].line);
+                EXPECT_EQ(tokens[i].column, expected[i].column);
+            }
+        }
+    }
+}
+
+TEST(LexerTest, RelexMatchesFullTokenize) {
+    static const char* pieces[] = {
+        "", " ", "\n", "x", "42", "-", "=", "/*", "*/", "//", "*", "/",
+        "int y;\n", "/* комментарий */", "a -1",
+    };
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> pick(0, std::size(pieces) - 1);
+
+    // Поток ссылается на текст, поэтому правки чередуются между двумя буферами
+    std::string buffers[2];
+    buffers[0] =
+        "class A {\n"
+        "  /* поле /* вложенный */ x */ int x;\n"
+        "  // строчный\n"
+        "  public int f() { return x - -1 # 2; }\n"
+        "}\n";
+    Lexer initial(buffers[0]);
+    TokenStream stream = initial.tokenizeCompact();
+    stream.lines();  // индекс строк должен обновляться вместе с потоком
+
+    for (int step = 0; step < 300; step++) {
+        const std::string& previous = buffers[step % 2];
+        std::string& text = buffers[(step + 1) % 2];
+
+        std::uniform_int_distribution<size_t> position(0, previous.size());
+        size_t offset = position(rng);
+        size_t removed = std::min<size_t>(rng() % 4, previous.size() - offset);
+        std::string piece = pieces[pick(rng)];
+        text = previous;
+        text.replace(offset, removed, piece);
+
+        Lexer lexer(text);
+        lexer.relex(stream, TextEdit{offset, removed, piece});
+
+        Lexer full(text);
+        TokenStream expected = full.tokenizeCompact();
+        ASSERT_EQ(stream.size(), expected.size()) << "шаг " << step;
+        for (size_t i = 0; i < expected.size(); i++) {
+            Token token = stream.locatedToken(i);
+            Token reference = expected.locatedToken(i);
+            ASSERT_EQ(token.type, reference.type) << "шаг " << step << ", токен " << i;
+            ASSERT_EQ(token.lexeme, reference.lexeme);
+            ASSERT_EQ(token.offset, reference.offset);
+            ASSERT_EQ(token.line, reference.line);
+            ASSERT_EQ(token.column, reference.column);
+        }
+    }
+}
+
+TEST(LexerTest, IntegerLiteralValues) {
+    struct Case {
+        std::string source;
+        TokenType type;
+        int32_t value;
+    };
+    std::vector<Case> cases = {
+        {"0", TokenType::INTEGER_LITERAL, 0},
+        {"007", TokenType::INTEGER_LITERAL, 7},
+        {"2147483647", TokenType::INTEGER_LITERAL, 2147483647},
+        {"-2147483648", TokenType::INTEGER_LITERAL, -2147483647 - 1},
+        // Вне диапазона int: ошибка на месте литерала
+        {"2147483648", TokenType::ERROR, 0},
+        {"-2147483649", TokenType::ERROR, 0},
+        {"99999999999999999999999", TokenType::ERROR, 0},
+    };
+
+    for (const Case& c : cases) {
+        Lexer lexer(c.source);
+        std::vector<Token> tokens = lexer.tokenize();
+        ASSERT_EQ(tokens.size(), 2u) << c.source;
+        EXPECT_EQ(tokens[0].type, c.type) << c.source;
+        EXPECT_EQ(tokens[0].value, c.value) << c.source;
+        EXPECT_EQ(tokens[0].offset, 0u);
+
+        Lexer compactLexer(c.source);
+        TokenStream stream = compactLexer.tokenizeCompact();
+        EXPECT_EQ(stream.type(0), c.type) << c.source;
+        EXPECT_EQ(stream.value(0), c.value) << c.source;
+        EXPECT_EQ(stream.length(0), c.source.size());
+    }
+
+    // После операнда минус - бинарный, и 2147483648 без знака - ошибка
+    Lexer lexer("x-2147483648");
+    std::vector<Token> tokens = lexer.tokenize();
+    ASSERT_EQ(tokens.size(), 4u);
+    EXPECT_EQ(tokens[1].type, TokenType::MINUS);
+    EXPECT_EQ(tokens[2].type, TokenType::ERROR);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "parser.h"
 #include "lexer.h"
+#include "ast_printer.h"
+#include "test_programs.h"
 
 TEST(ParserTest, ParseSimpleProgram) {
     std::string sourceCode = R"(
@@ -50,4 +52,476 @@ TEST(ParserTest, ParseFactorialProgram) {
         auto program = parser.parseProgram();
         EXPECT_NE(program, nullptr);
     });
-}
\ No newline at end of file
+}
+
+TEST(ParserTest, StreamingMatchesVector) {
+    std::string sourceCode = R"(
+        class Main {
+          public static void main() {
+            System.out.println(new Counter().run(3));
+          }
+        }
+
+        class Counter {
+          int[] values;
+          public int run(int n) {
+            int i;
+            int sum;
+            i = 0;
+            sum = 0;
+            values = new int[n];
+            while (i < n && !(i == values.length)) {
+              sum = sum + i * 2 % 7;
+              i = i + 1;
+            }
+            return sum;
+          }
+        }
+    )";
+
+    Lexer vectorLexer(sourceCode);
+    std::vector<Token> tokens = vectorLexer.tokenize();
+    Parser vectorParser(tokens);
+    auto expected = vectorParser.parseProgram();
+
+    Lexer streamLexer(sourceCode);
+    Parser streamParser(streamLexer);
+    auto program = streamParser.parseProgram();
+
+    EXPECT_EQ(streamParser.tokenCount(), tokens.size());
+
+    ASTPrinter printer;
+    testing::internal::CaptureStdout();
+    expected->accept(printer);
+    std::string expectedDump = testing::internal::GetCapturedStdout();
+
+    testing::internal::CaptureStdout();
+    program->accept(printer);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), expectedDump);
+}
+
+TEST(ParserTest, CompactStreamReportsLocation) {
+    std::string sourceCode = "class A {\n  public static void main() {\n    int 5;\n  }\n}";
+
+    Lexer lexer(sourceCode);
+    TokenStream stream = lexer.tokenizeCompact();
+    Parser parser(stream);
+
+    testing::internal::CaptureStderr();
+    try {
+        parser.parseProgram();
+        FAIL() << "Ожидалась ошибка разбора";
+    } catch (const Parser::ParseError& e) {
+        EXPECT_NE(std::string(e.what()).find("строке 3, столбец 9"), std::string::npos) << e.what();
+    }
+    testing::internal::GetCapturedStderr();
+}
+
+// Вложенные списки строятся на общем стеке: порядок элементов внешнего
+// списка не должен смешиваться с элементами внутренних
+TEST(ParserTest, NestedListsKeepOrder) {
+    std::string sourceCode = R"(
+        class Main {
+          public static void main() {
+            System.out.println(new A().f(1, this.g(2, 3), 4));
+            { x = 5; { y = 6; } z = 7; }
+          }
+        }
+        class A { int a; public int f(int p, int q, int r) { return p; } int b; }
+    )";
+
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto program = parser.parseProgram();
+    EXPECT_GT(program->arena.bytesReserved(), 0u);
+
+    auto& statements = program->mainClass->statements;
+    ASSERT_EQ(statements.size(), 2u);
+
+    auto* print = dynamic_cast<PrintStatement*>(statements[0]);
+    ASSERT_NE(print, nullptr);
+    auto* call = dynamic_cast<MethodInvocation*>(print->expression);
+    ASSERT_NE(call, nullptr);
+    ASSERT_EQ(call->arguments.size(), 3u);
+    EXPECT_EQ(dynamic_cast<IntegerLiteral*>(call->arguments[0])->value, 1);
+    auto* inner = dynamic_cast<MethodInvocation*>(call->arguments[1]);
+    ASSERT_NE(inner, nullptr);
+    ASSERT_EQ(inner->arguments.size(), 2u);
+    EXPECT_EQ(dynamic_cast<IntegerLiteral*>(inner->arguments[1])->value, 3);
+    EXPECT_EQ(dynamic_cast<IntegerLiteral*>(call->arguments[2])->value, 4);
+
+    auto* block = dynamic_cast<BlockStatement*>(statements[1]);
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(block->statements.size(), 3u);
+    EXPECT_NE(dynamic_cast<BlockStatement*>(block->statements[1]), nullptr);
+    auto* last = dynamic_cast<AssignStatement*>(block->statements[2]);
+    ASSERT_NE(last, nullptr);
+    EXPECT_EQ(dynamic_cast<IdentifierLValue*>(last->lvalue)->name.str(), "z");
+
+    ASSERT_EQ(program->classes.size(), 1u);
+    auto& declarations = program->classes[0]->declarations;
+    ASSERT_EQ(declarations.size(), 3u);
+    EXPECT_EQ(declarations[0]->name.str(), "a");
+    EXPECT_EQ(declarations[1]->name.str(), "f");
+    EXPECT_EQ(declarations[2]->name.str(), "b");
+    auto* method = dynamic_cast<MethodDeclaration*>(declarations[1]);
+    ASSERT_EQ(method->parameters.size(), 3u);
+    EXPECT_EQ(method->parameters[2]->name.str(), "r");
+}
+
+namespace {
+
+// Разбирает выражение из единственного оператора main и печатает его
+// в скобочной записи, чтобы проверять приоритеты и ассоциативность
+std::string parenthesize(Expression* expression) {
+    if (auto* binary = dynamic_cast<BinaryOperation*>(expression)) {
+        static const char* names[] = {"&&", "||", "<", ">", "==", "+", "-",
+                                      "*", "/", "%", "!=", "<=", ">="};
+        return "(" + parenthesize(binary->left) + " " +
+               names[static_cast<int>(binary->op)] + " " +
+               parenthesize(binary->right) + ")";
+    }
+    if (auto* unary = dynamic_cast<UnaryOperation*>(expression)) {
+        return "!" + parenthesize(unary->expression);
+    }
+    if (auto* identifier = dynamic_cast<IdentifierExpression*>(expression)) {
+        return std::string(identifier->name.str());
+    }
+    if (auto* literal = dynamic_cast<IntegerLiteral*>(expression)) {
+        return std::to_string(literal->value);
+    }
+    return "?";
+}
+
+std::string parseAssignedExpression(const std::string& expression) {
+    std::string sourceCode =
+        "class Main { public static void main() { x = " + expression + "; } }";
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    auto program = parser.parseProgram();
+    auto* assign = dynamic_cast<AssignStatement*>(program->mainClass->statements[0]);
+    return parenthesize(assign->expression);
+}
+
+}  // namespace
+
+TEST(ParserTest, BinaryOperatorPrecedence) {
+    EXPECT_EQ(parseAssignedExpression("a + b * c - d"), "((a + (b * c)) - d)");
+    EXPECT_EQ(parseAssignedExpression("a - b - c"), "((a - b) - c)");
+    EXPECT_EQ(parseAssignedExpression("a || b && c == d"), "(a || (b && (c == d)))");
+    EXPECT_EQ(parseAssignedExpression("a < b == c >= d"), "((a < b) == (c >= d))");
+    EXPECT_EQ(parseAssignedExpression("a != b <= c % 2"), "(a != (b <= (c % 2)))");
+    EXPECT_EQ(parseAssignedExpression("!a && !!b"), "(!a && !!b)");
+    EXPECT_EQ(parseAssignedExpression("(a + b) * c"), "((a + b) * c)");
+    EXPECT_EQ(parseAssignedExpression("a > -1"), "(a > -1)");
+}
+
+TEST(ParserTest, DeepNestingIsAParseError) {
+    for (const char* open : {"(", "!", "{"}) {
+        SCOPED_TRACE(open);
+        std::string body;
+        for (int i = 0; i < 100000; i++) body += open;
+        std::string sourceCode = "class Main { public static void main() { " +
+                                 (std::string(open) == "{" ? body : "x = " + body + "a;") +
+                                 " } }";
+
+        Lexer lexer(sourceCode);
+        std::vector<Token> tokens = lexer.tokenize();
+        Parser parser(tokens);
+        testing::internal::CaptureStderr();
+        try {
+            parser.parseProgram();
+            ADD_FAILURE() << "Ожидалась ошибка разбора";
+        } catch (const Parser::ParseError& e) {
+            EXPECT_NE(std::string(e.what()).find("Слишком глубокая вложенность"),
+                      std::string::npos) << e.what();
+        }
+        testing::internal::GetCapturedStderr();
+    }
+
+    // Вложенность в пределах лимита разбирается
+    std::string expression = "a";
+    for (int i = 0; i < 100; i++) expression = "(" + expression + " + 1)";
+    EXPECT_NO_THROW(parseAssignedExpression(expression));
+}
+
+namespace {
+
+std::vector<Parser::Diagnostic> recoverErrors(const std::string& sourceCode,
+                                              std::unique_ptr<Program>* result = nullptr) {
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    parser.setRecovery(true);
+    auto program = parser.parseProgram();
+    EXPECT_NE(program, nullptr);
+    if (result) *result = std::move(program);
+    return parser.diagnostics();
+}
+
+}  // namespace
+
+TEST(ParserTest, RecoveryReportsEveryError) {
+    std::string sourceCode =
+        "class Main {\n"
+        "  public static void main() {\n"
+        "    x = ;\n"
+        "    System.out.println(1);\n"
+        "  }\n"
+        "}\n"
+        "class A {\n"
+        "  int ;\n"
+        "  public int f() {\n"
+        "    y = 1 + ;\n"
+        "    return 2 3;\n"
+        "  }\n"
+        "  public int g() { return 1; }\n"
+        "}\n"
+        "class B { public int h() { z = 5 } }\n";
+
+    std::unique_ptr<Program> program;
+    auto diagnostics = recoverErrors(sourceCode, &program);
+    ASSERT_EQ(diagnostics.size(), 5u);
+    std::vector<int> lines;
+    for (const auto& diagnostic : diagnostics) lines.push_back(diagnostic.line);
+    EXPECT_EQ(lines, (std::vector<int>{3, 8, 10, 11, 15}));
+    EXPECT_NE(diagnostics[0].message.find("Ожидалось выражение"), std::string::npos);
+
+    // Разбор продолжился после каждой ошибки, на их месте - узлы ошибок
+    ASSERT_EQ(program->mainClass->statements.size(), 2u);
+    auto* assign = dynamic_cast<AssignStatement*>(program->mainClass->statements[0]);
+    ASSERT_NE(assign, nullptr);
+    EXPECT_NE(dynamic_cast<ErrorExpression*>(assign->expression), nullptr);
+    EXPECT_NE(dynamic_cast<PrintStatement*>(program->mainClass->statements[1]), nullptr);
+
+    ASSERT_EQ(program->classes.size(), 2u);
+    auto& declarations = program->classes[0]->declarations;
+    ASSERT_EQ(declarations.size(), 3u);
+    EXPECT_EQ(declarations[2]->name.str(), "g");
+    EXPECT_EQ(program->classes[1]->className.str(), "B");
+
+    // Дерево с узлами ошибок обходится как обычное
+    ASTPrinter printer;
+    testing::internal::CaptureStdout();
+    program->accept(printer);
+    EXPECT_NE(testing::internal::GetCapturedStdout().find("<ошибка>"), std::string::npos);
+}
+
+TEST(ParserTest, RecoveryStopsMissingBraceAtNextMethod) {
+    auto diagnostics = recoverErrors(
+        "class Main { public static void main() { } }\n"
+        "class A {\n"
+        "  public int f() { x = 1;\n"
+        "  public int g() { return 1; }\n"
+        "}\n"
+        "class B { }\n");
+    ASSERT_EQ(diagnostics.size(), 1u);
+    EXPECT_EQ(diagnostics[0].line, 4);
+    EXPECT_NE(diagnostics[0].message.find("Ожидалась '}'"), std::string::npos);
+
+    // Мусор вместо оператора пропускается, разбор не зацикливается
+    diagnostics = recoverErrors(
+        "class Main { public static void main() { ) ) ; else x = 1; } }");
+    ASSERT_EQ(diagnostics.size(), 2u);
+    EXPECT_NE(diagnostics[0].message.find("Ожидался оператор"), std::string::npos);
+}
+
+TEST(ParserTest, RecoveryOnValidProgramMatchesStrictParse) {
+    std::string sourceCode = R"(
+        class Main {
+          public static void main() {
+            System.out.println(new Counter().run(3));
+          }
+        }
+        class Counter extends Base {
+          int[] values;
+          public int run(int n, boolean flag) {
+            int i;
+            i = 0;
+            values = new int[n];
+            while (i <= n && !(i != values.length)) {
+              if (flag) { i = i + 1; } else i = i * 2 % 7;
+            }
+            assert(i >= 0);
+            return this.run(i - 1, false);
+          }
+        }
+    )";
+    Lexer strictLexer(sourceCode);
+    std::vector<Token> tokens = strictLexer.tokenize();
+    auto expected = Parser(tokens).parseProgram();
+
+    std::unique_ptr<Program> program;
+    EXPECT_TRUE(recoverErrors(sourceCode, &program).empty());
+
+    ASTPrinter printer;
+    testing::internal::CaptureStdout();
+    expected->accept(printer);
+    std::string expectedDump = testing::internal::GetCapturedStdout();
+    testing::internal::CaptureStdout();
+    program->accept(printer);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), expectedDump);
+}
+
+TEST(ParserTest, RecoveryLimitsDiagnostics) {
+    std::string body;
+    for (int i = 0; i < 1000; i++) body += "x = ;\n";
+    auto diagnostics = recoverErrors(
+        "class Main { public static void main() {\n" + body + "} }");
+    ASSERT_EQ(diagnostics.size(), 101u);
+    EXPECT_NE(diagnostics.back().message.find("Слишком много ошибок"), std::string::npos);
+}
+
+TEST(ParserTest, DeepNestingIsReportedOnce) {
+    // Разбор, вернувшийся после ошибки внутрь той же конструкции, снова
+    // упирается в предел, но сообщение одно на тело метода
+    auto repeat = [](const std::string& text, int count) {
+        std::string result;
+        for (int i = 0; i < count; i++) result += text;
+        return result;
+    };
+    std::vector<std::string> bodies{
+        repeat("{", 1000) + repeat("}", 1000),
+        "x = " + repeat("(", 1000) + "1" + repeat(")", 1000) + ";",
+        "x = " + repeat("!", 1000) + "true;",
+        repeat("if (true) ", 1000) + "x = 1;",
+        repeat("while (true) { ", 1000) + repeat("}", 1000),
+    };
+    for (const std::string& body : bodies) {
+        SCOPED_TRACE(body.substr(0, 20));
+        auto diagnostics = recoverErrors("class Main { public static void main() { " + body +
+                                         " y = 2; } }");
+        ASSERT_EQ(diagnostics.size(), 1u);
+        EXPECT_NE(diagnostics[0].message.find("Слишком глубокая вложенность"), std::string::npos)
+            << diagnostics[0].message;
+    }
+
+    // В каждом методе - своё сообщение
+    std::string nested = repeat("{", 300) + repeat("}", 300);
+    auto diagnostics = recoverErrors(
+        "class Main { public static void main() { " + nested + " } }\n"
+        "class A { public int f() { " + nested + " return 0; } "
+        "public int g() { " + nested + " return 0; } }");
+    EXPECT_EQ(diagnostics.size(), 3u);
+}
+
+TEST(ParserTest, LongChainsAreLimited) {
+    // Цепочки строятся циклом, а не рекурсией, но глубина дерева
+    // ограничена: её обходы рекурсивны
+    auto chain = [](const std::string& first, const std::string& step, int count) {
+        std::string expression = first;
+        for (int i = 1; i < count; i++) expression += step;
+        return expression;
+    };
+    auto errorsIn = [](const std::string& expression) {
+        return recoverErrors("class Main { public static void main() { x = " + expression +
+                             "; y = 1; } }");
+    };
+
+    EXPECT_TRUE(errorsIn(chain("1", " + 1", 9000)).empty());
+    EXPECT_TRUE(errorsIn(chain("a", ".f()", 9000)).empty());
+
+    // Одна ошибка на цепочку, какой бы длинной она ни была
+    for (const std::string& expression :
+         {chain("1", " + 1", 300000), chain("a", ".f()", 300000), chain("a", "[0]", 300000),
+          "(" + chain("1", " * 1", 6000) + ")" + chain("", " + 1", 6000)}) {
+        auto diagnostics = errorsIn(expression);
+        ASSERT_EQ(diagnostics.size(), 1u);
+        EXPECT_NE(diagnostics[0].message.find("Слишком глубокая вложенность"), std::string::npos)
+            << diagnostics[0].message;
+    }
+}
+
+namespace {
+
+// Программа из count классов; errorEvery > 0 - каждый errorEvery-й класс
+// содержит ошибки, в том числе незакрытую '{' и мусор между классами
+std::string generateClasses(int count, int errorEvery = 0) {
+    std::string source =
+        "class Main { public static void main() { System.out.println(1); } }\n";
+    for (int i = 0; i < count; i++) {
+        std::string name = "C" + std::to_string(i);
+        bool broken = errorEvery > 0 && i % errorEvery == 0;
+        source += "class " + name + " extends Base {\n"
+                  "  int[] values;\n"
+                  "  public int run(int n) {\n"
+                  "    int i;\n"
+                  "    i = 0;\n"
+                  "    while (i < n && !(i == values.length)) { i = i + " +
+                  std::to_string(i) + " * 2; }\n";
+        if (broken) source += i % (errorEvery * 2) == 0 ? "    x = ;\n" : "    if (i {\n";
+        source += "    return new " + name + "().run(i - 1);\n"
+                  "  }\n"
+                  "}\n";
+        if (broken && i % 3 == 0) source += "} ;\n";
+    }
+    return source;
+}
+
+}  // namespace
+
+TEST(ParserTest, ParallelMatchesSequential) {
+    std::string sourceCode = generateClasses(500);
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+    auto expected = Parser(tokens).parseProgram();
+
+    Parser parser(tokens);
+    auto program = parser.parseProgramParallel(4);
+    ASSERT_EQ(program->classes.size(), 500u);
+    EXPECT_EQ(program->classes[499]->className.str(), "C499");
+    EXPECT_EQ(dump(*program), dump(*expected));
+}
+
+TEST(ParserTest, ParallelRecoveryMatchesSequential) {
+    std::string sourceCode = generateClasses(500, 37);
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+
+    Parser sequential(tokens);
+    sequential.setRecovery(true);
+    auto expected = sequential.parseProgram();
+
+    Parser parallel(tokens);
+    parallel.setRecovery(true);
+    auto program = parallel.parseProgramParallel(4);
+
+    ASSERT_FALSE(sequential.diagnostics().empty());
+    ASSERT_EQ(parallel.diagnostics().size(), sequential.diagnostics().size());
+    for (size_t i = 0; i < sequential.diagnostics().size(); i++) {
+        EXPECT_EQ(parallel.diagnostics()[i].message, sequential.diagnostics()[i].message);
+    }
+    EXPECT_EQ(dump(*program), dump(*expected));
+
+    // Без восстановления бросается первая ошибка по тексту
+    std::string expectedError;
+    testing::internal::CaptureStderr();
+    try {
+        Parser(tokens).parseProgram();
+    } catch (const Parser::ParseError& e) {
+        expectedError = e.what();
+    }
+    try {
+        Parser(tokens).parseProgramParallel(4);
+        ADD_FAILURE() << "ожидалась ParseError";
+    } catch (const Parser::ParseError& e) {
+        EXPECT_EQ(std::string(e.what()), expectedError);
+    }
+    testing::internal::GetCapturedStderr();
+}
+
+TEST(ParserTest, ParallelLimitsDiagnostics) {
+    std::string sourceCode = generateClasses(600, 1);
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+
+    Parser parser(tokens);
+    parser.setRecovery(true);
+    parser.parseProgramParallel(3);
+    ASSERT_EQ(parser.diagnostics().size(), 101u);
+    EXPECT_EQ(parser.diagnostics().back().message, "Слишком много ошибок, разбор остановлен");
+    auto expected = recoverErrors(sourceCode);
+    EXPECT_EQ(parser.diagnostics()[99].message, expected[99].message);
+}
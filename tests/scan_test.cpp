@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "lexer.h"
+#include "scan.h"
+
+namespace {
+
+// Случайный текст из фрагментов, на которых ядра меняют поведение:
+// пробелы разной длины, переводы строк, комментарии, длинные имена
+std::string randomSource(unsigned seed, size_t pieces) {
+    static const char* fragments[] = {
+        " ", "    ", "\t", "\n", "\r\n", "                                  ",
+        "x", "value_", "aVeryLongIdentifierName_WithDigits_0123456789_and_more",
+        "class", "int", "42", "-7", "(", ")", "{", "}", ";", "=", "==", "<=",
+        "// line comment with * and / inside\n",
+        "/* block */", "/* multi\n line\n comment */",
+        "/* outer /* nested */ still comment **/", "*", "/", "&&", "||",
+    };
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, std::size(fragments) - 1);
+
+    std::string text;
+    for (size_t i = 0; i < pieces; i++) {
+        text += fragments[pick(rng)];
+    }
+    return text;
+}
+
+std::vector<Token> tokenizeWith(scan::Backend backend, const std::string& text) {
+    EXPECT_TRUE(scan::setBackend(backend));
+    Lexer lexer(text);
+    std::vector<Token> tokens = lexer.tokenize();
+    scan::setBackend(scan::bestBackend());
+    return tokens;
+}
+
+}  // namespace
+
+TEST(ScanTest, KernelsStopAtFirstMismatch) {
+    std::string text = std::string(40, ' ') + "\n\n  abc_DEF_123456789012345678901234567890+";
+
+    size_t pos = scan::skipWhitespace(text.data(), 0, text.size());
+    EXPECT_EQ(pos, 44u);
+    EXPECT_EQ(scan::skipIdentifierChars(text.data(), pos, text.size()), text.size() - 1);
+
+    std::string comment = std::string(50, 'c') + "\n" + std::string(20, 'c') + "*/";
+    EXPECT_EQ(scan::findLineEnd(comment.data(), 0, comment.size()), 50u);
+    EXPECT_EQ(scan::findCommentDelimiter(comment.data(), 0, comment.size()), 71u);
+}
+
+TEST(ScanTest, AdvanceLinesCountsNewlines) {
+    std::string text;
+    for (int i = 0; i < 100; i++) {
+        text += std::string(i % 37, 'x') + "\n";
+    }
+
+    scan::LineCursor lines;
+    scan::advanceLines(text.data(), 10, lines);
+    scan::advanceLines(text.data(), text.size() - 3, lines);
+    EXPECT_EQ(lines.line, 100u);
+    EXPECT_EQ(lines.lineStart, text.size() - 1 - (99 % 37));
+    EXPECT_EQ(lines.position, text.size() - 3);
+}
+
+TEST(ScanTest, BackendsProduceSameTokens) {
+    for (unsigned seed = 1; seed <= 20; seed++) {
+        std::string text = randomSource(seed, 400);
+        std::vector<Token> expected = tokenizeWith(scan::Backend::Scalar, text);
+
+        for (scan::Backend backend : {scan::Backend::SSE2, scan::Backend::AVX2}) {
+            if (!scan::setBackend(backend)) continue;
+
+            std::vector<Token> tokens = tokenizeWith(backend, text);
+            ASSERT_EQ(tokens.size(), expected.size()) << scan::backendName(backend);
+            for (size_t i = 0; i < tokens.size(); i++) {
+                EXPECT_EQ(tokens[i].type, expected[i].type);
+                EXPECT_EQ(tokens[i].lexeme, expected[i].lexeme);
+                EXPECT_EQ(tokens[i].line, expected[i].line);
+                EXPECT_EQ(tokens[i].column, expected[i].column);
+            }
+        }
+    }
+}
@@ -0,0 +1,329 @@
+#include <gtest/gtest.h>
+#include "lexer.h"
+#include "parser.h"
+#include "semantic.h"
+
+namespace {
+
+std::unique_ptr<Program> parse(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens);
+    std::unique_ptr<Program> program = parser.parseProgram();
+    EXPECT_TRUE(parser.diagnostics().empty());
+    return program;
+}
+
+// Сообщения анализа программы из главного класса и классов classes
+std::vector<std::string> errorsOf(const std::string& classes,
+                                  const std::string& main = "System.out.println(1);") {
+    auto program = parse("class Main { public static void main() { " + main + " } }\n" + classes);
+    SemanticAnalyzer analyzer;
+    analyzer.analyze(*program);
+    std::vector<std::string> messages;
+    for (const SemanticAnalyzer::Diagnostic& diagnostic : analyzer.diagnostics()) {
+        messages.push_back(diagnostic.message);
+    }
+    return messages;
+}
+
+// Ровно одна ошибка, и её текст содержит expected
+void expectError(const std::string& classes, const std::string& expected,
+                 const std::string& main = "System.out.println(1);") {
+    std::vector<std::string> messages = errorsOf(classes, main);
+    ASSERT_EQ(messages.size(), 1u) << classes;
+    EXPECT_NE(messages[0].find(expected), std::string::npos) << messages[0];
+}
+
+const char* kValid = R"(
+    class Main {
+      public static void main() {
+        System.out.println(new Tree().init(10));
+      }
+    }
+    class Base {
+      int size;
+      public Base self() { return this; }
+      public int grow(int by) { size = size + by; return size; }
+    }
+    class Tree extends Base {
+      int[] values;
+      Tree left;
+      public int init(int n) {
+        int i;
+        boolean done;
+        i = 0;
+        values = new int[n];
+        done = i < values.length && !(this.values.length == 0);
+        while (!done) {
+          if (i < n) { int step; step = 1; i = i + step; } else done = true;
+        }
+        left = this;
+        if (left == this.null_tree()) i = 0;
+        return this.grow(values[0]) + i;
+      }
+      public Tree self() { return this; }
+      public Tree null_tree() { return left; }
+    }
+)";
+
+template <typename Node>
+Node* statement(MethodDeclaration* method, size_t index) {
+    return static_cast<Node*>(method->statements[index]);
+}
+
+}  // namespace
+
+TEST(SemanticTest, ValidProgramHasNoErrors) {
+    auto program = parse(kValid);
+    SemanticAnalyzer analyzer;
+    EXPECT_TRUE(analyzer.analyze(*program));
+    for (const SemanticAnalyzer::Diagnostic& diagnostic : analyzer.diagnostics()) {
+        ADD_FAILURE() << diagnostic.message;
+    }
+    EXPECT_EQ(analyzer.classes().size(), 3u);
+}
+
+TEST(SemanticTest, AnnotatesTree) {
+    auto program = parse(kValid);
+    SemanticAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.analyze(*program));
+
+    ClassDeclaration* base = program->classes[0];
+    ClassDeclaration* tree = program->classes[1];
+    EXPECT_EQ(base->baseClass, nullptr);
+    EXPECT_EQ(tree->baseClass, base);
+
+    auto* size = static_cast<VariableDeclaration*>(base->declarations[0]);
+    auto* grow = static_cast<MethodDeclaration*>(base->declarations[2]);
+    auto* values = static_cast<VariableDeclaration*>(tree->declarations[0]);
+    auto* left = static_cast<VariableDeclaration*>(tree->declarations[1]);
+    auto* init = static_cast<MethodDeclaration*>(tree->declarations[2]);
+    EXPECT_EQ(size->scope, VariableScope::Field);
+    EXPECT_EQ(grow->parameters[0]->scope, VariableScope::Parameter);
+    EXPECT_EQ(static_cast<IdentifierType*>(left->type)->declaration, tree);
+
+    // int i;  i = 0;
+    auto* i = statement<LocalVarDeclStatement>(init, 0)->declaration;
+    EXPECT_EQ(i->scope, VariableScope::Local);
+    auto* assignI = statement<AssignStatement>(init, 2);
+    EXPECT_EQ(static_cast<IdentifierLValue*>(assignI->lvalue)->declaration, i);
+    EXPECT_EQ(assignI->expression->type, ValueType::of(ValueType::Kind::Int));
+
+    // values = new int[n];
+    auto* assignValues = statement<AssignStatement>(init, 3);
+    EXPECT_EQ(static_cast<IdentifierLValue*>(assignValues->lvalue)->declaration, values);
+    ValueType intArray = ValueType::of(ValueType::Kind::Int);
+    intArray.array = true;
+    EXPECT_EQ(assignValues->expression->type, intArray);
+
+    // done = i < values.length && !(this.values.length == 0);
+    auto* condition = static_cast<BinaryOperation*>(statement<AssignStatement>(init, 4)->expression);
+    EXPECT_EQ(condition->type, ValueType::of(ValueType::Kind::Boolean));
+    EXPECT_EQ(static_cast<BinaryOperation*>(condition->left)->left->type,
+              ValueType::of(ValueType::Kind::Int));
+
+    // left = this;  тип this - Tree
+    auto* assignLeft = statement<AssignStatement>(init, 6);
+    EXPECT_EQ(static_cast<IdentifierLValue*>(assignLeft->lvalue)->declaration, left);
+    EXPECT_EQ(assignLeft->expression->type, ValueType::ofClass(Symbol::intern("Tree")));
+
+    // return this.grow(values[0]) + i;  grow унаследован от Base
+    auto* result = static_cast<BinaryOperation*>(statement<ReturnStatement>(init, 8)->expression);
+    auto* call = static_cast<MethodInvocation*>(result->left);
+    EXPECT_EQ(call->declaration, grow);
+    EXPECT_EQ(static_cast<IdentifierExpression*>(result->right)->declaration, i);
+
+    auto* print = static_cast<PrintStatement*>(program->mainClass->statements[0]);
+    auto* newTree = static_cast<NewObject*>(static_cast<MethodInvocation*>(print->expression)->object);
+    EXPECT_EQ(newTree->declaration, tree);
+}
+
+TEST(SemanticTest, UnknownNames) {
+    expectError("class A { public int f() { return x; } }", "Неизвестная переменная x");
+    expectError("class A { B b; }", "Неизвестный класс B");
+    expectError("class A { public int f() { return this.g(); } }", "нет метода g");
+    expectError("class A { public int f() { return this.n; } }", "нет поля n");
+    expectError("class A extends B { }", "Неизвестный базовый класс B");
+    expectError("", "Неизвестный класс A", "System.out.println(new A().f());");
+}
+
+TEST(SemanticTest, TypeMismatches) {
+    expectError("class A { public int f() { int x; x = true; return x; } }",
+                "Нельзя присвоить значение типа boolean переменной типа int");
+    expectError("class A { public int f() { return 1 + true; } }",
+                "Операнд оператора +: ожидался тип int, получен boolean");
+    expectError("class A { public boolean f() { return !1; } }", "Операнд оператора !");
+    expectError("class A { public int f() { if (1) return 1; return 0; } }", "Условие if");
+    expectError("class A { public int f() { while (0) { } return 0; } }", "Условие while");
+    expectError("class A { public int f() { assert(2); return 0; } }", "Условие assert");
+    expectError("", "Аргумент System.out.println", "System.out.println(true);");
+    expectError("class A { public boolean f() { return 1 == true; } }", "Нельзя сравнить int и boolean");
+    expectError("class A { public boolean f() { return 1; } }", "возвращает boolean, а не int");
+    expectError("class A { public int f() { int x; return x[0]; } }", "Индексируется не массив");
+    expectError("class A { public int f() { int x; return x.length; } }", "length есть только у массивов");
+    expectError("class A { public int f() { int[] a; return a[true]; } }", "Индекс массива");
+    expectError("class A { public int f() { int x; return x.g(); } }", "Метод g вызывается у значения типа int");
+}
+
+TEST(SemanticTest, Subtyping) {
+    EXPECT_TRUE(errorsOf("class A { public A f() { B b; b = new B(); return b; } }"
+                         "class B extends A { }").empty());
+    expectError("class A { public B f() { return new A(); } }"
+                "class B extends A { }",
+                "возвращает B, а не A");
+}
+
+TEST(SemanticTest, Calls) {
+    expectError("class A { public int f(int x) { return this.f(1, 2); } }",
+                "ожидает 1 аргумент(ов), передано 2");
+    expectError("class A { public int f(int x) { return this.f(true); } }",
+                "Аргумент 1 метода f: ожидался int, получен boolean");
+}
+
+TEST(SemanticTest, Declarations) {
+    expectError("class A { } class A { }", "Класс A уже объявлен");
+    expectError("class A { int x; boolean x; }", "Поле x уже объявлено");
+    expectError("class A { public int f() { return 0; } public int f() { return 1; } }",
+                "Метод уже объявлен");
+    expectError("class A { public int f(int x) { int x; return x; } }", "Повторное объявление переменной x");
+    expectError("class A { public int f(int x, int x) { return x; } }", "Повторное объявление параметра x");
+    expectError("class A { void x; }", "Тип void допустим только как тип результата метода");
+
+    // Ветки и блоки - отдельные области видимости
+    EXPECT_TRUE(errorsOf("class A { public int f() { if (true) { int y; y = 1; } else { int y; y = 2; }"
+                         " while (false) { int y; y = 3; } return 0; } }").empty());
+    expectError("class A { public int f() { { int y; } return y; } }", "Неизвестная переменная y");
+}
+
+TEST(SemanticTest, Inheritance) {
+    std::vector<std::string> messages = errorsOf("class A extends B { } class B extends A { }");
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_NE(messages[0].find("Циклическое наследование"), std::string::npos);
+
+    expectError("class A { public int f(int x) { return x; } }"
+                "class B extends A { public int f(boolean x) { return 0; } }",
+                "Сигнатура отличается от метода f класса A");
+    EXPECT_TRUE(errorsOf("class A { public A f() { return this; } }"
+                         "class B extends A { public B f() { return this; } }").empty());
+
+    // Поля закрыты и в наследниках
+    expectError("class A { int x; } class B extends A { public int f() { return x; } }",
+                "Поле x класса A закрыто");
+    expectError("class A { int x; } class B { public int f(A a) { return a.x; } }",
+                "Поле x класса A закрыто");
+}
+
+TEST(SemanticTest, MainIsStatic) {
+    expectError("class A { public int f() { return 0; } }", "this недоступен в статическом методе main",
+                "System.out.println(this.f());");
+    expectError("class A { }", "не возвращает значения", "return 1;");
+}
+
+TEST(SemanticTest, CollectsAllErrorsWithContext) {
+    auto program = parse(R"(
+        class Main { public static void main() { System.out.println(true); } }
+        class A {
+          B field;
+          public int f() { return x; }
+          public int g() { return this.h(); }
+        }
+    )");
+    SemanticAnalyzer analyzer;
+    EXPECT_FALSE(analyzer.analyze(*program));
+    const std::vector<SemanticAnalyzer::Diagnostic>& errors = analyzer.diagnostics();
+    ASSERT_EQ(errors.size(), 4u);
+    EXPECT_EQ(errors[0].className, Symbol::intern("A"));
+    EXPECT_TRUE(errors[0].methodName.empty());
+    EXPECT_EQ(errors[1].className, Symbol::intern("Main"));
+    EXPECT_EQ(errors[1].methodName, Symbol::intern("main"));
+    EXPECT_EQ(errors[2].methodName, Symbol::intern("f"));
+    EXPECT_EQ(errors[2].message, "Ошибка в классе A, метод f: Неизвестная переменная x");
+    EXPECT_EQ(errors[3].methodName, Symbol::intern("g"));
+
+    // Повторный анализ начинает с чистых таблиц
+    auto valid = parse(kValid);
+    EXPECT_TRUE(analyzer.analyze(*valid));
+    EXPECT_TRUE(analyzer.diagnostics().empty());
+}
+
+TEST(SemanticTest, UnknownTypesDoNotCascade) {
+    // Одна ошибка в объявлении - ни одной в выражениях с этой переменной
+    std::vector<std::string> messages =
+        errorsOf("class A { public int f() { C c; int x; x = c.g() + c.h; return x; } }");
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_NE(messages[0].find("Неизвестный класс C"), std::string::npos);
+}
+
+namespace {
+
+// Ошибки метода "public int f() { return <operand>; }", операнд которого
+// наращивается слева n сложениями с 1 (и ещё одним с true, если
+// addTrue). Такую цепочку строит не парсер - он ограничивает глубину
+// выражения, - а тест прямо в арене
+std::vector<std::string> chainErrors(const std::string& operand, int n, bool addTrue = false) {
+    auto program = parse("class Main { public static void main() { System.out.println(1); } }\n"
+                         "class A { public int f() { return " + operand + "; } }");
+    auto* method = static_cast<MethodDeclaration*>(program->classes[0]->declarations[0]);
+    auto* result = statement<ReturnStatement>(method, 0);
+    for (int i = 0; i < n; i++) {
+        result->expression = program->arena.make<BinaryOperation>(
+            result->expression, BinaryOperator::PLUS, program->arena.make<IntegerLiteral>(1));
+    }
+    if (addTrue) {
+        result->expression = program->arena.make<BinaryOperation>(
+            result->expression, BinaryOperator::PLUS, program->arena.make<BooleanLiteral>(true));
+    }
+    SemanticAnalyzer analyzer;
+    analyzer.analyze(*program);
+    std::vector<std::string> messages;
+    for (const SemanticAnalyzer::Diagnostic& diagnostic : analyzer.diagnostics()) {
+        messages.push_back(diagnostic.message);
+    }
+    return messages;
+}
+
+}  // namespace
+
+TEST(SemanticTest, LongOperatorChains) {
+    // Левое поддерево из 100 000 операций проверяется без рекурсии
+    EXPECT_TRUE(chainErrors("1", 100000).empty());
+    for (const auto& messages : {chainErrors("1", 100000, true), chainErrors("true", 100000)}) {
+        ASSERT_EQ(messages.size(), 1u);
+        EXPECT_NE(messages[0].find("Операнд оператора +: ожидался тип int, получен boolean"),
+                  std::string::npos) << messages[0];
+    }
+
+    std::string negations(200, '!');
+    EXPECT_TRUE(errorsOf("class A { public boolean f() { return " + negations + "true; } }").empty());
+    expectError("class A { public boolean f() { return " + negations + "1; } }", "Операнд оператора !");
+}
+
+TEST(SemanticTest, SymbolMap) {
+    SymbolMap<int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(Symbol::intern("a")), nullptr);
+
+    std::vector<Symbol> keys;
+    for (int i = 0; i < 100; i++) keys.push_back(Symbol::intern("key" + std::to_string(i)));
+    for (int i = 0; i < 100; i++) EXPECT_TRUE(map.insert(keys[i], i).second);
+    EXPECT_EQ(map.size(), 100u);
+
+    auto repeated = map.insert(keys[7], 1000);
+    EXPECT_FALSE(repeated.second);
+    EXPECT_EQ(*repeated.first, 7);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_NE(map.find(keys[i]), nullptr);
+        EXPECT_EQ(*map.find(keys[i]), i);
+    }
+    EXPECT_EQ(map.find(Symbol::intern("missing")), nullptr);
+    EXPECT_FALSE(map.insert(Symbol(), 1).second);
+
+    int sum = 0;
+    map.forEach([&](Symbol, int value) { sum += value; });
+    EXPECT_EQ(sum, 99 * 100 / 2);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(keys[0]), nullptr);
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include "driver.h"
+#include "server.h"
+#include "source_buffer.h"
+#include "test_programs.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+std::string socketPath(const std::string& name) {
+    return testing::TempDir() + "server_test_" + std::to_string(getpid()) + "_" + name + ".sock";
+}
+
+// Сервер в отдельном потоке на время теста
+class RunningServer {
+public:
+    explicit RunningServer(const std::string& name, double idleSeconds = 0) {
+        CompileServer::Options options;
+        options.socketPath = socketPath(name);
+        options.threads = 4;
+        options.idleSeconds = idleSeconds;
+        server = std::make_unique<CompileServer>(options);
+        server->listen();
+        thread = std::thread([this] { server->run(); });
+        path = options.socketPath;
+    }
+    ~RunningServer() {
+        server->stop();
+        thread.join();
+    }
+
+    std::unique_ptr<CompileServer> server;
+    std::thread thread;
+    std::string path;
+};
+
+struct Result {
+    int status;
+    std::string out;
+    std::string err;
+};
+
+Result viaServer(const std::string& socket, const CompileServer::Request& request) {
+    std::ostringstream out, err;
+    int status = CompileServer::send(socket, request, out, err);
+    return Result{status, out.str(), err.str()};
+}
+
+Result inProcess(const std::string& source) {
+    std::ostringstream out, err;
+    SourceBuffer buffer = SourceBuffer::fromString(source);
+    int status = CompileDriver(CompileDriver::Options(), nullptr).compile("-", buffer, out, err);
+    return Result{status, out.str(), err.str()};
+}
+
+CompileServer::Request inlineRequest(const std::string& source) {
+    CompileServer::Request request;
+    request.path = "-";
+    request.inlineSource = true;
+    request.source = source;
+    return request;
+}
+
+}  // namespace
+
+TEST(ServerTest, CompilesLikeDriver) {
+    RunningServer running("compile");
+
+    Result expected = inProcess(kCounter);
+    Result actual = viaServer(running.path, inlineRequest(kCounter));
+    EXPECT_EQ(actual.status, 0);
+    EXPECT_EQ(actual.out, expected.out);
+    EXPECT_EQ(actual.err, "");
+
+    // Файл читает сервер
+    std::string file = testing::TempDir() + "server_test_" + std::to_string(getpid()) + ".java";
+    std::ofstream(file) << kCounter;
+    CompileServer::Request request;
+    request.path = file;
+    EXPECT_EQ(viaServer(running.path, request).out, expected.out);
+    std::remove(file.c_str());
+
+    // Ошибки разбора и код завершения
+    std::string broken = "class Main { public static void main() { x = ; } }";
+    Result failed = viaServer(running.path, inlineRequest(broken));
+    EXPECT_EQ(failed.status, 1);
+    EXPECT_EQ(failed.err, inProcess(broken).err);
+    EXPECT_EQ(failed.out, "");
+
+    // Вывод больше одного кадра
+    std::string large = kCounter;
+    for (int i = 0; i < 2000; i++) {
+        large += "class C" + std::to_string(i) + " { public int f(int a) { return a + 1; } }\n";
+    }
+    Result big = viaServer(running.path, inlineRequest(large));
+    EXPECT_GT(big.out.size(), 128u * 1024);
+    EXPECT_EQ(big.out, inProcess(large).out);
+}
+
+TEST(ServerTest, ConcurrentClients) {
+    RunningServer running("concurrent");
+    std::string expected = inProcess(kCounter).out;
+
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> clients;
+    for (int t = 0; t < 8; t++) {
+        clients.emplace_back([&] {
+            for (int i = 0; i < 10; i++) {
+                Result result = viaServer(running.path, inlineRequest(kCounter));
+                if (result.status != 0 || result.out != expected) mismatches++;
+            }
+        });
+    }
+    for (std::thread& client : clients) client.join();
+    EXPECT_EQ(mismatches.load(), 0);
+
+    CompileServer::Request stats;
+    stats.type = CompileServer::RequestType::Stats;
+    EXPECT_NE(viaServer(running.path, stats).out.find("Запросов: 80"), std::string::npos);
+}
+
+TEST(ServerTest, SocketOwnerOnlyAndSourceLimit) {
+    RunningServer running("limits");
+
+    struct stat info;
+    ASSERT_EQ(stat(running.path.c_str(), &info), 0);
+    EXPECT_EQ(info.st_mode & 0777, 0600u);
+
+    // Слишком большой текст не отправляется, сервер продолжает работать
+    std::string huge(CompileServer::kMaxSourceLength + 1, ' ');
+    EXPECT_THROW(viaServer(running.path, inlineRequest(huge)), std::runtime_error);
+    EXPECT_EQ(viaServer(running.path, inlineRequest(kCounter)).status, 0);
+}
+
+TEST(ServerTest, ShutdownRequestAndSecondServer) {
+    std::string path = socketPath("shutdown");
+    CompileServer::Options options;
+    options.socketPath = path;
+    options.threads = 2;
+    options.idleSeconds = 0;
+    CompileServer server(options);
+    server.listen();
+    std::thread thread([&server] { server.run(); });
+
+    // Сокет занят живым сервером
+    CompileServer second(options);
+    EXPECT_THROW(second.listen(), std::runtime_error);
+
+    CompileServer::Request request;
+    request.type = CompileServer::RequestType::Shutdown;
+    EXPECT_EQ(viaServer(path, request).status, 0);
+    thread.join();
+    EXPECT_THROW(viaServer(path, inlineRequest(kCounter)), std::runtime_error);
+}
+
+TEST(ServerTest, StopsWhenIdle) {
+    std::string path = socketPath("idle");
+    CompileServer::Options options;
+    options.socketPath = path;
+    options.threads = 2;
+    options.idleSeconds = 0.3;
+    CompileServer server(options);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread thread([&server] { server.run(); });
+    thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(seconds, 0.3);
+    EXPECT_LT(seconds, 5.0);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include "source_buffer.h"
+#include "lexer.h"
+
+TEST(SourceBufferTest, MapsRegularFile) {
+    std::string path = ::testing::TempDir() + "source_buffer_test.java";
+    std::string sourceCode = "class A { public static void main() { } }";
+    {
+        std::ofstream file(path);
+        file << sourceCode;
+    }
+
+    SourceBuffer buffer = SourceBuffer::fromFile(path);
+    EXPECT_TRUE(buffer.isMapped());
+    EXPECT_EQ(buffer.text(), sourceCode);
+
+    // Лексемы указывают прямо в отображённый файл
+    Lexer lexer(buffer);
+    std::vector<Token> tokens = lexer.tokenize();
+    ASSERT_GE(tokens.size(), 2u);
+    EXPECT_EQ(tokens[1].lexeme, "A");
+    EXPECT_EQ(tokens[1].lexeme.data(), buffer.data() + 6);
+
+    std::remove(path.c_str());
+}
+
+TEST(SourceBufferTest, ReadsPipe) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::string sourceCode = "int x = -123;";
+    ASSERT_EQ(write(fds[1], sourceCode.data(), sourceCode.size()),
+              static_cast<ssize_t>(sourceCode.size()));
+    close(fds[1]);
+
+    SourceBuffer buffer = SourceBuffer::fromDescriptor(fds[0]);
+    close(fds[0]);
+
+    EXPECT_FALSE(buffer.isMapped());
+    EXPECT_EQ(buffer.text(), sourceCode);
+}
+
+TEST(SourceBufferTest, MissingFileThrows) {
+    EXPECT_THROW(SourceBuffer::fromFile("/nonexistent/file.java"), std::runtime_error);
+}
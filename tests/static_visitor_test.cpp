@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <typeinfo>
+#include "static_visitor.h"
+#include "test_programs.h"
+
+namespace {
+
+// Проверяет, что тег каждого узла соответствует его классу: dispatch
+// приводит узел к классу по тегу, typeid даёт настоящий класс
+class KindCheck : public AstWalker<KindCheck> {
+public:
+    size_t nodes = 0;
+
+    template <typename Node>
+    void visit(Node& node) {
+        EXPECT_EQ(typeid(node), typeid(Node));
+        nodes++;
+        walkChildren(node);
+    }
+};
+
+// Считает узлы через виртуальную двойную диспетчеризацию
+class VirtualCounter : public Visitor {
+public:
+    size_t nodes = 0;
+    size_t calls = 0;
+
+    void walk(ASTNode* node) { if (node) node->accept(*this); }
+    template <typename Node>
+    void walk(const AstList<Node>& nodes) { for (Node* node : nodes) walk(node); }
+
+    void visit(Program& node) override { nodes++; walk(node.mainClass); walk(node.classes); }
+    void visit(MainClass& node) override { nodes++; walk(node.statements); }
+    void visit(ClassDeclaration& node) override { nodes++; walk(node.declarations); }
+    void visit(IntType&) override { nodes++; }
+    void visit(BooleanType&) override { nodes++; }
+    void visit(VoidType&) override { nodes++; }
+    void visit(IdentifierType&) override { nodes++; }
+    void visit(ArrayType& node) override { nodes++; walk(node.elementType); }
+    void visit(VariableDeclaration& node) override { nodes++; walk(node.type); }
+    void visit(MethodDeclaration& node) override {
+        nodes++;
+        walk(node.returnType);
+        walk(node.parameters);
+        walk(node.statements);
+    }
+    void visit(AssertStatement& node) override { nodes++; walk(node.condition); }
+    void visit(LocalVarDeclStatement& node) override { nodes++; walk(node.declaration); }
+    void visit(BlockStatement& node) override { nodes++; walk(node.statements); }
+    void visit(IfStatement& node) override {
+        nodes++;
+        walk(node.condition);
+        walk(node.thenStatement);
+        walk(node.elseStatement);
+    }
+    void visit(WhileStatement& node) override { nodes++; walk(node.condition); walk(node.body); }
+    void visit(PrintStatement& node) override { nodes++; walk(node.expression); }
+    void visit(AssignStatement& node) override { nodes++; walk(node.lvalue); walk(node.expression); }
+    void visit(ReturnStatement& node) override { nodes++; walk(node.expression); }
+    void visit(MethodInvocationStatement& node) override { nodes++; walk(node.invocation); }
+    void visit(ErrorStatement&) override { nodes++; }
+    void visit(BinaryOperation& node) override { nodes++; walk(node.left); walk(node.right); }
+    void visit(UnaryOperation& node) override { nodes++; walk(node.expression); }
+    void visit(ArrayIndexing& node) override { nodes++; walk(node.array); walk(node.index); }
+    void visit(ArrayLength& node) override { nodes++; walk(node.array); }
+    void visit(MethodInvocation& node) override {
+        nodes++;
+        calls++;
+        walk(node.object);
+        walk(node.arguments);
+    }
+    void visit(FieldAccess& node) override { nodes++; walk(node.object); }
+    void visit(NewArray& node) override { nodes++; walk(node.elementType); walk(node.size); }
+    void visit(NewObject&) override { nodes++; }
+    void visit(IntegerLiteral&) override { nodes++; }
+    void visit(BooleanLiteral&) override { nodes++; }
+    void visit(ThisExpression&) override { nodes++; }
+    void visit(IdentifierExpression&) override { nodes++; }
+    void visit(ErrorExpression&) override { nodes++; }
+    void visit(IdentifierLValue&) override { nodes++; }
+    void visit(ArrayAccess& node) override { nodes++; walk(node.index); }
+    void visit(SimpleFieldInvocation&) override { nodes++; }
+    void visit(FieldArrayInvocation& node) override { nodes++; walk(node.index); }
+};
+
+// Переопределяет только вызовы метода; остальное обходит AstWalker
+class CallCounter : public AstWalker<CallCounter> {
+public:
+    using AstWalker<CallCounter>::visit;
+    size_t calls = 0;
+
+    void visit(MethodInvocation& node) {
+        calls++;
+        walkChildren(node);
+    }
+};
+
+// Вычисляет целочисленное выражение из литералов: visit возвращает значение
+class Evaluator : public StaticVisitor<Evaluator, int32_t> {
+public:
+    int32_t visit(IntegerLiteral& node) { return node.value; }
+    int32_t visit(BinaryOperation& node) {
+        int32_t left = dispatch(*node.left);
+        int32_t right = dispatch(*node.right);
+        switch (node.op) {
+            case BinaryOperator::PLUS: return left + right;
+            case BinaryOperator::MINUS: return left - right;
+            case BinaryOperator::MULTIPLY: return left * right;
+            default: return 0;
+        }
+    }
+    template <typename Node>
+    int32_t visit(Node&) { return -1; }
+};
+
+}  // namespace
+
+TEST(StaticVisitorTest, KindsMatchClasses) {
+    auto program = parseProgram(kAllNodes);
+    KindCheck check;
+    check.dispatch(*program);
+
+    VirtualCounter counter;
+    program->accept(counter);
+    EXPECT_EQ(check.nodes, counter.nodes);
+    EXPECT_GT(check.nodes, 80u);
+}
+
+TEST(StaticVisitorTest, KindsOfDirectlyBuiltNodes) {
+    AstArena arena;
+    IntType* type = arena.make<IntType>();
+    EXPECT_EQ(type->kind, NodeKind::IntType);
+    EXPECT_EQ(arena.make<ArrayType>(type)->kind, NodeKind::ArrayType);
+    EXPECT_EQ(arena.make<VariableDeclaration>(type, Symbol::intern("x"))->kind,
+              NodeKind::VariableDeclaration);
+    EXPECT_EQ(arena.make<ArrayIndexing>(arena.make<ThisExpression>())->kind, NodeKind::ArrayIndexing);
+    EXPECT_EQ(arena.make<FieldArrayInvocation>(Symbol::intern("f"), nullptr)->kind,
+              NodeKind::FieldArrayInvocation);
+}
+
+TEST(StaticVisitorTest, WalkerVisitsOverriddenNodes) {
+    auto program = parseProgram(kAllNodes);
+    CallCounter counter;
+    counter.dispatch(*program);
+
+    VirtualCounter expected;
+    program->accept(expected);
+    EXPECT_EQ(counter.calls, expected.calls);
+    EXPECT_EQ(counter.calls, 2u);
+}
+
+TEST(StaticVisitorTest, ReturnsValues) {
+    auto program = parseProgram(R"(
+        class Main {
+          public static void main() {
+            System.out.println(2 + 3 * 4 - 5);
+            System.out.println(this);
+          }
+        }
+    )");
+    auto* first = static_cast<PrintStatement*>(program->mainClass->statements[0]);
+    auto* second = static_cast<PrintStatement*>(program->mainClass->statements[1]);
+    Evaluator evaluator;
+    EXPECT_EQ(evaluator.dispatch(*first->expression), 9);
+    EXPECT_EQ(evaluator.dispatch(*second->expression), -1);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <sstream>
+#include <thread>
+#include "lexer.h"
+#include "parser.h"
+#include "symbol.h"
+
+TEST(SymbolTest, InternReturnsSameSymbol) {
+    std::string first = "counter";
+    std::string second = std::string("count") + "er";
+
+    Symbol a = Symbol::intern(first);
+    Symbol b = Symbol::intern(second);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, Symbol::intern("counters"));
+    EXPECT_EQ(a.str(), "counter");
+    EXPECT_LT(a.id(), Symbol::tableSize());
+
+    // Таблица хранит свою копию строки
+    first.assign("xxxxxxx");
+    EXPECT_EQ(a.str(), "counter");
+
+    std::ostringstream out;
+    out << a;
+    EXPECT_EQ(out.str(), "counter");
+}
+
+TEST(SymbolTest, EmptySymbolIsEmptyString) {
+    EXPECT_TRUE(Symbol().empty());
+    EXPECT_EQ(Symbol::intern(""), Symbol());
+    EXPECT_EQ(Symbol().str(), "");
+    EXPECT_FALSE(Symbol::intern("x").empty());
+}
+
+TEST(SymbolTest, ConcurrentInternGivesDenseIds) {
+    size_t before = Symbol::tableSize();
+    constexpr int kThreads = 4;
+    constexpr int kNames = 5000;
+
+    // Все потоки интернируют одни и те же имена в разном порядке
+    std::vector<std::vector<Symbol>> results(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([t, &results] {
+            results[t].resize(kNames);
+            for (int i = 0; i < kNames; i++) {
+                int name = t % 2 == 0 ? i : kNames - 1 - i;
+                results[t][name] = Symbol::intern("concurrent_" + std::to_string(name));
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    std::set<uint32_t> ids;
+    for (int i = 0; i < kNames; i++) {
+        for (int t = 1; t < kThreads; t++) {
+            EXPECT_EQ(results[t][i], results[0][i]);
+        }
+        EXPECT_EQ(results[0][i].str(), "concurrent_" + std::to_string(i));
+        ids.insert(results[0][i].id());
+    }
+    EXPECT_EQ(ids.size(), static_cast<size_t>(kNames));
+    EXPECT_EQ(Symbol::tableSize(), before + kNames);
+    EXPECT_GE(*ids.begin(), before);
+}
+
+TEST(SymbolTest, LexerAndParserUseSymbols) {
+    std::string sourceCode = R"(
+        class Main {
+          public static void main() {
+            System.out.println(new Counter().next(value));
+          }
+        }
+        class Counter extends Base {
+          int value;
+          public int next(int value) { return value + 1; }
+        }
+    )";
+
+    Lexer lexer(sourceCode);
+    std::vector<Token> tokens = lexer.tokenize();
+    for (const Token& token : tokens) {
+        if (token.type == TokenType::IDENTIFIER) {
+            EXPECT_EQ(token.symbol, Symbol::intern(token.lexeme));
+        } else {
+            EXPECT_TRUE(token.symbol.empty());
+        }
+    }
+
+    Lexer compactLexer(sourceCode);
+    TokenStream stream = compactLexer.tokenizeCompact();
+    for (size_t i = 0; i < stream.size(); i++) {
+        EXPECT_EQ(stream.symbol(i), tokens[i].symbol);
+    }
+
+    Parser parser(tokens);
+    auto program = parser.parseProgram();
+    ASSERT_EQ(program->classes.size(), 1u);
+    const ClassDeclaration& counter = *program->classes[0];
+    EXPECT_EQ(counter.className, Symbol::intern("Counter"));
+    EXPECT_EQ(counter.baseClassName, Symbol::intern("Base"));
+    ASSERT_EQ(counter.declarations.size(), 2u);
+    EXPECT_EQ(counter.declarations[0]->name, Symbol::intern("value"));
+    EXPECT_EQ(counter.declarations[1]->name, Symbol::intern("next"));
+    EXPECT_EQ(program->mainClass->className, Symbol::intern("Main"));
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include "ast_printer.h"
+#include "lexer.h"
+#include "parser.h"
+
+// Общие программы и помощники тестов. Заголовок подключают только
+// файлы tests/*.cpp, каждый из которых - отдельный исполняемый файл
+
+// Программа со всеми видами узлов, которые строит парсер для
+// синтаксически верного текста. Только для разбора: семантический
+// анализ она не проходит (класса Base и поля size нет)
+inline constexpr char kAllNodes[] = R"(
+    class Main {
+      public static void main() {
+        System.out.println(new Tree().init(10));
+      }
+    }
+    class Tree extends Base {
+      int[] values;
+      boolean ready;
+      Tree left;
+      public int init(int n, boolean flag) {
+        int i;
+        int[] copy;
+        i = 0;
+        values = new int[n + 1];
+        copy = values;
+        ready = true;
+        while (i < n && !(i == values.length)) {
+          if (flag) { i = i + 1; } else i = i - 1;
+        }
+        if (i >= 0) ready = false;
+        assert(this.left.size != 2 * 3 % 4);
+        left = new Tree();
+        i = left.init(i, false);
+        return values[i] / 2;
+      }
+      public void reset() { ready = false; }
+    }
+)";
+
+// Небольшая правильная программа, которая проходит все фазы компиляции
+inline constexpr char kCounter[] = R"(
+    class Main {
+      public static void main() {
+        System.out.println(new Counter().run(3));
+      }
+    }
+    class Counter {
+      public int run(int n) {
+        return n * 2;
+      }
+    }
+)";
+
+// Разбор без восстановления после ошибок
+inline std::unique_ptr<Program> parseProgram(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    return Parser(tokens).parseProgram();
+}
+
+// Вывод ASTPrinter для дерева
+inline std::string dump(Program& program) {
+    ASTPrinter printer;
+    testing::internal::CaptureStdout();
+    program.accept(printer);
+    return testing::internal::GetCapturedStdout();
+}